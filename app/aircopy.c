@@ -22,6 +22,7 @@
 #include "frequencies.h"
 #include "misc.h"
 #include "radio.h"
+#include "settings.h"
 #include "ui/helper.h"
 #include "ui/inputbox.h"
 #include "ui/ui.h"
@@ -81,11 +82,14 @@ void AIRCOPY_StorePacket(void)
 			uint16_t Offset = g_FSK_Buffer[1];
 			if (Offset < 0x1E00) {
 				const uint16_t *pData = &g_FSK_Buffer[2];
+				EEPROM_BeginBatch();
 				for (i = 0; i < 8; i++) {
 					EEPROM_WriteBuffer(Offset, pData);
 					pData += 4;
 					Offset += 8;
 				}
+				EEPROM_EndBatch();
+				SETTINGS_InvalidateChannelCache();
 				if (Offset == 0x1E00) {
 					gAircopyState = AIRCOPY_COMPLETE;
 				}
@@ -33,6 +33,9 @@
 #include "main.h"
 #include "menu.h"
 #include "scanner.h"
+#if defined(ENABLE_UART_CAT) && defined(ENABLE_SPECTRUM)
+#include "spectrum.h"
+#endif
 #if defined(ENABLE_UART)
 #include "uart.h"
 #endif
@@ -49,6 +52,7 @@
 #include "driver/keyboard.h"
 #include "driver/st7565.h"
 #include "driver/system.h"
+#include "driver/systick.h"
 #include "dtmf.h"
 #include "external/printf/printf.h"
 #include "frequencies.h"
@@ -170,7 +174,7 @@ static void APP_HandleReceive(void) {
   }
   switch (gCurrentCodeType) {
   case CODE_TYPE_CONTINUOUS_TONE:
-    if (gFoundCTCSS && gFoundCTCSSCountdown == 0) {
+    if (gFoundCTCSS && !SCHEDULER_IsArmed(&gFoundCTCSSTimer)) {
       gFoundCTCSS = false;
       gFoundCDCSS = false;
       Mode = END_OF_RX_MODE_END;
@@ -179,7 +183,7 @@ static void APP_HandleReceive(void) {
     break;
   case CODE_TYPE_DIGITAL:
   case CODE_TYPE_REVERSE_DIGITAL:
-    if (gFoundCDCSS && gFoundCDCSSCountdown == 0) {
+    if (gFoundCDCSS && !SCHEDULER_IsArmed(&gFoundCDCSSTimer)) {
       gFoundCTCSS = false;
       gFoundCDCSS = false;
       Mode = END_OF_RX_MODE_END;
@@ -207,7 +211,7 @@ static void APP_HandleReceive(void) {
           gFoundCTCSS = false;
         } else if (!gFoundCTCSS) {
           gFoundCTCSS = true;
-          gFoundCTCSSCountdown = 100;
+          SCHEDULER_Arm(&gFoundCTCSSTimer, 100);
         }
         if (g_CxCSS_TAIL_Found) {
           Mode = END_OF_RX_MODE_TTE;
@@ -221,7 +225,7 @@ static void APP_HandleReceive(void) {
           gFoundCDCSS = false;
         } else if (!gFoundCDCSS) {
           gFoundCDCSS = true;
-          gFoundCDCSSCountdown = 100;
+          SCHEDULER_Arm(&gFoundCDCSSTimer, 100);
         }
         if (g_CxCSS_TAIL_Found) {
           if (BK4819_GetCTCType() == 1) {
@@ -269,8 +273,8 @@ Skip:
   case END_OF_RX_MODE_TTE:
     if (gEeprom.TAIL_NOTE_ELIMINATION) {
       GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-      gTailNoteEliminationCountdown = 20;
       gFlagTteComplete = false;
+      SCHEDULER_Arm(&gTailNoteEliminationTimer, 20);
       gEnableSpeaker = false;
       gEndOfRxDetectedMaybe = true;
     }
@@ -335,6 +339,9 @@ void APP_StartListening(FUNCTION_Type_t Function, const bool resetAmFix) {
     }
 
     bScanKeepFrequency = true;
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+    RADIO_CompleteScanChannel();
+#endif
   }
 
   if (gCssScanMode != CSS_SCAN_MODE_OFF)
@@ -427,8 +434,41 @@ void APP_SetFrequencyByStep(VFO_Info_t *pInfo, int8_t Step) {
   BK4819_TuneTo(Frequency, false);
 }
 
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+// Steps tried per scan tick before the main loop gets the CPU back
+#define FAST_SCAN_STEPS 4
+// Time for the RSSI and noise meters to settle after a retune
+#define FAST_SCAN_SETTLE_US 1200
+
+// Quick look at the meters on the frequency tuned by APP_SetFrequencyByStep,
+// which only sets the frequency and filter. Steps that could not open the
+// squelch skip the full register setup and the squelch wait.
+static bool FREQ_IsWorthListening(void) {
+  SYSTICK_DelayUs(FAST_SCAN_SETTLE_US);
+  return BK4819_GetRSSI() >= gRxVfo->SquelchOpenRSSIThresh &&
+         BK4819_GetExNoiseIndicator() <= gRxVfo->SquelchOpenNoiseThresh;
+}
+#endif
+
 static void FREQ_NextChannel(void) {
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+  uint8_t i;
+
+  for (i = 0; i < FAST_SCAN_STEPS; i++) {
+    APP_SetFrequencyByStep(gRxVfo, gScanState);
+    if (FREQ_IsWorthListening()) {
+      break;
+    }
+  }
+  if (i == FAST_SCAN_STEPS) {
+    gUpdateDisplay = true;
+    ScanPauseDelayIn10msec = 1;
+    bScanKeepFrequency = false;
+    return;
+  }
+#else
   APP_SetFrequencyByStep(gRxVfo, gScanState);
+#endif
   RADIO_ApplyOffset(gRxVfo);
   RADIO_ConfigureSquelchAndOutputPower(gRxVfo);
   RADIO_SetupRegisters(true);
@@ -484,8 +524,12 @@ Skip:
   if (PreviousCh != gNextMrChannel) {
     gEeprom.MrChannel[gEeprom.RX_VFO] = gNextMrChannel;
     gEeprom.ScreenChannel[gEeprom.RX_VFO] = gNextMrChannel;
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+    RADIO_TuneScanChannel(gNextMrChannel);
+#else
     RADIO_ConfigureChannel(gEeprom.RX_VFO, 2);
     RADIO_SetupRegisters(true);
+#endif
     gUpdateDisplay = true;
   }
 #ifdef ENABLE_FASTER_CHANNEL_SCAN
@@ -509,16 +553,15 @@ static void DUALWATCH_Alternate(void) {
   gDualWatchCountdown = 10;
 }
 
+// Handles the events queued by BK4819_PollInterrupts(). Runs on every pass of
+// the main loop, ahead of APP_HandleFunction(), and touches the bus only when
+// there is something to handle.
 void APP_CheckRadioInterrupts(void) {
-  if (gAppToDisplay == APP_SCANNER) {
-    return;
-  }
+  BK4819_Event_t Event;
 
-  while (BK4819_ReadRegister(BK4819_REG_0C) & 1U) {
-    uint16_t Mask;
+  while (BK4819_GetEvent(&Event)) {
+    const uint16_t Mask = Event.Mask;
 
-    BK4819_WriteRegister(BK4819_REG_02, 0);
-    Mask = BK4819_ReadRegister(BK4819_REG_02);
     if (Mask & BK4819_REG_02_DTMF_5TONE_FOUND) {
       gDTMF_RequestPending = true;
       gDTMF_RecvTimeout = 5;
@@ -529,8 +572,7 @@ void APP_CheckRadioInterrupts(void) {
         }
         gDTMF_WriteIndex = 15;
       }
-      gDTMF_Received[gDTMF_WriteIndex++] =
-          DTMF_GetCharacter(BK4819_GetDTMF_5TONE_Code());
+      gDTMF_Received[gDTMF_WriteIndex++] = DTMF_GetCharacter(Event.Code);
       if (gCurrentFunction == FUNCTION_RECEIVE) {
         DTMF_HandleRequest();
       }
@@ -540,7 +582,7 @@ void APP_CheckRadioInterrupts(void) {
     }
     if (Mask & BK4819_REG_02_CDCSS_LOST) {
       g_CDCSS_Lost = true;
-      gCDCSSCodeType = BK4819_GetCDCSSCodeType();
+      gCDCSSCodeType = (Event.Status >> 14) & 3;
     }
     if (Mask & BK4819_REG_02_CDCSS_FOUND) {
       g_CDCSS_Lost = false;
@@ -593,8 +635,10 @@ void APP_CheckRadioInterrupts(void) {
   }
 }
 
-void APP_EndTransmission(void) {
-  RADIO_SendEndOfTransmission();
+static bool gEndingTransmission;
+static bool gReleaseAfterEnd;
+
+static void APP_FinishTransmission(void) {
   if (gCurrentVfo->pTX->CodeType != CODE_TYPE_OFF) { // CTCSS/DCS is enabled
     if (gEeprom.TAIL_NOTE_ELIMINATION) {
       RADIO_EnableCxCSS();
@@ -605,8 +649,32 @@ void APP_EndTransmission(void) {
   }
 
   RADIO_SetupRegisters(false);
+  gEndingTransmission = false;
+
+  if (gReleaseAfterEnd) {
+    if (gEeprom.REPEATER_TAIL_TONE_ELIMINATION == 0) {
+      FUNCTION_Select(FUNCTION_FOREGROUND);
+    } else {
+      gRTTECountdown = gEeprom.REPEATER_TAIL_TONE_ELIMINATION * 10;
+    }
+    gUpdateDisplay = true;
+  }
+}
+
+void APP_EndTransmission(bool bRelease) {
+  // An end still playing out only picks up the release, e.g. PTT let go
+  // after the TX timeout started it.
+  if (gEndingTransmission) {
+    gReleaseAfterEnd |= bRelease;
+    return;
+  }
+  gEndingTransmission = true;
+  gReleaseAfterEnd = bRelease;
+  RADIO_SendEndOfTransmission(APP_FinishTransmission);
 }
 
+void APP_AbandonEndTransmission(void) { gEndingTransmission = false; }
+
 static void APP_HandleVox(void) {
   if (gVoxResumeCountdown == 0) {
     if (gVoxPauseCountdown) {
@@ -625,8 +693,8 @@ static void APP_HandleVox(void) {
   ) {
     if (gVOX_NoiseDetected) {
       if (g_VOX_Lost) {
-        gVoxStopCountdown = 100;
-      } else if (gVoxStopCountdown == 0) {
+        SCHEDULER_Arm(&gVoxStopTimer, 100);
+      } else if (!SCHEDULER_IsArmed(&gVoxStopTimer)) {
         gVOX_NoiseDetected = false;
       }
       if (gCurrentFunction == FUNCTION_TRANSMIT && !gPttIsPressed &&
@@ -634,12 +702,7 @@ static void APP_HandleVox(void) {
         if (gFlagEndTransmission) {
           FUNCTION_Select(FUNCTION_FOREGROUND);
         } else {
-          APP_EndTransmission();
-          if (gEeprom.REPEATER_TAIL_TONE_ELIMINATION == 0) {
-            FUNCTION_Select(FUNCTION_FOREGROUND);
-          } else {
-            gRTTECountdown = gEeprom.REPEATER_TAIL_TONE_ELIMINATION * 10;
-          }
+          APP_EndTransmission(true);
         }
         gUpdateDisplay = true;
         gFlagEndTransmission = false;
@@ -663,7 +726,7 @@ void APP_Update(void) {
   if (gCurrentFunction == FUNCTION_TRANSMIT && gTxTimeoutReached) {
     gTxTimeoutReached = false;
     gFlagEndTransmission = true;
-    APP_EndTransmission();
+    APP_EndTransmission(false);
     AUDIO_PlayBeep(BEEP_500HZ_60MS_DOUBLE_BEEP);
     RADIO_SetVfoState(VFO_STATE_TIMEOUT);
     GUI_DisplayScreen();
@@ -672,6 +735,7 @@ void APP_Update(void) {
   if (gReducedService) {
     return;
   }
+  APP_CheckRadioInterrupts();
   if (gCurrentFunction != FUNCTION_TRANSMIT) {
     APP_HandleFunction();
   }
@@ -682,7 +746,7 @@ void APP_Update(void) {
 #endif
 
   if (gAppToDisplay != APP_SCANNER && gScanState != SCAN_OFF &&
-      gScheduleScanListen && !gPttIsPressed) {
+      gScheduleScanListen && !gPttIsPressed && !AUDIO_IsPlaying()) {
     if (IS_FREQ_CHANNEL(gNextMrChannel)) {
       if (gCurrentFunction == FUNCTION_INCOMING) {
         APP_StartListening(FUNCTION_RECEIVE, true);
@@ -715,7 +779,7 @@ void APP_Update(void) {
             && !gFmRadioMode
 #endif
             && gDTMF_CallState == DTMF_CALL_STATE_NONE &&
-            gCurrentFunction != FUNCTION_POWER_SAVE) {
+            gCurrentFunction != FUNCTION_POWER_SAVE && !AUDIO_IsPlaying()) {
           DUALWATCH_Alternate();
           if (gRxVfoIsActive && gScreenToDisplay == DISPLAY_MAIN) {
             GUI_SelectNextDisplay(DISPLAY_MAIN);
@@ -750,7 +814,7 @@ void APP_Update(void) {
         || gFmRadioMode
 #endif
         || gPttIsPressed || gScreenToDisplay != DISPLAY_MAIN || gKeyBeingHeld ||
-        gDTMF_CallState != DTMF_CALL_STATE_NONE) {
+        gDTMF_CallState != DTMF_CALL_STATE_NONE || AUDIO_IsPlaying()) {
       gBatterySaveCountdown = 1000;
     } else {
       if ((IS_NOT_NOAA_CHANNEL(gEeprom.ScreenChannel[0]) &&
@@ -763,7 +827,9 @@ void APP_Update(void) {
     gSchedulePowerSave = false;
   }
 
-  if (gBatterySaveCountdownExpired && gCurrentFunction == FUNCTION_POWER_SAVE) {
+  // a sound in progress keeps the chip awake until it is done
+  if (gBatterySaveCountdownExpired && gCurrentFunction == FUNCTION_POWER_SAVE &&
+      !AUDIO_IsPlaying()) {
     if (gRxIdleMode) {
       BK4819_EnableRX();
       if (gEeprom.VOX_SWITCH) {
@@ -874,6 +940,8 @@ void APP_CheckKeys(void) {
 void APP_TimeSlice10ms(void) {
   gFlashLightBlinkCounter++;
 
+  AUDIO_Update();
+
 #if defined(ENABLE_UART)
   if (UART_IsCommandAvailable()) {
     __disable_irq();
@@ -882,6 +950,19 @@ void APP_TimeSlice10ms(void) {
   }
 #endif
 
+#if defined(ENABLE_UART_CAT) && defined(ENABLE_SPECTRUM)
+  // a PC asked for the panadapter stream; same as F+5 from the main screen
+  if (gSpectrumLaunchRequest) {
+    gSpectrumLaunchRequest = false;
+    // the radio may have started a TX or RX since the request was accepted
+    if (SPECTRUM_CanLaunch()) {
+      FUNCTION_Select(FUNCTION_FOREGROUND);
+      APP_RunSpectrum();
+      gRequestDisplayScreen = DISPLAY_MAIN;
+    }
+  }
+#endif
+
   if (gAppToDisplay) {
     if (apps[gAppToDisplay].update) {
       apps[gAppToDisplay].update();
@@ -907,10 +988,6 @@ void APP_TimeSlice10ms(void) {
     AM_fix_10ms(gEeprom.RX_VFO);
 #endif
 
-  if (gCurrentFunction != FUNCTION_POWER_SAVE || !gRxIdleMode) {
-    APP_CheckRadioInterrupts();
-  }
-
   if (gCurrentFunction != FUNCTION_TRANSMIT) {
     if (gUpdateStatus) {
       UI_DisplayStatus();
@@ -922,6 +999,13 @@ void APP_TimeSlice10ms(void) {
     }
   }
 
+  // Polled after the screen update so that APP_Update() picks the events up
+  // right away.
+  if (gAppToDisplay != APP_SCANNER &&
+      (gCurrentFunction != FUNCTION_POWER_SAVE || !gRxIdleMode)) {
+    BK4819_PollInterrupts();
+  }
+
   // Skipping authentic device checks
 
 #if defined(ENABLE_FMRADIO)
@@ -1070,6 +1154,8 @@ void APP_TimeSlice10ms(void) {
 }
 
 void APP_TimeSlice500ms(void) {
+  gIdlePercent = SYSTICK_GetIdlePercent();
+
   // Skipped authentic device check
 
   if (gKeypadLocked) {
@@ -1249,7 +1335,8 @@ void APP_TimeSlice500ms(void) {
     }
   }
 
-  if (gDTMF_IsTx && gDTMF_TxStopCountdown) {
+  // Counted from the end of the DTMF code, which is sent in the background.
+  if (gDTMF_IsTx && gDTMF_TxStopCountdown && !AUDIO_IsPlaying()) {
     gDTMF_TxStopCountdown--;
     if (gDTMF_TxStopCountdown == 0) {
       gDTMF_IsTx = false;
@@ -1267,18 +1354,32 @@ void APP_TimeSlice500ms(void) {
 }
 
 #if defined(ENABLE_TX1750)
+static void ALARM_Finish(void) {
+  gVoxResumeCountdown = 0x50;
+  SYSTEM_DelayMs(5);
+  RADIO_SetupRegisters(true);
+  gRequestDisplayScreen = DISPLAY_MAIN;
+  if (gEeprom.REPEATER_TAIL_TONE_ELIMINATION == 0) {
+    FUNCTION_Select(FUNCTION_FOREGROUND);
+  } else {
+    gRTTECountdown = gEeprom.REPEATER_TAIL_TONE_ELIMINATION * 10;
+  }
+}
+
+static void ALARM_FinishTone(void) {
+  RADIO_EnableCxCSS();
+  ALARM_Finish();
+}
+
 static void ALARM_Off(void) {
   gAlarmState = ALARM_STATE_OFF;
   GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
   gEnableSpeaker = false;
   if (gEeprom.ALARM_MODE == ALARM_MODE_TONE) {
-    RADIO_SendEndOfTransmission();
-    RADIO_EnableCxCSS();
+    RADIO_SendEndOfTransmission(ALARM_FinishTone);
+  } else {
+    ALARM_Finish();
   }
-  gVoxResumeCountdown = 0x50;
-  SYSTEM_DelayMs(5);
-  RADIO_SetupRegisters(true);
-  gRequestDisplayScreen = DISPLAY_MAIN;
 }
 #endif
 
@@ -1291,6 +1392,9 @@ void CHANNEL_Next(bool bBackup, int8_t Direction) {
     if (bBackup) {
       gRestoreMrChannel = gNextMrChannel;
     }
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+    RADIO_PrepareScanImages(gEeprom.SCAN_LIST_DEFAULT);
+#endif
     MR_NextChannel();
   } else {
     if (bBackup) {
@@ -1483,11 +1587,6 @@ static void APP_ProcessKey(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld) {
       } else if (!bKeyHeld && bKeyPressed) {
 #if defined(ENABLE_TX1750)
         ALARM_Off();
-        if (gEeprom.REPEATER_TAIL_TONE_ELIMINATION == 0) {
-          FUNCTION_Select(FUNCTION_FOREGROUND);
-        } else {
-          gRTTECountdown = gEeprom.REPEATER_TAIL_TONE_ELIMINATION * 10;
-        }
         if (Key == KEY_PTT) {
           gPttWasPressed = true;
         } else {
@@ -21,7 +21,12 @@
 #include "../radio.h"
 #include <stdbool.h>
 
-void APP_EndTransmission(void);
+// Sends the transmission tail in the background. With bRelease the radio
+// then leaves FUNCTION_TRANSMIT, as on PTT release.
+void APP_EndTransmission(bool bRelease);
+// The tones of an ending transmission were stopped, e.g. by keying up again;
+// its follow-up will not run.
+void APP_AbandonEndTransmission(void);
 void CHANNEL_Next(bool bFlag, int8_t Direction);
 void APP_StartListening(FUNCTION_Type_t Function, const bool resetAmFix);
 void APP_SetFrequencyByStep(VFO_Info_t *pInfo, int8_t Step);
@@ -19,6 +19,7 @@
 #include "app/fm.h"
 #endif
 #include "scanner.h"
+#include "../audio.h"
 #include "../bsp/dp32g030/gpio.h"
 #include "../driver/bk4819.h"
 #include "../driver/eeprom.h"
@@ -252,7 +253,7 @@ void DTMF_HandleRequest(void)
 	}
 }
 
-void DTMF_Reply(void)
+void DTMF_Reply(void (*pDone)(void))
 {
 	char String[20];
 	const char *pString;
@@ -280,6 +281,7 @@ void DTMF_Reply(void)
 	default:
 		if (gDTMF_CallState != DTMF_CALL_STATE_NONE || (gCurrentVfo->DTMF_PTT_ID_TX_MODE != PTT_ID_BOT && gCurrentVfo->DTMF_PTT_ID_TX_MODE != PTT_ID_BOTH)) {
 			gDTMF_ReplyState = DTMF_REPLY_NONE;
+			pDone();
 			return;
 		}
 		pString = gEeprom.DTMF_UP_CODE;
@@ -289,28 +291,12 @@ void DTMF_Reply(void)
 	gDTMF_ReplyState = DTMF_REPLY_NONE;
 	Delay = gEeprom.DTMF_PRELOAD_TIME;
 	if (gEeprom.DTMF_SIDE_TONE) {
-		GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-		gEnableSpeaker = true;
 		Delay = gEeprom.DTMF_PRELOAD_TIME;
 		if (gEeprom.DTMF_PRELOAD_TIME < 60) {
 			Delay = 60;
 		}
 	}
-	SYSTEM_DelayMs(Delay);
 
-	BK4819_EnterDTMF_TX(gEeprom.DTMF_SIDE_TONE);
-
-	BK4819_PlayDTMFString(
-		pString,
-		1,
-		gEeprom.DTMF_FIRST_CODE_PERSIST_TIME,
-		gEeprom.DTMF_HASH_CODE_PERSIST_TIME,
-		gEeprom.DTMF_CODE_PERSIST_TIME,
-		gEeprom.DTMF_CODE_INTERVAL_TIME);
-
-	GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-
-	gEnableSpeaker = false;
-	BK4819_ExitDTMF_TX(false);
+	AUDIO_PlayDTMF(pString, Delay, true, false, pDone);
 }
 
@@ -84,7 +84,8 @@ bool DTMF_CompareMessage(const char *pDTMF, const char *pTemplate, uint8_t Size,
 bool DTMF_CheckGroupCall(const char *pDTMF, uint32_t Size);
 void DTMF_Append(char Code);
 void DTMF_HandleRequest(void);
-void DTMF_Reply(void);
+// pDone runs once the reply has been sent, straight away if there is none.
+void DTMF_Reply(void (*pDone)(void));
 
 #endif
 
@@ -104,9 +104,11 @@ void FM_EraseChannels(void)
 	uint8_t Template[8];
 
 	memset(Template, 0xFF, sizeof(Template));
+	EEPROM_BeginBatch();
 	for (i = 0; i < 5; i++) {
 		EEPROM_WriteBuffer(0x0E40 + (i * 8), Template);
 	}
+	EEPROM_EndBatch();
 
 	memset(gFM_Channels, 0xFF, sizeof(gFM_Channels));
 }
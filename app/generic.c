@@ -85,12 +85,7 @@ void GENERIC_Key_PTT(bool bKeyPressed) {
         if (gFlagEndTransmission) {
           FUNCTION_Select(FUNCTION_FOREGROUND);
         } else {
-          APP_EndTransmission();
-          if (gEeprom.REPEATER_TAIL_TONE_ELIMINATION == 0) {
-            FUNCTION_Select(FUNCTION_FOREGROUND);
-          } else {
-            gRTTECountdown = gEeprom.REPEATER_TAIL_TONE_ELIMINATION * 10;
-          }
+          APP_EndTransmission(true);
         }
         gFlagEndTransmission = false;
         gVOX_NoiseDetected = false;
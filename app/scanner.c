@@ -331,5 +331,8 @@ void SCANNER_Start(void) {
 
 void SCANNER_Stop(void) {
   gScanState = SCAN_OFF;
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+  RADIO_DropScanImages();
+#endif
   SETTINGS_SaveVfoIndices();
 }
@@ -15,6 +15,9 @@
  */
 
 #include "../app/spectrum.h"
+#include "../driver/crc.h"
+#include "../functions.h"
+#include "../scheduler.h"
 #include "finput.h"
 #include <string.h>
 
@@ -47,6 +50,7 @@ const uint8_t modulationTypeTuneSteps[] = {100, 50, 10};
 
 SpectrumSettings settings = {
     .stepsCount = STEPS_64,
+    .wideSteps = WIDE_OFF,
     .scanStepIndex = STEP_25_0kHz,
     .frequencyChangeStep = 80000,
     .rssiTriggerLevel = 150,
@@ -54,6 +58,9 @@ SpectrumSettings settings = {
     .listenBw = BK4819_FILTER_BW_WIDE,
     .modulationType = MOD_FM,
     .delayUS = 1200,
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+    .squelchMargin = 16,
+#endif
 };
 
 uint32_t fMeasure = 0;
@@ -61,6 +68,8 @@ uint32_t fTx = 0;
 uint32_t currentFreq;
 uint16_t rssiHistory[128] = {0};
 bool blacklist[128] = {false};
+// wide sweep bins, RSSI / 2 (1 dB per unit) to fit a byte
+static uint8_t wideHistory[128 << WIDE_1024];
 
 static const RegisterSpec registerSpecs[] = {
     {},
@@ -80,8 +89,7 @@ static const uint8_t registersToBackup[] = {
     0x13, 0x30, 0x31, 0x37, 0x3D, 0x40, 0x43, 0x47, 0x48, 0x7D, 0x7E,
 };
 
-static MovingAverage mov = {{128}, {}, 255, 128, 0, 0};
-static const uint8_t MOV_N = ARRAY_SIZE(mov.buf);
+static MovingAverage mov = {.mean = {128}, .min = 255, .mid = 128};
 
 uint8_t menuState = 0;
 #ifdef ENABLE_ALL_REGISTERS
@@ -91,6 +99,14 @@ uint8_t hiddenMenuState = 0;
 uint16_t listenT = 0;
 
 uint16_t batteryUpdateTimer = 0;
+
+// completed sweeps per 10 seconds, measured over ~1 s windows
+static uint16_t sweepsPer10s = 0;
+static uint16_t sweepsInWindow = 0;
+static uint32_t sweepWindowStart = 0;
+// bus reads (24 SCK cycles each) the BK4819 shadow saved over the last sweep
+static uint32_t shadowHitsPerSweep = 0;
+static uint32_t shadowHitsAtSweepStart = 0;
 bool isMovingInitialized = false;
 uint8_t lastStepsCount = 0;
 
@@ -119,7 +135,10 @@ KEY_Code_t GetKey() {
   return btn;
 }
 
+static void SamplerStop();
+
 void SetState(State state) {
+  SamplerStop();
   previousState = currentState;
   currentState = state;
   redrawScreen = true;
@@ -157,27 +176,260 @@ static void ResetPeak() {
 }
 
 bool IsCenterMode() { return settings.scanStepIndex < STEP_1_0kHz; }
+bool IsWideMode() { return settings.wideSteps != WIDE_OFF; }
 uint8_t GetStepsCount() { return 128 >> settings.stepsCount; }
+uint16_t GetMeasurementsCount() {
+  return IsWideMode() ? 128 << settings.wideSteps : GetStepsCount();
+}
 uint16_t GetScanStep() { return StepFrequencyTable[settings.scanStepIndex]; }
-uint32_t GetBW() { return GetStepsCount() * GetScanStep(); }
+uint32_t GetBW() { return GetMeasurementsCount() * GetScanStep(); }
 uint32_t GetFStart() {
   return IsCenterMode() ? currentFreq - (GetBW() >> 1) : currentFreq;
 }
 uint32_t GetFEnd() { return currentFreq + GetBW(); }
 
-static void MovingCp(uint16_t *dst, uint16_t *src) {
-  memcpy(dst, src, GetStepsCount() * sizeof(uint16_t));
+static void ResetMoving() {
+  for (uint8_t x = 0; x < 128; ++x) {
+#ifdef SPECTRUM_MOV_EXPONENTIAL
+    mov.acc[x] = rssiHistory[x] << MOV_SHIFT;
+#else
+    const uint16_t v = rssiHistory[x];
+    for (uint8_t i = 0; i < SPECTRUM_MOV_DEPTH; ++i) {
+      mov.buf[i][x] = v;
+    }
+    mov.sum[x] = v << MOV_SHIFT;
+#endif
+  }
 }
 
-static void ResetMoving() {
-  for (uint8_t i = 0; i < MOV_N; ++i) {
-    MovingCp(mov.buf[i], rssiHistory);
+// Push the latest sweep value of column x and return its new average
+static uint16_t MovePoint(uint8_t x) {
+  const uint16_t v = rssiHistory[x];
+#ifdef SPECTRUM_MOV_EXPONENTIAL
+  mov.acc[x] = mov.acc[x] - (mov.acc[x] >> MOV_SHIFT) + v;
+  return mov.acc[x] >> MOV_SHIFT;
+#else
+  uint16_t *oldest = &mov.buf[mov.head][x];
+  mov.sum[x] = mov.sum[x] - *oldest + v;
+  *oldest = v;
+  return mov.sum[x] >> MOV_SHIFT;
+#endif
+}
+
+// bin index to trace column, which is also the blacklist index
+static uint8_t BinToX(uint16_t i) {
+  return IsWideMode() ? i >> settings.wideSteps : i << settings.stepsCount;
+}
+
+static uint8_t BlacklistIndex(uint16_t i) {
+  return IsWideMode() ? i >> settings.wideSteps : i;
+}
+
+static void DecimateWideHistory() {
+  const uint8_t BPP = 1 << settings.wideSteps;
+  const uint8_t *bin = wideHistory;
+
+  for (uint8_t x = 0; x < 128; ++x, bin += BPP) {
+    uint8_t v = 0;
+    for (uint8_t j = 0; j < BPP; ++j) {
+      if (bin[j] > v) {
+        v = bin[j];
+      }
+    }
+    rssiHistory[x] = v << 1;
+  }
+}
+
+// Noise floor: median of the sweep over the bins not blacklisted, taken
+// from a histogram of 2 dB buckets filled in the MoveHistory pass. Signals
+// in up to half of the bins do not move it.
+#define FLOOR_BUCKETS 64
+#define FLOOR_BUCKET_SHIFT 2
+
+static uint16_t noiseFloor = 0; // 0 until the first sweep
+
+static void FloorAdd(uint8_t *histogram, uint16_t rssi) {
+  const uint16_t b = rssi >> FLOOR_BUCKET_SHIFT;
+  ++histogram[b < FLOOR_BUCKETS ? b : FLOOR_BUCKETS - 1];
+}
+
+// middle of the median bin's share of its bucket
+static uint16_t FloorMedian(const uint8_t *histogram, uint8_t count) {
+  const uint8_t rank = count >> 1;
+  uint8_t below = 0;
+  uint8_t b = 0;
+  while (below + histogram[b] <= rank) {
+    below += histogram[b++];
+  }
+  return (b << FLOOR_BUCKET_SHIFT) +
+         ((2 * (rank - below) + 1) << (FLOOR_BUCKET_SHIFT - 1)) / histogram[b];
+}
+
+static void UpdateNoiseFloor(const uint8_t *histogram, uint8_t count) {
+  const uint16_t median = FloorMedian(histogram, count);
+  // a quarter step per sweep, enough to follow the band without flicker
+  noiseFloor = noiseFloor ? (noiseFloor * 3 + median + 2) >> 2 : median;
+}
+
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+// The trigger follows the floor unless held closed with RSSI_MAX_VALUE - 1
+static void TrackTriggerLevel() {
+  if (!noiseFloor || currentState != SPECTRUM ||
+      settings.rssiTriggerLevel == RSSI_MAX_VALUE - 1) {
+    return;
+  }
+  settings.rssiTriggerLevel = noiseFloor + settings.squelchMargin;
+}
+#endif
+
+// Peaks: the strongest local maxima of the sweep over an adaptive floor,
+// ranked by level. A maximum is a new carrier only if the trace dips 6 dB
+// under the weaker of it and the previous one, otherwise the two are merged.
+static SignalPeak peaks[PEAKS_MAX];
+static uint8_t peaksCount = 0;
+static uint16_t peaksFloor = 0;
+static uint16_t peaksValley; // lowest level since the last maximum kept
+static uint16_t lastPeakI;
+static uint16_t lastPeakRssi;
+static bool peakHopped = false; // listening on a peak not yet confirmed
+
+static const uint8_t PEAK_MARGIN = 12; // 6 dB over the noise floor
+static const uint8_t PEAK_PROMINENCE = 12;
+static const uint16_t PEAK_HOP_CHECK_MS = 50;
+
+// scan bin shown in column x, the strongest one of its group in wide mode
+static uint16_t ColumnBin(uint8_t x) {
+  if (!IsWideMode()) {
+    return x;
+  }
+  const uint8_t BPP = 1 << settings.wideSteps;
+  const uint16_t first = x << settings.wideSteps;
+  uint8_t best = 0;
+  for (uint8_t j = 1; j < BPP; ++j) {
+    if (wideHistory[first + j] > wideHistory[first + best]) {
+      best = j;
+    }
+  }
+  return first + best;
+}
+
+// Level of the nearest column past x in direction dir that is not
+// blacklisted, 0 past either end
+static uint16_t PeakNeighbour(uint8_t x, int8_t dir, uint8_t XN) {
+  for (x += dir; x < XN; x += dir) {
+    if (!blacklist[x]) {
+      return rssiHistory[x];
+    }
+  }
+  return 0;
+}
+
+static void RemovePeak(uint16_t i) {
+  for (uint8_t n = 0; n < peaksCount; ++n) {
+    if (peaks[n].i == i) {
+      --peaksCount;
+      memmove(&peaks[n], &peaks[n + 1], (peaksCount - n) * sizeof(peaks[0]));
+      return;
+    }
+  }
+}
+
+static void InsertPeak(uint16_t i, uint16_t rssi) {
+  uint8_t n = peaksCount;
+  while (n && peaks[n - 1].rssi < rssi) {
+    if (n < PEAKS_MAX) {
+      peaks[n] = peaks[n - 1];
+    }
+    --n;
+  }
+  if (n == PEAKS_MAX) {
+    return;
+  }
+  peaks[n] = (SignalPeak){.i = i, .rssi = rssi};
+  if (peaksCount < PEAKS_MAX) {
+    ++peaksCount;
+  }
+}
+
+static void BeginPeaks() {
+  peaksCount = 0;
+  lastPeakRssi = 0;
+  // anything that could open the squelch must make the list
+  peaksFloor = (noiseFloor ? noiseFloor : mov.mid) + PEAK_MARGIN;
+  if (peaksFloor > settings.rssiTriggerLevel) {
+    peaksFloor = settings.rssiTriggerLevel;
   }
 }
 
+static void FindPeak(uint8_t x, uint8_t XN) {
+  // a blacklisted column has no level, rather than a dip splitting a carrier
+  if (blacklist[x]) {
+    return;
+  }
+
+  const uint16_t v = rssiHistory[x];
+  if (v < peaksValley) {
+    peaksValley = v;
+  }
+  if (!v || v < peaksFloor || v <= PeakNeighbour(x, -1, XN) ||
+      v < PeakNeighbour(x, 1, XN)) {
+    return;
+  }
+
+  const uint16_t weaker = v < lastPeakRssi ? v : lastPeakRssi;
+  if (lastPeakRssi && peaksValley + PEAK_PROMINENCE > weaker) {
+    if (v <= lastPeakRssi) {
+      return;
+    }
+    RemovePeak(lastPeakI);
+  }
+  lastPeakI = ColumnBin(x);
+  lastPeakRssi = v;
+  peaksValley = v;
+  InsertPeak(lastPeakI, v);
+}
+
+static bool IsPeakActive(const SignalPeak *p) {
+  return p->rssi >= settings.rssiTriggerLevel;
+}
+
+static const SignalPeak *LowestActivePeak() {
+  const SignalPeak *lowest = NULL;
+  for (uint8_t n = 0; n < peaksCount; ++n) {
+    if (IsPeakActive(&peaks[n]) && (!lowest || peaks[n].i < lowest->i)) {
+      lowest = &peaks[n];
+    }
+  }
+  return lowest;
+}
+
+// closest active peak other than bin i, going up or down and wrapping
+static const SignalPeak *NextActivePeak(uint16_t i, bool up) {
+  const uint16_t N = GetMeasurementsCount();
+  const SignalPeak *next = NULL;
+  uint16_t best = N;
+
+  for (uint8_t n = 0; n < peaksCount; ++n) {
+    const SignalPeak *p = &peaks[n];
+    if (p->i == i || !IsPeakActive(p)) {
+      continue;
+    }
+    const uint16_t d = (up ? p->i + N - i : i + N - p->i) % N;
+    if (d < best) {
+      best = d;
+      next = p;
+    }
+  }
+  return next;
+}
+
 static void MoveHistory() {
   const uint8_t XN = GetStepsCount();
 
+  if (IsWideMode()) {
+    DecimateWideHistory();
+  }
+
   uint32_t midSum = 0;
 
   mov.min = RSSI_MAX_VALUE;
@@ -187,24 +439,23 @@ static void MoveHistory() {
     ResetMoving();
     lastStepsCount = XN;
   }
-  for (uint8_t i = MOV_N - 1; i > 0; --i) {
-    MovingCp(mov.buf[i], mov.buf[i - 1]);
-  }
-  MovingCp(mov.buf[0], rssiHistory);
 
   uint8_t skipped = 0;
+  uint8_t histogram[FLOOR_BUCKETS] = {0};
+
+  BeginPeaks();
 
   for (uint8_t x = 0; x < XN; ++x) {
+    FindPeak(x, XN);
+
     if (blacklist[x]) {
       skipped++;
       continue;
     }
-    uint32_t sum = 0;
-    for (uint8_t i = 0; i < MOV_N; ++i) {
-      sum += mov.buf[i][x];
-    }
 
-    uint16_t pointV = mov.mean[x] = sum / MOV_N;
+    FloorAdd(histogram, rssiHistory[x]);
+
+    uint16_t pointV = mov.mean[x] = MovePoint(x);
 
     midSum += pointV;
 
@@ -216,13 +467,108 @@ static void MoveHistory() {
       mov.min = pointV;
     }
   }
+#ifndef SPECTRUM_MOV_EXPONENTIAL
+  mov.head = (mov.head + 1) & (SPECTRUM_MOV_DEPTH - 1);
+#endif
+
   if (skipped == XN) {
     return;
   }
 
   mov.mid = midSum / (XN - skipped);
+  UpdateNoiseFloor(histogram, XN - skipped);
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+  TrackTriggerLevel();
+#endif
+}
+
+#ifdef SPECTRUM_WATERFALL
+// Waterfall: each sweep is kept as 2 bit levels 4 dB apart above the noise
+// floor and drawn through a 2x2 ordered dither, so the levels read as grey
+static uint8_t waterfall[WATERFALL_LINES][128 / 4];
+static uint8_t waterfallHead = 0;  // next line to write
+static uint8_t waterfallLines = 0; // valid lines, saturates
+static bool waterfallPhase = false;    // dither row of the newest line
+static bool waterfallOnScreen = false; // its pages hold the ring, scrolled
+
+static const uint8_t DITHER[2][2] = {{0, 2}, {3, 1}};
+static const uint8_t DITHER_DENSITY[4] = {0, 1, 2, 4};
+
+static bool IsWaterfallShown() {
+  return settings.view == VIEW_WATERFALL && currentState == SPECTRUM;
+}
+
+static void ResetWaterfall() {
+  memset(waterfall, 0, sizeof(waterfall));
+  waterfallHead = 0;
+  waterfallLines = 0;
+  waterfallOnScreen = false;
+}
+
+static uint8_t WaterfallLevel(uint8_t x) {
+  const uint8_t i = x >> settings.stepsCount;
+  if (blacklist[i] || rssiHistory[i] <= noiseFloor) {
+    return 0;
+  }
+  const uint16_t level = (rssiHistory[i] - noiseFloor) >> 3;
+  return level > 3 ? 3 : level;
 }
 
+static bool WaterfallPixel(uint8_t level, bool phase, uint8_t x) {
+  return DITHER_DENSITY[level] > DITHER[phase][x & 1];
+}
+
+// Store the sweep just finished and, when the waterfall is on screen, scroll
+// its pages down one row in place instead of redrawing them from the ring
+static void PushWaterfall() {
+  uint8_t *line = waterfall[waterfallHead];
+
+  memset(line, 0, sizeof(waterfall[0]));
+  waterfallPhase = !waterfallPhase;
+
+  for (uint8_t x = 0; x < LCD_WIDTH; ++x) {
+    const uint8_t level = WaterfallLevel(x);
+    line[x >> 2] |= level << ((x & 3) << 1);
+
+    if (!waterfallOnScreen) {
+      continue;
+    }
+    uint8_t carry = WaterfallPixel(level, waterfallPhase, x);
+    for (uint8_t page = WATERFALL_PAGE;
+         page < WATERFALL_PAGE + WATERFALL_LINES / 8; ++page) {
+      uint8_t *p = &gFrameBuffer[page][x];
+      const uint8_t out = *p >> 7;
+      *p = (*p << 1) | carry;
+      carry = out;
+    }
+  }
+
+  waterfallHead = (waterfallHead + 1) % WATERFALL_LINES;
+  if (waterfallLines < WATERFALL_LINES) {
+    ++waterfallLines;
+  }
+}
+
+// newest line on top
+static void DrawWaterfall() {
+  for (uint8_t row = 0; row < waterfallLines; ++row) {
+    const uint8_t *line =
+        waterfall[(waterfallHead + WATERFALL_LINES - 1 - row) %
+                  WATERFALL_LINES];
+    const bool phase = waterfallPhase ^ (row & 1);
+    const uint8_t y = WATERFALL_PAGE * 8 + row;
+
+    for (uint8_t x = 0; x < LCD_WIDTH; ++x) {
+      const uint8_t level = (line[x >> 2] >> ((x & 3) << 1)) & 3;
+      if (WaterfallPixel(level, phase, x)) {
+        gFrameBuffer[y >> 3][x] |= 1 << (y & 7);
+      }
+    }
+  }
+  waterfallOnScreen = true;
+}
+#endif
+
 static void TuneToPeak() {
   scanInfo.f = peak.f;
   scanInfo.rssi = peak.rssi;
@@ -230,6 +576,13 @@ static void TuneToPeak() {
   SetF(scanInfo.f, true);
 }
 
+static void SelectPeak(const SignalPeak *p) {
+  peak.t = 0;
+  peak.i = p->i;
+  peak.rssi = p->rssi;
+  peak.f = GetFStart() + p->i * GetScanStep();
+}
+
 uint16_t GetBWRegValueForScan() { return 0b0000000110111100; }
 
 uint16_t GetBWRegValueForListen() {
@@ -245,14 +598,211 @@ static void ResetRSSI() {
   BK4819_WriteRegister(BK4819_REG_30, Reg);
 }
 
+#ifdef SPECTRUM_ADAPTIVE_DWELL
+// RSSI units are 0.5 dB, so a bin closer than 6 dB to the level we care about
+// gets the full dwell
+static const uint8_t DWELL_MARGIN = 12;
+
+static bool IsWorthFullDwell(uint16_t rssi) {
+  uint32_t level = settings.rssiTriggerLevel;
+  // strongest signal seen so far, if it stands out of the noise
+  if (mov.max > mov.mid + DWELL_MARGIN && mov.max < level) {
+    level = mov.max;
+  }
+  return rssi + DWELL_MARGIN >= level;
+}
+#endif
+
 uint16_t GetRssi() {
   if (currentState == SPECTRUM) {
     ResetRSSI();
+#ifdef SPECTRUM_ADAPTIVE_DWELL
+    // quick look first, keep integrating only if it may be a carrier
+    const uint16_t quickUS = settings.delayUS >> 2;
+    SYSTICK_DelayUs(quickUS);
+    uint16_t rssi = BK4819_GetRSSI();
+    if (isListening || IsWorthFullDwell(rssi)) {
+      SYSTICK_DelayUs(settings.delayUS - quickUS);
+    } else {
+      return rssi;
+    }
+#else
     SYSTICK_DelayUs(settings.delayUS);
+#endif
   }
   return BK4819_GetRSSI();
 }
 
+// Sweep sampler
+//
+// While sweeping, bins are tuned and measured from the SysTick interrupt at
+// the dwell period, so rendering, input and UART work in Tick() no longer
+// stretch the dwell. Samples reach the foreground through a single producer,
+// single consumer ring; a full ring holds the sampler on its bin instead of
+// dropping data.
+
+#define SAMPLE_RING_SIZE 64U // power of two
+#define SAMPLE_SWEEP_END 0xFFFFU
+
+#ifdef SPECTRUM_ADAPTIVE_DWELL
+// a quick look after a quarter of the dwell, the rest only if worth it
+#define DWELL_TICKS 4U
+#else
+#define DWELL_TICKS 1U
+#endif
+
+// Dwell limits for the keys and the PC stream. The subtick is a DWELL_TICKS
+// share of the dwell and has to leave the foreground time to run.
+#define DELAY_US_MIN 400
+#define DELAY_US_MAX 10000
+
+static uint16_t ClampDelayUS(int32_t us) {
+  if (us < DELAY_US_MIN) {
+    return DELAY_US_MIN;
+  }
+  return us > DELAY_US_MAX ? DELAY_US_MAX : us;
+}
+
+typedef struct {
+  uint16_t i;    // bin, or SAMPLE_SWEEP_END
+  uint16_t rssi; // bin RSSI, or the sweep jitter in us
+} Sample;
+
+static Sample samples[SAMPLE_RING_SIZE];
+static volatile uint8_t samplesHead; // written by the sampler only
+static volatile uint8_t samplesTail; // written by the foreground only
+
+static struct {
+  bool running;
+  uint32_t fStart;
+  uint16_t step;
+  uint16_t count;
+  uint16_t periodUS;
+  uint16_t i;
+  uint8_t ticks;      // subticks spent on bin i
+  uint16_t lastPhase; // SysTick phase of the previous bin reading
+  uint16_t jitter;    // worst deviation from the dwell this sweep, us
+} sampler;
+
+static uint16_t sweepJitterUS = 0;
+
+static bool SamplerPush(uint16_t i, uint16_t rssi) {
+  const uint8_t head = samplesHead;
+
+  if ((uint8_t)(head - samplesTail) == SAMPLE_RING_SIZE) {
+    return false;
+  }
+  samples[head & (SAMPLE_RING_SIZE - 1)] = (Sample){i, rssi};
+  samplesHead = head + 1;
+  return true;
+}
+
+static bool SamplerPop(Sample *s) {
+  const uint8_t tail = samplesTail;
+
+  if (tail == samplesHead) {
+    return false;
+  }
+  *s = samples[tail & (SAMPLE_RING_SIZE - 1)];
+  samplesTail = tail + 1;
+  return true;
+}
+
+// rm harmonics using blacklist for now
+static bool IsHarmonic(uint32_t f) {
+#ifndef ENABLE_ALL_REGISTERS
+  return f % 1300000 == 0;
+#else
+  (void)f;
+  return false;
+#endif
+}
+
+// Tunes the next bin worth measuring, closing the sweep after the last one
+static void SamplerTune() {
+  uint32_t f;
+
+  for (;; ++sampler.i) {
+    if (sampler.i == sampler.count) {
+      if (!SamplerPush(SAMPLE_SWEEP_END, sampler.jitter)) {
+        return; // try again on the next subtick
+      }
+      sampler.i = 0;
+      sampler.jitter = 0;
+    }
+    f = sampler.fStart + sampler.i * sampler.step;
+    // only read here, SamplerStart() marks the harmonics
+    if (!blacklist[BlacklistIndex(sampler.i)] && !IsHarmonic(f)) {
+      break;
+    }
+  }
+  SetF(f, true);
+  ResetRSSI();
+  sampler.ticks = 0;
+}
+
+static void SamplerTick() {
+  if (sampler.i == sampler.count) {
+    SamplerTune();
+    return;
+  }
+
+  const uint16_t phase = SYSTICK_GetPhaseUs();
+  uint16_t rssi = BK4819_GetRSSI();
+  uint8_t due = DWELL_TICKS;
+
+  ++sampler.ticks;
+#ifdef SPECTRUM_ADAPTIVE_DWELL
+  if (sampler.ticks == 1 && !IsWorthFullDwell(rssi)) {
+    due = 1;
+  }
+#endif
+  if (sampler.ticks < due || !SamplerPush(sampler.i, rssi)) {
+    return;
+  }
+
+  // a held sampler shows up as whole periods late
+  uint16_t jitter = (sampler.ticks - due) * sampler.periodUS;
+  jitter += phase > sampler.lastPhase ? phase - sampler.lastPhase
+                                      : sampler.lastPhase - phase;
+  if (jitter > sampler.jitter) {
+    sampler.jitter = jitter;
+  }
+  sampler.lastPhase = phase;
+
+  ++sampler.i;
+  SamplerTune();
+}
+
+static void SamplerStart() {
+  sampler.fStart = scanInfo.f;
+  sampler.step = scanInfo.scanStep;
+  sampler.count = scanInfo.measurementsCount;
+  sampler.periodUS = settings.delayUS / DWELL_TICKS;
+  sampler.i = scanInfo.i;
+  sampler.jitter = 0;
+  sampler.lastPhase = 0;
+  samplesHead = samplesTail = 0;
+
+  for (uint16_t i = 0; i < sampler.count; ++i) {
+    if (IsHarmonic(sampler.fStart + i * sampler.step)) {
+      blacklist[BlacklistIndex(i)] = true;
+    }
+  }
+
+  SamplerTune();
+  sampler.running = true;
+  SCHEDULER_SetSubtick(SamplerTick, sampler.periodUS);
+}
+
+static void SamplerStop() {
+  if (!sampler.running) {
+    return;
+  }
+  SCHEDULER_SetSubtick(NULL, 0);
+  sampler.running = false;
+}
+
 static void ToggleAudio(bool on) {
   if (on) {
     GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
@@ -265,6 +815,7 @@ static void ToggleTX(bool);
 static void ToggleRX(bool);
 
 static void ToggleRX(bool on) {
+  SamplerStop();
   if (isListening == on) {
     return;
   }
@@ -306,6 +857,7 @@ static void RegRestore(uint8_t num) {
 }
 
 static void ToggleTX(bool on) {
+  SamplerStop();
   if (isTransmitting == on) {
     return;
   }
@@ -333,7 +885,8 @@ static void ToggleTX(bool on) {
     BK4819_SetupPowerAmplifier(gCurrentVfo->TXP_CalculatedSetting,
                                gCurrentVfo->pTX->Frequency);
   } else {
-    RADIO_SendEndOfTransmission();
+    RADIO_SendEndOfTransmission(NULL);
+    AUDIO_Flush();
     RADIO_EnableCxCSS();
 
     BK4819_SetupPowerAmplifier(0, 0);
@@ -363,12 +916,13 @@ static void ResetScanStats() {
 }
 
 static void InitScan() {
+  SamplerStop();
   ResetScanStats();
   scanInfo.i = 0;
   scanInfo.f = GetFStart();
 
   scanInfo.scanStep = GetScanStep();
-  scanInfo.measurementsCount = GetStepsCount();
+  scanInfo.measurementsCount = GetMeasurementsCount();
 }
 
 static void ResetBlacklist() { memset(blacklist, false, 128); }
@@ -376,8 +930,12 @@ static void ResetBlacklist() { memset(blacklist, false, 128); }
 static void RelaunchScan() {
   InitScan();
   ResetPeak();
+#ifdef SPECTRUM_WATERFALL
+  ResetWaterfall();
+#endif
   lastStepsCount = 0;
   ToggleRX(false);
+  noiseFloor = 0;
 #ifdef SPECTRUM_AUTOMATIC_SQUELCH
   settings.rssiTriggerLevel = RSSI_MAX_VALUE;
 #endif
@@ -386,6 +944,42 @@ static void RelaunchScan() {
   redrawStatus = true;
 }
 
+static void JumpToPeak(bool up) {
+  const SignalPeak *p = NextActivePeak(peak.i, up);
+  if (!p) {
+    return;
+  }
+  SelectPeak(p);
+  ToggleRX(true);
+  TuneToPeak();
+  listenT = 1000;
+  peakHopped = false;
+  redrawScreen = true;
+}
+
+// Round robin up in frequency over the active peaks of the last sweep. A
+// peak hopped to is only checked briefly, and once confirmed gets a full
+// listen. Past the highest one the band is swept again, so signals that
+// came up meanwhile join the next round.
+static void ListenNextPeak() {
+  if (IsPeakOverLevel() && peakHopped) {
+    peakHopped = false;
+    listenT = 1000;
+    return;
+  }
+  const SignalPeak *p = NextActivePeak(peak.i, true);
+  peakHopped = false;
+  if (!p || p->i < peak.i) {
+    ToggleRX(false);
+    newScanStart = true;
+    return;
+  }
+  SelectPeak(p);
+  TuneToPeak();
+  listenT = PEAK_HOP_CHECK_MS;
+  peakHopped = true;
+}
+
 static void UpdateScanInfo() {
   if (scanInfo.rssi > scanInfo.rssiMax) {
     scanInfo.rssiMax = scanInfo.rssi;
@@ -417,20 +1011,40 @@ static void UpdatePeakInfo() {
     UpdatePeakInfoForce();
 }
 
+static void StoreRssi(uint16_t rssi) {
+  scanInfo.rssi = rssi;
+  if (IsWideMode()) {
+    wideHistory[scanInfo.i] = rssi >> 1;
+  } else {
+    rssiHistory[scanInfo.i] = rssi;
+  }
+}
+
 static void Measure() {
-  // rm harmonics using blacklist for now
-#ifndef ENABLE_ALL_REGISTERS
-  if (scanInfo.f % 1300000 == 0) {
-    blacklist[scanInfo.i] = true;
+  if (IsHarmonic(scanInfo.f)) {
+    blacklist[BlacklistIndex(scanInfo.i)] = true;
     return;
   }
-#endif
-  rssiHistory[scanInfo.i] = scanInfo.rssi = GetRssi();
+  StoreRssi(GetRssi());
 }
 
 // Update things by keypress
 
 static void UpdateRssiTriggerLevel(bool inc) {
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+  // the level follows the noise floor, move the margin over it instead
+  if (currentState == SPECTRUM) {
+    if (inc && settings.squelchMargin < 254) {
+      settings.squelchMargin += 2;
+    } else if (!inc && settings.squelchMargin >= 2) {
+      settings.squelchMargin -= 2;
+    }
+    TrackTriggerLevel();
+    redrawScreen = true;
+    SYSTEM_DelayMs(10);
+    return;
+  }
+#endif
   if (inc)
     settings.rssiTriggerLevel += 2;
   else
@@ -445,6 +1059,7 @@ static void ApplyPreset(FreqPreset p) {
   settings.listenBw = p.listenBW;
   settings.modulationType = p.modulationType;
   settings.stepsCount = p.stepsCountIndex;
+  settings.wideSteps = WIDE_OFF;
   BK4819_SetModulation(settings.modulationType);
   RelaunchScan();
   ResetBlacklist();
@@ -559,9 +1174,25 @@ static void ToggleBacklight() {
   }
 }
 
+static void ToggleView() {
+  settings.view = (settings.view + 1) % VIEW_COUNT;
+#ifdef SPECTRUM_WATERFALL
+  waterfallOnScreen = false;
+#endif
+  redrawScreen = true;
+}
+
+// 128 -> 256w -> 512w -> 1024w -> 16 -> 32 -> 64 -> 128
 static void ToggleStepsCount() {
-  if (settings.stepsCount == STEPS_128) {
-    settings.stepsCount = STEPS_16;
+  if (IsWideMode()) {
+    if (settings.wideSteps == WIDE_1024) {
+      settings.wideSteps = WIDE_OFF;
+      settings.stepsCount = STEPS_16;
+    } else {
+      ++settings.wideSteps;
+    }
+  } else if (settings.stepsCount == STEPS_128) {
+    settings.wideSteps = WIDE_256;
   } else {
     --settings.stepsCount;
   }
@@ -573,7 +1204,7 @@ static void ToggleStepsCount() {
 
 #ifndef ENABLE_ALL_REGISTERS
 static void Blacklist() {
-  blacklist[peak.i] = true;
+  blacklist[BlacklistIndex(peak.i)] = true;
   ResetPeak();
   ToggleRX(false);
   newScanStart = true;
@@ -583,20 +1214,28 @@ static void Blacklist() {
 
 // Draw things
 
+static uint8_t TraceEndY() {
+  return settings.view == VIEW_TRACE ? DrawingEndY : ShortTraceEndY;
+}
+
+// ticks and the peak arrow sit on the page right under the trace
+static uint8_t *TicksLine() { return gFrameBuffer[TraceEndY() >> 3]; }
+
 static uint8_t Rssi2Y(uint16_t rssi) {
-  return DrawingEndY - ConvertDomain(rssi, mov.min - 2,
-                                     mov.max + 20 + (mov.max - mov.min) / 2, 0,
-                                     DrawingEndY);
+  const uint8_t endY = TraceEndY();
+  return endY - ConvertDomain(rssi, mov.min - 2,
+                              mov.max + 20 + (mov.max - mov.min) / 2, 0, endY);
 }
 
 static void DrawSpectrum() {
+  const uint8_t endY = TraceEndY();
   for (uint8_t x = 0; x < LCD_WIDTH; ++x) {
     uint8_t i = x >> settings.stepsCount;
     if (blacklist[i]) {
       continue;
     }
     uint16_t rssi = rssiHistory[i];
-    DrawHLine(Rssi2Y(rssi), DrawingEndY, x, true);
+    DrawHLine(Rssi2Y(rssi), endY, x, true);
   }
 }
 
@@ -638,7 +1277,8 @@ static void DrawStatus() {
         UI_PrintStringSmallest(p->name, 0, 0, true, true);
       }
 
-      sprintf(String, "D: %u us", settings.delayUS);
+      sprintf(String, "%uus %u.%u/s", settings.delayUS, sweepsPer10s / 10,
+              sweepsPer10s % 10);
       UI_PrintStringSmallest(String, 64, 0, true, true);
     }
 #ifdef ENABLE_ALL_REGISTERS
@@ -681,10 +1321,21 @@ static void DrawF(uint32_t f) {
 
 static void DrawNums() {
   if (currentState == SPECTRUM) {
-    sprintf(String, "%ux", GetStepsCount());
+    sprintf(String, "%ux", GetMeasurementsCount());
     UI_PrintStringSmallest(String, 0, 2, false, true);
     sprintf(String, "%u.%02uk", GetScanStep() / 100, GetScanStep() % 100);
     UI_PrintStringSmallest(String, 0, 8, false, true);
+    // worst bin to bin dwell deviation of the last sweep
+    sprintf(String, "%uus", sweepJitterUS);
+    if (settings.view == VIEW_TRACE) {
+      UI_PrintStringSmallest(String, 0, 14, false, true);
+#ifdef ENABLE_BK4819_SHADOW_CHECK
+      sprintf(String, "SH%u E%u", shadowHitsPerSweep, gBK4819_ShadowMismatches);
+#else
+      sprintf(String, "SH%u", shadowHitsPerSweep);
+#endif
+      UI_PrintStringSmallest(String, 0, 20, false, true);
+    }
   }
 
   if (IsCenterMode()) {
@@ -716,49 +1367,75 @@ static void DrawRssiTriggerLevel() {
   }
 }
 
+// ranked top to bottom, then the second column
+static void DrawPeaks() {
+  for (uint8_t n = 0; n < peaksCount; ++n) {
+    const SignalPeak *p = &peaks[n];
+    const uint32_t f = GetScreenF(GetFStart() + p->i * GetScanStep());
+    char mark = ' ';
+    if (isListening && p->i == peak.i) {
+      mark = '>';
+    } else if (IsPeakActive(p)) {
+      mark = '+';
+    }
+    sprintf(String, "%c%u.%05u %d", mark, f / 100000, f % 100000,
+            Rssi2DBm(p->rssi));
+    UI_PrintStringSmallest(String, n / 4 * 64, PEAKS_PAGE * 8 + n % 4 * 6,
+                           false, true);
+  }
+}
+
 static void DrawTicks() {
+  uint8_t *ln = TicksLine();
   uint32_t f = GetFStart() % 100000;
   uint32_t step = GetScanStep();
-  for (uint8_t x = 0; x < LCD_WIDTH;
-       x += (1 << settings.stepsCount), f += step) {
+  uint8_t dx = 1 << settings.stepsCount;
+  if (IsWideMode()) {
+    // one column per 2^n bins
+    step <<= settings.wideSteps;
+    dx = 1;
+  }
+  for (uint8_t x = 0; x < LCD_WIDTH; x += dx, f += step) {
     uint8_t barValue = 0b00000001;
     (f % 10000) < step && (barValue |= 0b00000010);
     (f % 50000) < step && (barValue |= 0b00000100);
     (f % 100000) < step && (barValue |= 0b00011000);
 
-    gFrameBuffer[5][x] |= barValue;
+    ln[x] |= barValue;
   }
 
   // center
   if (IsCenterMode()) {
-    gFrameBuffer[5][62] = 0x80;
-    gFrameBuffer[5][63] = 0x80;
-    gFrameBuffer[5][64] = 0xff;
-    gFrameBuffer[5][65] = 0x80;
-    gFrameBuffer[5][66] = 0x80;
+    ln[62] = 0x80;
+    ln[63] = 0x80;
+    ln[64] = 0xff;
+    ln[65] = 0x80;
+    ln[66] = 0x80;
   } else {
-    gFrameBuffer[5][0] = 0xff;
-    gFrameBuffer[5][1] = 0x80;
-    gFrameBuffer[5][2] = 0x80;
-    gFrameBuffer[5][3] = 0x80;
-    gFrameBuffer[5][124] = 0x80;
-    gFrameBuffer[5][125] = 0x80;
-    gFrameBuffer[5][126] = 0x80;
-    gFrameBuffer[5][127] = 0xff;
+    ln[0] = 0xff;
+    ln[1] = 0x80;
+    ln[2] = 0x80;
+    ln[3] = 0x80;
+    ln[124] = 0x80;
+    ln[125] = 0x80;
+    ln[126] = 0x80;
+    ln[127] = 0xff;
   }
 }
 
 static void DrawArrow(uint8_t x) {
+  uint8_t *ln = TicksLine();
   for (signed i = -2; i <= 2; ++i) {
     signed v = x + i;
     uint8_t a = i > 0 ? i : -i;
     if (!(v & LCD_WIDTH)) {
-      gFrameBuffer[5][v] |= (0b01111000 << a) & 0b01111000;
+      ln[v] |= (0b01111000 << a) & 0b01111000;
     }
   }
 }
 
 static void DeInitSpectrum() {
+  SamplerStop();
   SetF(initialFreq, true);
   ToggleRX(false);
   RestoreRegisters();
@@ -770,14 +1447,14 @@ static void OnKeyDown(uint8_t key) {
   case KEY_3:
     if (0)
       SelectNearestPreset(true);
-    settings.delayUS += 100;
+    settings.delayUS = ClampDelayUS(settings.delayUS + 100);
     SYSTEM_DelayMs(100);
     redrawStatus = true;
     break;
   case KEY_9:
     if (0)
       SelectNearestPreset(false);
-    settings.delayUS -= 100;
+    settings.delayUS = ClampDelayUS(settings.delayUS - 100);
     SYSTEM_DelayMs(100);
     redrawStatus = true;
     break;
@@ -823,6 +1500,10 @@ static void OnKeyDown(uint8_t key) {
       break;
     }
 #endif
+    if (settings.view == VIEW_PEAKS) {
+      JumpToPeak(true);
+      break;
+    }
     UpdateCurrentFreq(true);
     break;
   case KEY_DOWN:
@@ -833,6 +1514,10 @@ static void OnKeyDown(uint8_t key) {
       break;
     }
 #endif
+    if (settings.view == VIEW_PEAKS) {
+      JumpToPeak(false);
+      break;
+    }
     UpdateCurrentFreq(false);
     break;
   case KEY_SIDE1:
@@ -867,7 +1552,7 @@ static void OnKeyDown(uint8_t key) {
     ToggleStepsCount();
     break;
   case KEY_SIDE2:
-    ToggleBacklight();
+    ToggleView();
     break;
   case KEY_PTT:
     SetState(STILL);
@@ -1081,8 +1766,16 @@ static void RenderStatus() {
 }
 
 static void RenderSpectrum() {
+#ifdef SPECTRUM_WATERFALL
+  if (settings.view == VIEW_WATERFALL && !waterfallOnScreen) {
+    DrawWaterfall();
+  }
+#endif
+  if (settings.view == VIEW_PEAKS) {
+    DrawPeaks();
+  }
   DrawTicks();
-  DrawArrow(peak.i << settings.stepsCount);
+  DrawArrow(BinToX(peak.i));
   DrawSpectrum();
   DrawRssiTriggerLevel();
   DrawF(GetScreenF(peak.f));
@@ -1175,8 +1868,25 @@ static void RenderStill() {
 #endif
 }
 
-static void Render() {
+static void ClearFrameBuffer() {
+#ifdef SPECTRUM_WATERFALL
+  // the waterfall pages were scrolled by PushWaterfall, keep them
+  if (IsWaterfallShown() && waterfallOnScreen) {
+    for (uint8_t page = 0; page < ARRAY_SIZE(gFrameBuffer); ++page) {
+      if (page < WATERFALL_PAGE ||
+          page >= WATERFALL_PAGE + WATERFALL_LINES / 8) {
+        memset(gFrameBuffer[page], 0, sizeof(gFrameBuffer[page]));
+      }
+    }
+    return;
+  }
+  waterfallOnScreen = false;
+#endif
   memset(gFrameBuffer, 0, sizeof(gFrameBuffer));
+}
+
+static void Render() {
+  ClearFrameBuffer();
 
   switch (currentState) {
   case SPECTRUM:
@@ -1225,42 +1935,271 @@ bool HandleUserInput() {
   return true;
 }
 
-static void Scan() {
-  if (blacklist[scanInfo.i]) {
+static void UpdateSweepRate() {
+  uint32_t elapsed = gGlobalSysTickCounter - sweepWindowStart;
+
+  ++sweepsInWindow;
+  if (elapsed < 100) {
     return;
   }
-  SetF(scanInfo.f, true);
-  Measure();
-  UpdateScanInfo();
+  // ticks are 10 ms
+  sweepsPer10s = sweepsInWindow * 1000 / elapsed;
+  sweepsInWindow = 0;
+  sweepWindowStart = gGlobalSysTickCounter;
+  redrawStatus = true;
 }
 
-static void NextScanStep() {
-  ++peak.t;
-  ++scanInfo.i;
-  scanInfo.f += scanInfo.scanStep;
+// PC panadapter stream
+
+bool gSpectrumLaunchRequest = false;
+
+static SpectrumStreamConfig stream;
+static bool streamPending = false;
+
+// StepFrequencyTable is sorted, so the nearest entry is the first one that
+// is closer than its successor
+static uint8_t NearestStepIndex(uint16_t step) {
+  uint8_t i = 0;
+  while (i < ARRAY_SIZE(StepFrequencyTable) - 1 &&
+         step > (StepFrequencyTable[i] + StepFrequencyTable[i + 1]) / 2) {
+    ++i;
+  }
+  return i;
 }
 
-static void UpdateScan() {
-  Scan();
+void SPECTRUM_ConfigureStream(SpectrumStreamConfig *pConfig) {
+  if (pConfig->step) {
+    pConfig->step = StepFrequencyTable[NearestStepIndex(pConfig->step)];
+  }
+  if (pConfig->bins) {
+    uint16_t bins = 16;
+    while (bins < 1024 && bins << 1 <= pConfig->bins) {
+      bins <<= 1;
+    }
+    pConfig->bins = bins;
+  }
+  if (pConfig->delayUS) {
+    pConfig->delayUS = ClampDelayUS(pConfig->delayUS);
+  }
+  pConfig->padding = 0;
+
+  stream = *pConfig;
+  streamPending = true;
+
+  if ((stream.flags & SPECTRUM_STREAM_LAUNCH) && !isInitialized) {
+    // only from idle, like F+5; never in the middle of a TX or a reception
+    if (SPECTRUM_CanLaunch()) {
+      gSpectrumLaunchRequest = true;
+    } else {
+      pConfig->flags |= SPECTRUM_STREAM_REFUSED;
+    }
+  }
+}
+
+bool SPECTRUM_CanLaunch(void) {
+  return gCurrentFunction == FUNCTION_FOREGROUND ||
+         gCurrentFunction == FUNCTION_POWER_SAVE;
+}
+
+static void ApplyStream() {
+  bool relaunch = false;
+
+  streamPending = false;
 
-  if (scanInfo.i < scanInfo.measurementsCount) {
-    NextScanStep();
+  if (stream.step) {
+    settings.scanStepIndex = NearestStepIndex(stream.step);
+    relaunch = true;
+  }
+  if (stream.bins) {
+    if (stream.bins <= 128) {
+      settings.wideSteps = WIDE_OFF;
+      settings.stepsCount = STEPS_128;
+      while (GetStepsCount() > stream.bins) {
+        ++settings.stepsCount;
+      }
+    } else {
+      settings.stepsCount = STEPS_128;
+      settings.wideSteps = WIDE_256;
+      while (GetMeasurementsCount() < stream.bins) {
+        ++settings.wideSteps;
+      }
+    }
+    relaunch = true;
+  }
+  if (stream.delayUS) {
+    settings.delayUS = ClampDelayUS(stream.delayUS);
+  }
+  if (stream.fStart >= F_MIN && stream.fStart <= F_MAX) {
+    currentFreq = stream.fStart + (IsCenterMode() ? GetBW() >> 1 : 0);
+    relaunch = true;
+  }
+
+  if (relaunch) {
+    settings.frequencyChangeStep = GetBW() >> 1;
+    RelaunchScan();
+    ResetBlacklist();
+    newScanStart = true;
+    redrawScreen = true;
+  }
+}
+
+#if defined(ENABLE_UART) && defined(ENABLE_UART_CAT)
+// Bins go out through a small buffer twice: once to size and checksum the
+// frame, once to send it, so a 1024 bin sweep needs no staging copy.
+static struct {
+  uint8_t buf[32];
+  uint8_t len;
+  bool lowNibble;
+  bool send;
+  uint16_t size;
+  uint16_t crc;
+} enc;
+
+static void StreamFlush() {
+  if (enc.send) {
+    UART_WriteFrame(enc.buf, enc.len);
+  } else {
+    enc.crc = CRC_Update(enc.crc, enc.buf, enc.len);
+  }
+  enc.size += enc.len;
+  enc.len = 0;
+}
+
+static void StreamByte(uint8_t v) {
+  enc.buf[enc.len++] = v;
+  if (enc.len == sizeof(enc.buf)) {
+    StreamFlush();
+  }
+}
+
+// high nibble first; an odd count leaves the last low nibble zero
+static void StreamNibble(uint8_t v) {
+  enc.lowNibble = !enc.lowNibble;
+  if (enc.lowNibble) {
+    enc.buf[enc.len] = v << 4;
+    return;
+  }
+  StreamByte(enc.buf[enc.len] | (v & 0xF));
+}
+
+static uint8_t StreamBin(uint16_t i) {
+  if (blacklist[BlacklistIndex(i)]) {
+    return 0;
+  }
+  return IsWideMode() ? wideHistory[i] : rssiHistory[i] >> 1;
+}
+
+static void EncodeSweep(bool send) {
+  const uint16_t N = scanInfo.measurementsCount;
+
+  enc.len = 0;
+  enc.lowNibble = false;
+  enc.send = send;
+  enc.size = 0;
+  enc.crc = 0;
+
+  if (!(stream.flags & SPECTRUM_STREAM_DELTA)) {
+    for (uint16_t i = 0; i < N; ++i) {
+      StreamByte(StreamBin(i));
+    }
+    StreamFlush();
     return;
   }
 
+  uint8_t prev = StreamBin(0);
+  StreamNibble(prev >> 4);
+  StreamNibble(prev);
+  for (uint16_t i = 1; i < N; ++i) {
+    const uint8_t v = StreamBin(i);
+    const int16_t d = v - prev;
+    if (d >= -7 && d <= 7) {
+      StreamNibble(d);
+    } else {
+      StreamNibble(8);
+      StreamNibble(v >> 4);
+      StreamNibble(v);
+    }
+    prev = v;
+  }
+  if (enc.lowNibble) {
+    StreamNibble(0);
+  }
+  StreamFlush();
+}
+
+static uint16_t streamSequence = 0;
+
+static void StreamSweep() {
+  SpectrumFrameHeader h = {
+      .fStart = GetFStart(),
+      .step = scanInfo.scanStep,
+      .bins = scanInfo.measurementsCount,
+      .sequence = streamSequence++,
+      .ticks = gGlobalSysTickCounter,
+      .flags = stream.flags & SPECTRUM_STREAM_DELTA,
+  };
+
+  EncodeSweep(false);
+  h.crc = enc.crc;
+
+  UART_BeginFrame(0x0612, sizeof(h) + enc.size);
+  UART_WriteFrame(&h, sizeof(h));
+  EncodeSweep(true);
+  UART_EndFrame();
+}
+#endif
+
+static void UpdateSweepDone() {
   MoveHistory();
+#ifdef SPECTRUM_WATERFALL
+  PushWaterfall();
+#endif
+  UpdateSweepRate();
+#if defined(ENABLE_UART) && defined(ENABLE_UART_CAT)
+  if (stream.flags & SPECTRUM_STREAM_ENABLE) {
+    StreamSweep();
+  }
+#endif
+
+  shadowHitsPerSweep = gBK4819_ShadowHits - shadowHitsAtSweepStart;
+  shadowHitsAtSweepStart = gBK4819_ShadowHits;
 
   redrawScreen = true;
   preventKeypress = false;
 
   UpdatePeakInfo();
-  if (IsPeakOverLevel()) {
+  const SignalPeak *p = LowestActivePeak();
+  if (p) {
+    SelectPeak(p);
+    peakHopped = false;
     ToggleRX(true);
     TuneToPeak();
     return;
   }
 
-  newScanStart = true;
+  // the sampler is already on the next sweep
+  ResetScanStats();
+}
+
+static void UpdateScan() {
+  Sample s;
+
+  if (!sampler.running) {
+    SamplerStart();
+  }
+
+  while (SamplerPop(&s)) {
+    if (s.i == SAMPLE_SWEEP_END) {
+      sweepJitterUS = s.rssi;
+      UpdateSweepDone();
+      return;
+    }
+    ++peak.t;
+    scanInfo.i = s.i;
+    scanInfo.f = sampler.fStart + s.i * sampler.step;
+    StoreRssi(s.rssi);
+    UpdateScanInfo();
+  }
 }
 uint16_t screenRedrawT = 0;
 static void UpdateStill() {
@@ -1312,6 +2251,11 @@ static void UpdateListening() {
 
   MoveHistory();
 
+  if (currentState == SPECTRUM && !monitorMode) {
+    ListenNextPeak();
+    return;
+  }
+
   if (IsPeakOverLevel() || monitorMode) {
     listenT = currentState == SPECTRUM ? 1000 : 10;
     return;
@@ -1331,6 +2275,9 @@ static void Tick() {
     __enable_irq();
   }
 #endif
+  if (streamPending) {
+    ApplyStream();
+  }
   if (newScanStart) {
     InitScan();
     newScanStart = false;
@@ -1399,6 +2346,9 @@ void APP_RunSpectrum() {
   BK4819_SetModulation(settings.modulationType);
 
   RelaunchScan();
+  if (streamPending) {
+    ApplyStream();
+  }
 
   memset(rssiHistory, 0, 128);
 
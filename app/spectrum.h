@@ -20,6 +20,7 @@
 #include "../am_fix.h"
 #include "../app/finput.h"
 #include "../app/uart.h"
+#include "../audio.h"
 #include "../bitmaps.h"
 #include "../board.h"
 #include "../bsp/dp32g030/gpio.h"
@@ -47,6 +48,17 @@
 
 static const uint8_t DrawingEndY = 40;
 
+// The waterfall and peak list views take pages 3..5 under a shorter trace
+static const uint8_t ShortTraceEndY = 16;
+
+#ifdef SPECTRUM_WATERFALL
+#define WATERFALL_LINES 24
+#define WATERFALL_PAGE 3
+#endif
+
+#define PEAKS_MAX 8
+#define PEAKS_PAGE 3
+
 static const uint8_t gStepSettingToIndex[] = {
     [STEP_2_5kHz] = 4,  [STEP_5_0kHz] = 5,  [STEP_6_25kHz] = 6,
     [STEP_10_0kHz] = 8, [STEP_12_5kHz] = 9, [STEP_25_0kHz] = 10,
@@ -66,10 +78,29 @@ typedef enum StepsCount {
   STEPS_16,
 } StepsCount;
 
+// Wide sweeps scan 128 << n bins and max-hold them into the 128 px trace
+typedef enum WideSteps {
+  WIDE_OFF,
+  WIDE_256,
+  WIDE_512,
+  WIDE_1024,
+} WideSteps;
+
+// What is shown under the trace, cycled with SIDE2
+typedef enum SpectrumView {
+  VIEW_TRACE,
+#ifdef SPECTRUM_WATERFALL
+  VIEW_WATERFALL,
+#endif
+  VIEW_PEAKS,
+  VIEW_COUNT,
+} SpectrumView;
+
 typedef STEP_Setting_t ScanStep;
 
 typedef struct SpectrumSettings {
   StepsCount stepsCount;
+  WideSteps wideSteps;
   ScanStep scanStepIndex;
   uint32_t frequencyChangeStep;
   uint16_t rssiTriggerLevel;
@@ -78,6 +109,10 @@ typedef struct SpectrumSettings {
   BK4819_FilterBandwidth_t listenBw;
   ModulationType modulationType;
   uint16_t delayUS;
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+  uint8_t squelchMargin; // trigger over the noise floor, 0.5 dB
+#endif
+  SpectrumView view;
 } SpectrumSettings;
 
 typedef struct KeyboardState {
@@ -88,27 +123,87 @@ typedef struct KeyboardState {
 
 typedef struct ScanInfo {
   uint16_t rssi, rssiMin, rssiMax;
-  uint8_t i, iPeak;
+  uint16_t i, iPeak;
   uint32_t f, fPeak;
   uint16_t scanStep;
-  uint8_t measurementsCount;
+  uint16_t measurementsCount;
   bool gotRssi;
 } ScanInfo;
 
 typedef struct PeakInfo {
   uint16_t t;
   uint16_t rssi;
-  uint8_t i;
+  uint16_t i;
   uint32_t f;
 } PeakInfo;
 
+// A local maximum of the last sweep, i is the scan bin
+typedef struct SignalPeak {
+  uint16_t i;
+  uint16_t rssi;
+} SignalPeak;
+
+#ifndef SPECTRUM_MOV_DEPTH
+#define SPECTRUM_MOV_DEPTH 4
+#endif
+
+#if SPECTRUM_MOV_DEPTH == 2
+#define MOV_SHIFT 1
+#elif SPECTRUM_MOV_DEPTH == 4
+#define MOV_SHIFT 2
+#elif SPECTRUM_MOV_DEPTH == 8
+#define MOV_SHIFT 3
+#elif SPECTRUM_MOV_DEPTH == 16
+#define MOV_SHIFT 4
+#else
+#error "SPECTRUM_MOV_DEPTH must be 2, 4, 8 or 16"
+#endif
+
 typedef struct MovingAverage {
   uint16_t mean[128];
-  uint16_t buf[4][128];
+#ifdef SPECTRUM_MOV_EXPONENTIAL
+  uint16_t acc[128]; // mean << MOV_SHIFT
+#else
+  uint16_t sum[128];
+  uint16_t buf[SPECTRUM_MOV_DEPTH][128]; // ring indexed by head
+  uint8_t head;
+#endif
   uint16_t min, mid, max;
   uint16_t t;
 } MovingAverage;
 
+// PC panadapter stream, set with UART command 0x0610. Zero fields keep the
+// current sweep setting; SPECTRUM_ConfigureStream() writes back what applies.
+typedef struct SpectrumStreamConfig {
+  uint32_t fStart; // 10 Hz
+  uint16_t step;   // 10 Hz, snapped to StepFrequencyTable
+  uint16_t bins;   // 16..1024, snapped to a power of two
+  uint16_t delayUS;
+  uint8_t flags;
+  uint8_t padding;
+} SpectrumStreamConfig;
+
+#define SPECTRUM_STREAM_ENABLE 0x01U
+#define SPECTRUM_STREAM_DELTA 0x02U // 4-bit deltas instead of 8-bit RSSI
+#define SPECTRUM_STREAM_LAUNCH 0x04U // open the spectrum app if not running
+#define SPECTRUM_STREAM_REFUSED 0x08U // reply only: busy in TX/RX, not opened
+
+// Payload of the 0x0612 frame pushed after every sweep, followed by the bins
+// in 1 dB units (0 = not measured) as 8-bit values or, with
+// SPECTRUM_STREAM_DELTA, as nibbles high first: the first bin in two
+// nibbles, then a signed delta of -7..7 per bin, or 8 and two nibbles of the
+// absolute value.
+typedef struct SpectrumFrameHeader {
+  uint32_t fStart;
+  uint16_t step;
+  uint16_t bins;
+  uint16_t sequence;
+  uint16_t ticks; // 10 ms system ticks when the sweep completed
+  uint16_t crc;   // CRC-16/XMODEM of the bin data
+  uint8_t flags;
+  uint8_t padding;
+} SpectrumFrameHeader;
+
 typedef struct FreqPreset {
   char name[16];
   uint32_t fStart;
@@ -365,6 +460,10 @@ static const RegisterSpec hiddenRegisterSpecs[] = {
 };
 #endif
 
+extern bool gSpectrumLaunchRequest;
+
 void APP_RunSpectrum(void);
+void SPECTRUM_ConfigureStream(SpectrumStreamConfig *pConfig);
+bool SPECTRUM_CanLaunch(void);
 
 #endif /* ifndef SPECTRUM_H */
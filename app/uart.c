@@ -33,6 +33,7 @@
 #include "driver/uart.h"
 #include "functions.h"
 #include "misc.h"
+#include "scheduler.h"
 #include "settings.h"
 #if defined(ENABLE_OVERLAY)
 #include "sram-overlay.h"
@@ -43,9 +44,23 @@
 #include "../driver/system.h"
 #include "external/printf/printf.h"
 #endif
+#if defined(ENABLE_UART_CAT) && defined(ENABLE_SPECTRUM)
+#include "app/spectrum.h"
+#endif
 
 #define DMA_INDEX(x, y) (((x) + (y)) % sizeof(UART_DMA_Buffer))
 
+#if defined(ENABLE_UART_BULK)
+#define BULK_BAUD_MAX 230400U
+#define BULK_BLOCK_SIZE 128U
+// Write blocks the host may send before waiting for the window reply. Three
+// framed 128-byte blocks fit in the 512-byte RX ring.
+#define BULK_WINDOW 3U
+#define BULK_READ_WINDOW 1024U
+// 10ms ticks without traffic before the link drops back to the default rate
+#define BULK_IDLE_TIMEOUT 300U
+#endif
+
 typedef struct {
   uint16_t ID;
   uint16_t Size;
@@ -170,6 +185,99 @@ typedef struct {
   } Data;
 } REPLY_0602_t;
 
+typedef struct {
+  Header_t Header;
+} CMD_0603_t;
+
+// Counters are running totals; sample twice and divide by the tick delta for
+// a rate.
+typedef struct {
+  Header_t Header;
+  struct {
+    uint32_t Writes;        // BK4819 register writes sent
+    uint32_t WritesAvoided; // writes skipped by BK4819_SetupRx()
+    uint32_t Ticks;         // 10 ms system ticks
+    uint32_t IsrCycles;     // last SysTick handler run, core cycles
+    uint32_t IsrCyclesMax;  // longest run since the previous 0x0603
+    uint8_t IdlePercent;    // main loop asleep over the last 500 ms
+    uint8_t Padding[3];
+  } Data;
+} REPLY_0603_t;
+
+#if defined(ENABLE_UART_CAT) && defined(ENABLE_SPECTRUM)
+typedef struct {
+  Header_t Header;
+  SpectrumStreamConfig Config;
+} CMD_0610_t;
+
+// The settings actually applied, after snapping to what the sweep supports
+typedef struct {
+  Header_t Header;
+  SpectrumStreamConfig Data;
+} REPLY_0611_t;
+#endif
+
+#if defined(ENABLE_UART_BULK)
+typedef struct {
+  Header_t Header;
+  uint32_t BaudRate;
+  uint32_t Timestamp;
+} CMD_0540_t;
+
+typedef struct {
+  Header_t Header;
+  struct {
+    uint32_t BaudRate;
+    uint8_t Window;
+    uint8_t BlockSize;
+    uint16_t ReadWindow;
+  } Data;
+} REPLY_0540_t;
+
+typedef struct {
+  Header_t Header;
+  uint16_t Offset;
+  uint16_t Size;
+  uint32_t Timestamp;
+} CMD_0542_t;
+
+typedef struct {
+  Header_t Header;
+  struct {
+    uint16_t Offset;
+    uint8_t Size;
+    uint8_t Padding;
+    uint8_t Data[BULK_BLOCK_SIZE];
+  } Data;
+} REPLY_0543_t;
+
+typedef struct {
+  Header_t Header;
+  uint16_t Offset;
+  uint16_t Size;
+  uint32_t Timestamp;
+} CMD_0546_t;
+
+typedef struct {
+  Header_t Header;
+  uint16_t Offset;
+  uint8_t Size;
+  uint8_t Padding;
+  uint8_t Data[0];
+} CMD_0547_t;
+
+typedef struct {
+  Header_t Header;
+  struct {
+    uint16_t Offset;
+    uint16_t Size;
+    uint16_t CRC;
+    bool bOk;
+    uint8_t Padding;
+  } Data;
+} REPLY_0545_t;
+#endif
+
 static const uint8_t Obfuscation[16] = {0x16, 0x6C, 0x14, 0xE6, 0x2E, 0x91,
                                         0x0D, 0x40, 0x21, 0x35, 0xD5, 0x40,
                                         0x13, 0x03, 0xE9, 0x80};
@@ -186,6 +294,23 @@ static uint32_t Timestamp;
 static uint16_t gUART_WriteIndex;
 static bool bIsEncrypted = true;
 
+// payload bytes of the frame being sent by UART_WriteFrame()
+static uint16_t gFrameIndex;
+static uint16_t gFrameSize;
+
+#if defined(ENABLE_UART_BULK)
+static struct {
+  uint16_t Start;
+  uint16_t Offset;
+  uint16_t End;
+  uint16_t CRC;
+  bool bActive;
+  bool bOk;
+  bool bFastLink;
+  uint32_t LastTraffic; // gGlobalSysTickCounter when bytes last arrived
+} gBulk;
+#endif
+
 static void SendReply(void *pReply, uint16_t Size) {
   Header_t Header;
   Footer_t Footer;
@@ -215,6 +340,59 @@ static void SendReply(void *pReply, uint16_t Size) {
   UART_Send(&Footer, sizeof(Footer));
 }
 
+static void SendFramePart(const uint8_t *pData, uint16_t Size) {
+  uint8_t Chunk[16];
+
+  while (Size) {
+    const uint8_t Count = Size < sizeof(Chunk) ? Size : sizeof(Chunk);
+
+    for (uint8_t i = 0; i < Count; i++) {
+      Chunk[i] = pData[i];
+      if (bIsEncrypted) {
+        Chunk[i] ^= Obfuscation[(gFrameIndex + i) % 16];
+      }
+    }
+    UART_Send(Chunk, Count);
+    gFrameIndex += Count;
+    pData += Count;
+    Size -= Count;
+  }
+}
+
+void UART_BeginFrame(uint16_t ID, uint16_t Size) {
+  Header_t Header;
+
+  gFrameIndex = 0;
+  gFrameSize = Size + sizeof(Header);
+
+  Header.ID = 0xCDAB;
+  Header.Size = gFrameSize;
+  UART_Send(&Header, sizeof(Header));
+
+  Header.ID = ID;
+  Header.Size = Size;
+  SendFramePart((const uint8_t *)&Header, sizeof(Header));
+}
+
+void UART_WriteFrame(const void *pData, uint16_t Size) {
+  SendFramePart((const uint8_t *)pData, Size);
+}
+
+void UART_EndFrame(void) {
+  Footer_t Footer;
+
+  if (bIsEncrypted) {
+    Footer.Padding[0] = Obfuscation[(gFrameSize + 0) % 16] ^ 0xFF;
+    Footer.Padding[1] = Obfuscation[(gFrameSize + 1) % 16] ^ 0xFF;
+  } else {
+    Footer.Padding[0] = 0xFF;
+    Footer.Padding[1] = 0xFF;
+  }
+  Footer.ID = 0xBADC;
+
+  UART_Send(&Footer, sizeof(Footer));
+}
+
 static void SendVersion(void) {
   REPLY_0514_t Reply;
 
@@ -290,6 +468,32 @@ static void CMD_051B(const uint8_t *pBuffer) {
   SendReply(&Reply, pCmd->Size + 8);
 }
 
+static void WriteConfig(uint16_t Offset, const uint8_t *pData, uint16_t Size,
+                        bool bAllowPassword, bool *pbReloadEeprom) {
+  uint16_t i;
+
+  EEPROM_BeginBatch();
+  for (i = 0; i < Size; i += 8U) {
+    if (Offset + i >= 0x0F30 && Offset + i < 0x0F40) {
+      if (!gIsLocked) {
+        *pbReloadEeprom = true;
+      }
+    }
+
+    if ((Offset + i < 0x0E98 || Offset + i >= 0x0EA0) || !bIsInLockScreen ||
+        bAllowPassword) {
+      EEPROM_WriteBuffer(Offset + i, &pData[i]);
+    }
+  }
+  EEPROM_EndBatch();
+  SETTINGS_InvalidateChannelCache();
+  // calibration, VOX, mic and misc tables live in 0x1E00-0x1F8F
+  if (Offset < 0x1F90 && Offset + Size > 0x1E00) {
+    BOARD_EEPROM_LoadCalibration();
+    gFlagReconfigureVfos = true;
+  }
+}
+
 static void CMD_051D(const uint8_t *pBuffer) {
   const CMD_051D_t *pCmd = (const CMD_051D_t *)pBuffer;
   REPLY_051D_t Reply;
@@ -315,22 +519,8 @@ static void CMD_051D(const uint8_t *pBuffer) {
   }
 
   if (!bIsLocked) {
-    uint16_t i;
-
-    for (i = 0; i < (pCmd->Size / 8U); i++) {
-      uint16_t Offset = pCmd->Offset + (i * 8U);
-
-      if (Offset >= 0x0F30 && Offset < 0x0F40) {
-        if (!gIsLocked) {
-          bReloadEeprom = true;
-        }
-      }
-
-      if ((Offset < 0x0E98 || Offset >= 0x0EA0) || !bIsInLockScreen ||
-          pCmd->bAllowPassword) {
-        EEPROM_WriteBuffer(Offset, &pCmd->Data[i * 8U]);
-      }
-    }
+    WriteConfig(pCmd->Offset, pCmd->Data, pCmd->Size & ~7U,
+                pCmd->bAllowPassword, &bReloadEeprom);
 
     if (bReloadEeprom) {
       BOARD_EEPROM_Init();
@@ -419,6 +609,150 @@ static void CMD_052F(const uint8_t *pBuffer) {
   SendVersion();
 }
 
+#if defined(ENABLE_UART_BULK)
+
+static bool IsBulkLocked(void) {
+  return bHasCustomAesKey && gIsLocked;
+}
+
+// Switches the link speed once the reply has left at the old rate. The host
+// must wait for the 0x0541 reply before reopening the port at the new rate.
+static void CMD_0540(const uint8_t *pBuffer) {
+  const CMD_0540_t *pCmd = (const CMD_0540_t *)pBuffer;
+  REPLY_0540_t Reply;
+  uint32_t BaudRate;
+
+  if (pCmd->Timestamp != Timestamp) {
+    return;
+  }
+
+  BaudRate = pCmd->BaudRate;
+  if (BaudRate < UART_BAUD_DEFAULT) {
+    BaudRate = UART_BAUD_DEFAULT;
+  } else if (BaudRate > BULK_BAUD_MAX) {
+    BaudRate = BULK_BAUD_MAX;
+  }
+
+  Reply.Header.ID = 0x0541;
+  Reply.Header.Size = sizeof(Reply.Data);
+  Reply.Data.BaudRate = BaudRate;
+  Reply.Data.Window = BULK_WINDOW;
+  Reply.Data.BlockSize = BULK_BLOCK_SIZE;
+  Reply.Data.ReadWindow = BULK_READ_WINDOW;
+  SendReply(&Reply, sizeof(Reply));
+
+  UART_SetBaudRate(BaudRate);
+  gBulk.bActive = false;
+  gBulk.bFastLink = BaudRate != UART_BAUD_DEFAULT;
+  gBulk.LastTraffic = gGlobalSysTickCounter;
+}
+
+static void SendBulkStatus(uint16_t Offset, uint16_t Size, uint16_t CRC,
+                           bool bOk) {
+  REPLY_0545_t Reply;
+
+  Reply.Header.ID = 0x0545;
+  Reply.Header.Size = sizeof(Reply.Data);
+  Reply.Data.Offset = Offset;
+  Reply.Data.Size = Size;
+  Reply.Data.CRC = CRC;
+  Reply.Data.bOk = bOk;
+  Reply.Data.Padding = 0;
+  SendReply(&Reply, sizeof(Reply));
+}
+
+// Streams up to BULK_READ_WINDOW bytes as back-to-back 0x0543 blocks followed
+// by a single 0x0545 carrying the CRC of the whole window.
+static void CMD_0542(const uint8_t *pBuffer) {
+  const CMD_0542_t *pCmd = (const CMD_0542_t *)pBuffer;
+  REPLY_0543_t Reply;
+  uint16_t Offset;
+  uint16_t End;
+  uint16_t CRC;
+  bool bOk;
+
+  if (pCmd->Timestamp != Timestamp) {
+    return;
+  }
+
+  Offset = pCmd->Offset;
+  End = Offset + pCmd->Size;
+  bOk = !IsBulkLocked() && pCmd->Size <= BULK_READ_WINDOW && End <= 0x2000;
+  CRC = 0;
+
+  while (bOk && Offset < End) {
+    uint8_t Size = End - Offset < BULK_BLOCK_SIZE ? End - Offset
+                                                  : BULK_BLOCK_SIZE;
+
+    Reply.Header.ID = 0x0543;
+    Reply.Header.Size = Size + 4;
+    Reply.Data.Offset = Offset;
+    Reply.Data.Size = Size;
+    Reply.Data.Padding = 0;
+    EEPROM_ReadBuffer(Offset, Reply.Data.Data, Size);
+    CRC = CRC_Update(CRC, Reply.Data.Data, Size);
+    SendReply(&Reply, Size + 8);
+    Offset += Size;
+  }
+
+  SendBulkStatus(pCmd->Offset, pCmd->Size, CRC, bOk);
+}
+
+// Opens a write window. Its blocks arrive as 0x0547 without waiting for
+// replies; the window is acknowledged once.
+static void CMD_0546(const uint8_t *pBuffer) {
+  const CMD_0546_t *pCmd = (const CMD_0546_t *)pBuffer;
+  const uint16_t End = pCmd->Offset + pCmd->Size;
+
+  if (pCmd->Timestamp != Timestamp) {
+    return;
+  }
+
+  gBulk.Start = pCmd->Offset;
+  gBulk.Offset = pCmd->Offset;
+  gBulk.End = End;
+  gBulk.CRC = 0;
+  gBulk.bOk = true;
+  gBulk.bActive = !IsBulkLocked() && (pCmd->Offset & 7U) == 0 &&
+                  (pCmd->Size & 7U) == 0 && pCmd->Size != 0 &&
+                  pCmd->Size <= BULK_WINDOW * BULK_BLOCK_SIZE && End <= 0x2000;
+  if (!gBulk.bActive) {
+    SendBulkStatus(pCmd->Offset, pCmd->Size, 0, false);
+  }
+}
+
+static void CMD_0547(const uint8_t *pBuffer) {
+  const CMD_0547_t *pCmd = (const CMD_0547_t *)pBuffer;
+  bool bReloadEeprom = false;
+
+  if (!gBulk.bActive) {
+    return;
+  }
+
+  // Blocks must arrive in order and stay inside the announced window, so a
+  // corrupted header can never land data outside of it.
+  if (pCmd->Offset != gBulk.Offset || (pCmd->Size & 7U) ||
+      pCmd->Size > BULK_BLOCK_SIZE || pCmd->Offset + pCmd->Size > gBulk.End) {
+    gBulk.bOk = false;
+  } else {
+    WriteConfig(pCmd->Offset, pCmd->Data, pCmd->Size, false, &bReloadEeprom);
+    gBulk.CRC = CRC_Update(gBulk.CRC, pCmd->Data, pCmd->Size);
+    gBulk.Offset += pCmd->Size;
+  }
+
+  if (!gBulk.bOk || gBulk.Offset == gBulk.End) {
+    gBulk.bActive = false;
+    SendBulkStatus(gBulk.Start, gBulk.Offset - gBulk.Start, gBulk.CRC,
+                   gBulk.bOk);
+  }
+
+  if (bReloadEeprom) {
+    BOARD_EEPROM_Init();
+  }
+}
+
+#endif
+
 #ifdef ENABLE_UART_CAT
 
 static void CMD_0601(const uint8_t *pBuffer) {
@@ -446,6 +780,40 @@ static void CMD_0602(const uint8_t *pBuffer) {
   SendReply(&Reply, sizeof(Reply));
 }
 
+static void CMD_0603(const uint8_t *pBuffer) {
+  REPLY_0603_t Reply;
+
+  (void)pBuffer;
+  Reply.Header.ID = 0x0603;
+  Reply.Header.Size = sizeof(Reply.Data);
+  Reply.Data.Writes = gBK4819_Writes;
+  Reply.Data.WritesAvoided = gBK4819_WritesAvoided;
+  Reply.Data.Ticks = gGlobalSysTickCounter;
+  Reply.Data.IsrCycles = gSystickIsrCycles;
+  Reply.Data.IsrCyclesMax = gSystickIsrCyclesMax;
+  gSystickIsrCyclesMax = 0;
+  Reply.Data.IdlePercent = gIdlePercent;
+  memset(Reply.Data.Padding, 0, sizeof(Reply.Data.Padding));
+
+  SendReply(&Reply, sizeof(Reply));
+}
+
+#if defined(ENABLE_SPECTRUM)
+// Configures the panadapter stream. Sweeps are then pushed as 0x0612 frames
+// for as long as the spectrum app runs with streaming enabled.
+static void CMD_0610(const uint8_t *pBuffer) {
+  const CMD_0610_t *pCmd = (const CMD_0610_t *)pBuffer;
+  REPLY_0611_t Reply;
+
+  Reply.Header.ID = 0x0611;
+  Reply.Header.Size = sizeof(Reply.Data);
+  Reply.Data = pCmd->Config;
+  SPECTRUM_ConfigureStream(&Reply.Data);
+
+  SendReply(&Reply, sizeof(Reply));
+}
+#endif
+
 #endif
 
 uint64_t xtou64(const char *str) {
@@ -470,6 +838,18 @@ bool UART_IsCommandAvailable(void) {
   uint16_t i;
 
   DmaLength = DMA_CH0->ST & 0xFFFU;
+#if defined(ENABLE_UART_BULK)
+  // Fall back to the default rate if the host went away mid-session.
+  if (gBulk.bFastLink) {
+    if (gUART_WriteIndex != DmaLength) {
+      gBulk.LastTraffic = gGlobalSysTickCounter;
+    } else if (gGlobalSysTickCounter - gBulk.LastTraffic >= BULK_IDLE_TIMEOUT) {
+      UART_SetBaudRate(UART_BAUD_DEFAULT);
+      gBulk.bFastLink = false;
+      gBulk.bActive = false;
+    }
+  }
+#endif
   while (1) {
     if (gUART_WriteIndex == DmaLength) {
       return false;
@@ -500,7 +880,8 @@ bool UART_IsCommandAvailable(void) {
 
   Index = DMA_INDEX(gUART_WriteIndex, 2);
   Size = (UART_DMA_Buffer[DMA_INDEX(Index, 1)] << 8) | UART_DMA_Buffer[Index];
-  if (Size + 8 > sizeof(UART_DMA_Buffer)) {
+  if (Size + 8 > sizeof(UART_DMA_Buffer) ||
+      Size + 8 > sizeof(UART_Command.Buffer)) {
     gUART_WriteIndex = DmaLength;
     return false;
   }
@@ -600,6 +981,20 @@ void UART_HandleCommand(void) {
     NVIC_SystemReset();
 #endif
     break;
+#if defined(ENABLE_UART_BULK)
+  case 0x0540:
+    CMD_0540(UART_Command.Buffer);
+    break;
+  case 0x0542:
+    CMD_0542(UART_Command.Buffer);
+    break;
+  case 0x0546:
+    CMD_0546(UART_Command.Buffer);
+    break;
+  case 0x0547:
+    CMD_0547(UART_Command.Buffer);
+    break;
+#endif
 #ifdef ENABLE_UART_CAT
   case 0x0601:
     CMD_0601(UART_Command.Buffer);
@@ -607,6 +1002,14 @@ void UART_HandleCommand(void) {
   case 0x0602:
     CMD_0602(UART_Command.Buffer);
     break;
+  case 0x0603:
+    CMD_0603(UART_Command.Buffer);
+    break;
+#if defined(ENABLE_SPECTRUM)
+  case 0x0610:
+    CMD_0610(UART_Command.Buffer);
+    break;
+#endif
 #endif
   }
 }
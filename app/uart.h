@@ -18,9 +18,16 @@
 #define APP_UART_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 bool UART_IsCommandAvailable(void);
 void UART_HandleCommand(void);
 
+// Unsolicited frames too large to stage in RAM go out in parts: Begin with
+// the payload size, Write exactly that many bytes, then End.
+void UART_BeginFrame(uint16_t ID, uint16_t Size);
+void UART_WriteFrame(const void *pData, uint16_t Size);
+void UART_EndFrame(void);
+
 #endif
 
@@ -14,6 +14,8 @@
  *     limitations under the License.
  */
 
+#include <string.h>
+
 #if defined(ENABLE_FMRADIO)
 #include "app/fm.h"
 #endif
@@ -28,33 +30,69 @@
 #include "driver/systick.h"
 #include "functions.h"
 #include "misc.h"
+#include "scheduler.h"
 #include "settings.h"
 #include "ui/ui.h"
+
+#define AUDIO_QUEUE_SIZE 4
+
+enum {
+  SOUND_BEEP,
+  SOUND_MELODY,
+  SOUND_ROGER,
+  SOUND_ROGER_MDC,
+  SOUND_DTMF,
+};
+
+typedef struct {
+  uint8_t Sound;
+  BEEP_Type_t Beep;
+  const Note *pMelody;
+  uint8_t Size;
+  // a copy, as callers build DTMF strings in buffers they reuse
+  char String[20];
+  uint16_t Preload;
+  bool bDelayFirst;
+  bool bKeep;
+  void (*pDone)(void);
+} Request_t;
+
 BEEP_Type_t gBeepToPlay;
 
-void AUDIO_PlayBeep(BEEP_Type_t Beep) {
-  uint16_t ToneConfig;
-  uint16_t ToneFrequency;
-  uint16_t Duration;
+static Request_t gQueue[AUDIO_QUEUE_SIZE];
+static uint8_t gQueueHead;
+static uint8_t gQueueCount;
+static bool gPlaying;
+static uint8_t gStep;
+static volatile bool gStepDue;
+static SCHEDULER_Timer_t gStepTimer = {.pFlag = &gStepDue};
 
-  if (Beep != BEEP_500HZ_60MS_DOUBLE_BEEP && Beep != BEEP_440HZ_500MS &&
-      !gEeprom.BEEP_CONTROL) {
-    return;
-  }
+// Saved by the first step of a beep or melody for the last one.
+static uint16_t gToneConfig;
 
+static bool CanPlay(void) {
 #if defined(ENABLE_AIRCOPY)
   if (gScreenToDisplay == DISPLAY_AIRCOPY) {
-    return;
+    return false;
   }
 #endif
-  if (gCurrentFunction == FUNCTION_RECEIVE) {
-    return;
-  }
-  if (gCurrentFunction == FUNCTION_MONITOR) {
+  return gCurrentFunction != FUNCTION_RECEIVE &&
+         gCurrentFunction != FUNCTION_MONITOR;
+}
+
+static void Enqueue(const Request_t *pRequest) {
+  if (gQueueCount == AUDIO_QUEUE_SIZE) {
+    if (pRequest->pDone) {
+      pRequest->pDone();
+    }
     return;
   }
+  gQueue[(gQueueHead + gQueueCount) % AUDIO_QUEUE_SIZE] = *pRequest;
+  gQueueCount++;
+}
 
-  ToneConfig = BK4819_ReadRegister(BK4819_REG_71);
+static void MuteOthers(void) {
+  gToneConfig = BK4819_ReadRegister(BK4819_REG_71);
 
   GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
 
@@ -67,49 +105,9 @@ void AUDIO_PlayBeep(BEEP_Type_t Beep) {
     BK1080_Mute(true);
   }
 #endif
-  SYSTEM_DelayMs(20);
-  switch (Beep) {
-  case BEEP_TEST:
-    ToneFrequency = 4000;
-    break;
-  case BEEP_1KHZ_60MS_OPTIONAL:
-    ToneFrequency = 1000;
-    break;
-  case BEEP_500HZ_60MS_DOUBLE_BEEP_OPTIONAL:
-  case BEEP_500HZ_60MS_DOUBLE_BEEP:
-    ToneFrequency = 500;
-    break;
-  default:
-    ToneFrequency = 440;
-    break;
-  }
-  BK4819_PlayTone(ToneFrequency, true);
-  SYSTEM_DelayMs(2);
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-  SYSTEM_DelayMs(60);
-
-  switch (Beep) {
-  case BEEP_500HZ_60MS_DOUBLE_BEEP_OPTIONAL:
-  case BEEP_500HZ_60MS_DOUBLE_BEEP:
-    BK4819_ExitTxMute();
-    SYSTEM_DelayMs(60);
-    BK4819_EnterTxMute();
-    SYSTEM_DelayMs(20);
-    // Fallthrough
-  case BEEP_1KHZ_60MS_OPTIONAL:
-    BK4819_ExitTxMute();
-    Duration = 60;
-    break;
-  case BEEP_440HZ_500MS:
-  default:
-    BK4819_ExitTxMute();
-    Duration = 500;
-    break;
-  }
+}
 
-  SYSTEM_DelayMs(Duration);
-  BK4819_EnterTxMute();
-  SYSTEM_DelayMs(20);
+static void RestoreOthers(void) {
   GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
 
   gVoxResumeCountdown = 80;
@@ -117,7 +115,7 @@ void AUDIO_PlayBeep(BEEP_Type_t Beep) {
   SYSTEM_DelayMs(5);
   BK4819_TurnsOffTones_TurnsOnRX();
   SYSTEM_DelayMs(5);
-  BK4819_WriteRegister(BK4819_REG_71, ToneConfig);
+  BK4819_WriteRegister(BK4819_REG_71, gToneConfig);
   if (gEnableSpeaker) {
     GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
   }
@@ -126,76 +124,274 @@ void AUDIO_PlayBeep(BEEP_Type_t Beep) {
     BK1080_Mute(false);
   }
 #endif
+  // the radio may have left power save while the sound played
   if (gCurrentFunction == FUNCTION_POWER_SAVE && gRxIdleMode) {
     BK4819_Sleep();
   }
 }
 
-void AUDIO_PlayMelody(const Note *melody, uint8_t size) {
+static uint16_t PlayBeep(BEEP_Type_t Beep, uint8_t *pStep) {
+  uint16_t ToneFrequency;
 
-  if (gCurrentFunction == FUNCTION_RECEIVE ||
-      gCurrentFunction == FUNCTION_MONITOR
-#if defined(ENABLE_AIRCOPY)
-      || gScreenToDisplay == DISPLAY_AIRCOPY
-#endif
-  ) {
-    return;
+  switch ((*pStep)++) {
+  case 0:
+    if (!CanPlay()) {
+      return 0;
+    }
+    MuteOthers();
+    return 20;
+
+  case 1:
+    switch (Beep) {
+    case BEEP_TEST:
+      ToneFrequency = 4000;
+      break;
+    case BEEP_1KHZ_60MS_OPTIONAL:
+      ToneFrequency = 1000;
+      break;
+    case BEEP_500HZ_60MS_DOUBLE_BEEP_OPTIONAL:
+    case BEEP_500HZ_60MS_DOUBLE_BEEP:
+      ToneFrequency = 500;
+      break;
+    default:
+      ToneFrequency = 440;
+      break;
+    }
+    BK4819_PlayTone(ToneFrequency, true);
+    SYSTEM_DelayMs(2);
+    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+    return 60;
+
+  case 2:
+    BK4819_ExitTxMute();
+    switch (Beep) {
+    case BEEP_500HZ_60MS_DOUBLE_BEEP_OPTIONAL:
+    case BEEP_500HZ_60MS_DOUBLE_BEEP:
+      return 60;
+    case BEEP_1KHZ_60MS_OPTIONAL:
+      *pStep = 5;
+      return 60;
+    case BEEP_440HZ_500MS:
+    default:
+      *pStep = 5;
+      return 500;
+    }
+
+  case 3:
+    BK4819_EnterTxMute();
+    return 20;
+
+  case 4:
+    BK4819_ExitTxMute();
+    return 60;
+
+  case 5:
+    BK4819_EnterTxMute();
+    return 20;
+
+  default:
+    RestoreOthers();
+    return 0;
+  }
+}
+
+static uint16_t PlayMelody(const Note *melody, uint8_t size, uint8_t *pStep) {
+  const uint8_t i = (*pStep)++;
+
+  if (i == 0) {
+    if (!CanPlay()) {
+      return 0;
+    }
+    MuteOthers();
+
+    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+
+    // START notes
+    BK4819_EnterTxMute();
+    BK4819_SetAF(BK4819_AF_BEEP);
+    BK4819_WriteRegister(BK4819_REG_70,
+                         0 | BK4819_REG_70_ENABLE_TONE1 |
+                             (96U << BK4819_REG_70_SHIFT_TONE1_TUNING_GAIN));
+    BK4819_ExitTxMute();
+
+    BK4819_WriteRegister(BK4819_REG_30, 0);
+    BK4819_WriteRegister(BK4819_REG_30, 0 | BK4819_REG_30_ENABLE_AF_DAC |
+                                            BK4819_REG_30_ENABLE_DISC_MODE |
+                                            BK4819_REG_30_ENABLE_TX_DSP);
+  }
+
+  if (i < size) {
+    BK4819_SetToneFrequency(melody[i].f);
+    return melody[i].dur;
   }
 
-  uint16_t ToneConfig = BK4819_ReadRegister(BK4819_REG_71);
+  // END notes
+  BK4819_EnterTxMute();
+  RestoreOthers();
+  return 0;
+}
+
+static uint16_t PlayDTMF(const Request_t *pRequest, uint8_t *pStep) {
+  uint8_t CodeStep = BK4819_STEP_END;
+  uint16_t Delay;
+
+  // Step 0 is the preload, 1 enters DTMF TX and the codes follow.
+  if (*pStep == 0) {
+    *pStep = 1;
+    if (gEeprom.DTMF_SIDE_TONE) {
+      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+      gEnableSpeaker = true;
+    }
+    if (pRequest->Preload) {
+      return pRequest->Preload;
+    }
+  }
+  if (*pStep == 1) {
+    BK4819_EnterDTMF_TX(gEeprom.DTMF_SIDE_TONE);
+    *pStep = 2;
+  }
+  if (*pStep != BK4819_STEP_END) {
+    CodeStep = *pStep - 2;
+  }
+  Delay = BK4819_PlayDTMFString(
+      pRequest->String, pRequest->bDelayFirst,
+      gEeprom.DTMF_FIRST_CODE_PERSIST_TIME, gEeprom.DTMF_HASH_CODE_PERSIST_TIME,
+      gEeprom.DTMF_CODE_PERSIST_TIME, gEeprom.DTMF_CODE_INTERVAL_TIME,
+      &CodeStep);
+  if (Delay) {
+    *pStep = CodeStep + 2;
+    return Delay;
+  }
 
   GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+  gEnableSpeaker = false;
+  BK4819_ExitDTMF_TX(pRequest->bKeep);
+  return 0;
+}
 
-  if (gCurrentFunction == FUNCTION_POWER_SAVE && gRxIdleMode) {
-    BK4819_RX_TurnOn();
+static uint16_t Play(const Request_t *pRequest, uint8_t *pStep) {
+  switch (pRequest->Sound) {
+  case SOUND_BEEP:
+    return PlayBeep(pRequest->Beep, pStep);
+  case SOUND_MELODY:
+    return PlayMelody(pRequest->pMelody, pRequest->Size, pStep);
+  case SOUND_ROGER:
+    return BK4819_PlayRoger(pStep);
+  case SOUND_ROGER_MDC:
+    return BK4819_PlayRogerMDC(pStep);
+  case SOUND_DTMF:
+    return PlayDTMF(pRequest, pStep);
   }
 
-#if defined(ENABLE_FMRADIO)
-  if (gFmRadioMode) {
-    BK1080_Mute(true);
+  return 0;
+}
+
+static void Finish(void) {
+  void (*pDone)(void) = gQueue[gQueueHead].pDone;
+
+  gPlaying = false;
+  gQueueHead = (gQueueHead + 1) % AUDIO_QUEUE_SIZE;
+  gQueueCount--;
+  if (pDone) {
+    pDone();
   }
-#endif
+}
 
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+void AUDIO_PlayBeep(BEEP_Type_t Beep) {
+  const Request_t Request = {.Sound = SOUND_BEEP, .Beep = Beep};
 
-  // START notes
-  BK4819_EnterTxMute();
-  BK4819_SetAF(BK4819_AF_BEEP);
-  uint16_t ToneConfig2 = 0 | BK4819_REG_70_ENABLE_TONE1 |
-                         (96U << BK4819_REG_70_SHIFT_TONE1_TUNING_GAIN);
-  BK4819_WriteRegister(BK4819_REG_70, ToneConfig2);
-  BK4819_ExitTxMute();
-
-  BK4819_WriteRegister(BK4819_REG_30, 0);
-  BK4819_WriteRegister(BK4819_REG_30, 0 | BK4819_REG_30_ENABLE_AF_DAC |
-                                          BK4819_REG_30_ENABLE_DISC_MODE |
-                                          BK4819_REG_30_ENABLE_TX_DSP);
-  for (uint8_t i = 0; i < size; i++) {
-    Note n = melody[i];
-    BK4819_SetToneFrequency(n.f);
-    SYSTEM_DelayMs(n.dur);
+  if (Beep != BEEP_500HZ_60MS_DOUBLE_BEEP && Beep != BEEP_440HZ_500MS &&
+      !gEeprom.BEEP_CONTROL) {
+    return;
+  }
+  if (!CanPlay()) {
+    return;
   }
 
-  // END notes
+  Enqueue(&Request);
+}
 
-  BK4819_EnterTxMute();
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+void AUDIO_PlayMelody(const Note *melody, uint8_t size) {
+  const Request_t Request = {
+      .Sound = SOUND_MELODY,
+      .pMelody = melody,
+      .Size = size,
+  };
 
-  gVoxResumeCountdown = 80;
+  if (!CanPlay()) {
+    return;
+  }
 
-  SYSTEM_DelayMs(5);
-  BK4819_TurnsOffTones_TurnsOnRX();
-  SYSTEM_DelayMs(5);
-  BK4819_WriteRegister(BK4819_REG_71, ToneConfig);
-  if (gEnableSpeaker) {
-    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+  Enqueue(&Request);
+}
+
+void AUDIO_PlayRoger(ROGER_Mode_t Mode, void (*pDone)(void)) {
+  const Request_t Request = {
+      .Sound = Mode == ROGER_MODE_MDC ? SOUND_ROGER_MDC : SOUND_ROGER,
+      .pDone = pDone,
+  };
+
+  Enqueue(&Request);
+}
+
+void AUDIO_PlayDTMF(const char *pString, uint16_t Preload, bool bDelayFirst,
+                    bool bKeep, void (*pDone)(void)) {
+  Request_t Request = {
+      .Sound = SOUND_DTMF,
+      .Preload = Preload,
+      .bDelayFirst = bDelayFirst,
+      .bKeep = bKeep,
+      .pDone = pDone,
+  };
+
+  strncpy(Request.String, pString, sizeof(Request.String) - 1);
+  Enqueue(&Request);
+}
+
+void AUDIO_Update(void) {
+  uint16_t Delay;
+
+  if (gPlaying) {
+    if (!gStepDue) {
+      return;
+    }
+  } else {
+    if (gQueueCount == 0) {
+      return;
+    }
+    gPlaying = true;
+    gStep = 0;
   }
-#if defined(ENABLE_FMRADIO)
-  if (gFmRadioMode) {
-    BK1080_Mute(false);
+  gStepDue = false;
+
+  Delay = Play(&gQueue[gQueueHead], &gStep);
+  if (Delay) {
+    SCHEDULER_Arm(&gStepTimer, (Delay + 5) / 10);
+    return;
   }
-#endif
-  if (gCurrentFunction == FUNCTION_POWER_SAVE && gRxIdleMode) {
-    BK4819_Sleep();
+
+  Finish();
+}
+
+bool AUDIO_IsPlaying(void) { return gQueueCount != 0; }
+
+// Called from FUNCTION_Select() on the way into RX or TX, where the owners'
+// follow-ups (the EOT ID, restoring RX registers) no longer apply, so their
+// pDone is dropped rather than run in the middle of the switch.
+void AUDIO_Stop(void) {
+  SCHEDULER_Cancel(&gStepTimer);
+  gStepDue = false;
+
+  if (gPlaying) {
+    gStep = BK4819_STEP_END;
+    Play(&gQueue[gQueueHead], &gStep);
+    gPlaying = false;
+  }
+  gQueueCount = 0;
+}
+
+void AUDIO_Flush(void) {
+  while (AUDIO_IsPlaying()) {
+    AUDIO_Update();
   }
 }
@@ -17,6 +17,7 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include "settings.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -60,7 +61,22 @@ static const Note MELODY_ARKANOID[] = {
     {1568, 214}, {1397, 214}, {1760, 214}, {1568, 857},
 };
 
+// Sounds are queued and played in the background by AUDIO_Update(), which
+// runs from the 10ms timeslice. pDone is called once a sound has finished or
+// could not be queued, never for one that was stopped.
 void AUDIO_PlayBeep(BEEP_Type_t Beep);
 void AUDIO_PlayMelody(const Note *melody, uint8_t size);
+void AUDIO_PlayRoger(ROGER_Mode_t Mode, void (*pDone)(void));
+// Sends a copy of pString, up to 19 codes, after Preload ms with the side tone
+// on. bKeep leaves TX muted afterwards, as for the EOT ID.
+void AUDIO_PlayDTMF(const char *pString, uint16_t Preload, bool bDelayFirst,
+                    bool bKeep, void (*pDone)(void));
+void AUDIO_Update(void);
+bool AUDIO_IsPlaying(void);
+// Cuts the current sound short and drops the queued ones, without calling
+// their pDone.
+void AUDIO_Stop(void);
+// Plays the queue to the end, for code running outside the main loop.
+void AUDIO_Flush(void);
 
 #endif
@@ -701,6 +701,15 @@ void BOARD_EEPROM_Init(void)
 void BOARD_EEPROM_LoadCalibration(void)
 {
 	uint8_t Mic;
+	uint8_t i;
+
+	for (i = 0; i < 6; i++) {
+		EEPROM_ReadBuffer(0x1E01 + (i * 0x10), gEEPROM_Calibration.Squelch[0][i], 9);
+		EEPROM_ReadBuffer(0x1E61 + (i * 0x10), gEEPROM_Calibration.Squelch[1][i], 9);
+	}
+	for (i = 0; i < 7; i++) {
+		EEPROM_ReadBuffer(0x1ED0 + (i * 0x10), gEEPROM_Calibration.TxPower[i], 12);
+	}
 
 	EEPROM_ReadBuffer(0x1EC0, gEEPROM_RSSI_CALIB[3], 8);
 	memcpy(gEEPROM_RSSI_CALIB[4], gEEPROM_RSSI_CALIB[3], 8);
@@ -750,6 +759,7 @@ void BOARD_FactoryReset(bool bIsAll)
 	uint16_t i;
 
 	memset(Template, 0xFF, sizeof(Template));
+	EEPROM_BeginBatch();
 	for (i = 0x0C80; i < 0x1E00; i += 8) {
 		if (
 			!(i >= 0x0EE0 && i < 0x0F18) && // ANI ID + DTMF codes
@@ -767,6 +777,8 @@ void BOARD_FactoryReset(bool bIsAll)
 			EEPROM_WriteBuffer(i, Template);
 		}
 	}
+	EEPROM_EndBatch();
+	SETTINGS_InvalidateChannelCache();
 	if (bIsAll) {
 		RADIO_InitInfo(gRxVfo, FREQ_CHANNEL_FIRST + 5, 5, 41002500);
 		for (i = 0; i < 5; i++) {
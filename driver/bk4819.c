@@ -15,6 +15,7 @@
  */
 
 #include "bk4819.h"
+#include "ARMCM0.h"
 #include "../bsp/dp32g030/gpio.h"
 #include "../bsp/dp32g030/portcon.h"
 #include "../driver/gpio.h"
@@ -22,6 +23,7 @@
 #include "../driver/systick.h"
 #include "../driver/uart.h"
 #include "../misc.h"
+#include <string.h>
 
 static const uint16_t FSK_RogerTable[7] = {
     0xF1A2, 0x7446, 0x61A4, 0x6544, 0x4E8A, 0xE044, 0xEA84,
@@ -31,6 +33,44 @@ static uint16_t gBK4819_GpioOutState;
 
 bool gRxIdleMode;
 
+// Control registers that only change when we write them. Reads of these are
+// served from a write-through shadow copy instead of the bit-banged bus.
+// Status/FIFO registers (0x02, 0x0B-0x0E, 0x5F, 0x60-0x6F, ...), indexed
+// tables (0x06-0x09) and 0x7E (AGC index readback) always go to the chip.
+static const uint32_t SHADOWED_REGS[4] = {
+    0x821F0000, // 10-14 19 1F
+    0xFBCF0B13, // 20 21 24 28 29 2B 30-33 36-39 3B-3F
+    0x3D37EBF9, // 40 43-49 4B 4D-52 54 55 58 5A-5D
+    0x3F3F0000, // 70-75 78-7D
+};
+
+static uint16_t gShadowRegs[128];
+static uint32_t gShadowValid[4];
+
+// REG_07 and REG_08 are windows onto several slots, picked by the top bits of
+// the written value. They can't be read back, but remembering the last value
+// per slot lets BK4819_SetupRx() skip rewriting an unchanged sub-audio setup.
+static uint16_t gShadow07[8];
+static uint16_t gShadow08[2];
+static uint16_t gShadowIndexedValid;
+
+uint32_t gBK4819_Writes;
+uint32_t gBK4819_WritesAvoided;
+
+// Single-producer/single-consumer queue of drained interrupt requests. Only
+// the producer moves gEventHead and only the consumer moves gEventTail, so
+// either side may run from an interrupt handler.
+#define EVENT_QUEUE_SIZE 8U
+
+static volatile BK4819_Event_t gEvents[EVENT_QUEUE_SIZE];
+static volatile uint8_t gEventHead;
+static volatile uint8_t gEventTail;
+
+uint32_t gBK4819_ShadowHits;
+#if defined(ENABLE_BK4819_SHADOW_CHECK)
+uint32_t gBK4819_ShadowMismatches;
+#endif
+
 const uint8_t DTMF_COEFFS[] = {111, 107, 103, 98, 80,  71,  58,  44,
                                65,  55,  37,  23, 228, 203, 181, 159};
 
@@ -59,6 +99,15 @@ void BK4819_Init(void) {
   BK4819_WriteRegister(BK4819_REG_3F, 0);
 }
 
+// BK4819 3-wire bus only needs ~100 ns of setup/hold around each SCK edge,
+// a couple of core cycles at 48 MHz instead of a full SYSTICK_DelayUs(1).
+#define BK4819_BUS_DELAY_LOOPS 2
+
+static inline void BK4819_BusDelay(void) {
+  for (volatile uint8_t i = BK4819_BUS_DELAY_LOOPS; i; --i) {
+  }
+}
+
 static uint16_t BK4819_ReadU16(void) {
   uint8_t i;
   uint16_t Value;
@@ -66,16 +115,16 @@ static uint16_t BK4819_ReadU16(void) {
   PORTCON_PORTC_IE = (PORTCON_PORTC_IE & ~PORTCON_PORTC_IE_C2_MASK) |
                      PORTCON_PORTC_IE_C2_BITS_ENABLE;
   GPIOC->DIR = (GPIOC->DIR & ~GPIO_DIR_2_MASK) | GPIO_DIR_2_BITS_INPUT;
-  SYSTICK_DelayUs(1);
+  BK4819_BusDelay();
 
   Value = 0;
   for (i = 0; i < 16; i++) {
     Value <<= 1;
     Value |= GPIO_CheckBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
-    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-    SYSTICK_DelayUs(1);
-    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-    SYSTICK_DelayUs(1);
+    GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    BK4819_BusDelay();
+    GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    BK4819_BusDelay();
   }
   PORTCON_PORTC_IE = (PORTCON_PORTC_IE & ~PORTCON_PORTC_IE_C2_MASK) |
                      PORTCON_PORTC_IE_C2_BITS_DISABLE;
@@ -84,76 +133,198 @@ static uint16_t BK4819_ReadU16(void) {
   return Value;
 }
 
-uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register) {
-  uint16_t Value;
+static void BK4819_Select(void) {
+  GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  BK4819_BusDelay();
+  GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+}
 
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-  SYSTICK_DelayUs(1);
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+static void BK4819_Deselect(void) {
+  BK4819_BusDelay();
+  GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  BK4819_BusDelay();
+  GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+}
 
-  BK4819_WriteU8(Register | 0x80);
+static uint16_t BK4819_BusRead(uint8_t Register) {
+  uint16_t Value;
 
+  BK4819_Select();
+  BK4819_WriteU8(Register | BK4819_TRANSFER_READ);
   Value = BK4819_ReadU16();
-
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
-  SYSTICK_DelayUs(1);
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+  BK4819_Deselect();
 
   return Value;
 }
 
-void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data) {
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-  SYSTICK_DelayUs(1);
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+static void BK4819_BusWrite(uint8_t Register, uint16_t Data) {
+  gBK4819_Writes++;
+  BK4819_Select();
   BK4819_WriteU8(Register);
-  SYSTICK_DelayUs(1);
   BK4819_WriteU16(Data);
-  SYSTICK_DelayUs(1);
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
-  SYSTICK_DelayUs(1);
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+  BK4819_Deselect();
+}
+
+static bool BK4819_IsShadowed(uint8_t Register) {
+  return (SHADOWED_REGS[Register >> 5] >> (Register & 31)) & 1U;
+}
+
+static bool BK4819_ShadowLookup(uint8_t Register, uint16_t *pValue) {
+  if (!((gShadowValid[Register >> 5] >> (Register & 31)) & 1U)) {
+    return false;
+  }
+  *pValue = gShadowRegs[Register];
+  gBK4819_ShadowHits++;
+#if defined(ENABLE_BK4819_SHADOW_CHECK)
+  if (BK4819_BusRead(Register) != *pValue) {
+    gBK4819_ShadowMismatches++;
+  }
+#endif
+  return true;
+}
+
+static void BK4819_ShadowStore(uint8_t Register, uint16_t Value) {
+  if (Register == BK4819_REG_00) {
+    // soft reset puts every register back to its default
+    memset(gShadowValid, 0, sizeof(gShadowValid));
+    gShadowIndexedValid = 0;
+    return;
+  }
+  if (Register == BK4819_REG_07) {
+    gShadow07[Value >> 13] = Value;
+    gShadowIndexedValid |= 1U << (Value >> 13);
+  } else if (Register == BK4819_REG_08) {
+    gShadow08[Value >> 15] = Value;
+    gShadowIndexedValid |= 1U << (8 + (Value >> 15));
+  } else if (BK4819_IsShadowed(Register)) {
+    gShadowRegs[Register] = Value;
+    gShadowValid[Register >> 5] |= 1U << (Register & 31);
+  }
+}
+
+// True if writing Value to Register would not change the chip.
+static bool BK4819_ShadowMatches(uint8_t Register, uint16_t Value) {
+  if (Register == BK4819_REG_07) {
+    return ((gShadowIndexedValid >> (Value >> 13)) & 1U) &&
+           gShadow07[Value >> 13] == Value;
+  }
+  if (Register == BK4819_REG_08) {
+    return ((gShadowIndexedValid >> (8 + (Value >> 15))) & 1U) &&
+           gShadow08[Value >> 15] == Value;
+  }
+  return ((gShadowValid[Register >> 5] >> (Register & 31)) & 1U) &&
+         gShadowRegs[Register] == Value;
+}
+
+// The spectrum sampler uses the chip from the SysTick interrupt, so each
+// register access keeps interrupts off while it holds the bus and shadow.
+uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register) {
+  const uint32_t Mask = __get_PRIMASK();
+  uint16_t Value;
+
+  __disable_irq();
+  if (!BK4819_ShadowLookup(Register, &Value)) {
+    Value = BK4819_BusRead(Register);
+    BK4819_ShadowStore(Register, Value);
+  }
+  __set_PRIMASK(Mask);
+
+  return Value;
+}
+
+void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  BK4819_BusWrite(Register, Data);
+  BK4819_ShadowStore(Register, Data);
+  __set_PRIMASK(Mask);
+}
+
+// Ends one register and starts the next with only a chip select pulse; SCL
+// is already low after the last bit.
+static void BK4819_Reselect(void) {
+  BK4819_BusDelay();
+  GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  BK4819_BusDelay();
+  GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+}
+
+void BK4819_Transfer(BK4819_Transaction_t *pTransactions, uint8_t Count) {
+  const uint32_t Mask = __get_PRIMASK();
+  bool bSelected = false;
+
+  __disable_irq();
+  for (uint8_t i = 0; i < Count; ++i) {
+    BK4819_Transaction_t *t = &pTransactions[i];
+    const uint8_t Register = t->Register & ~BK4819_TRANSFER_READ;
+
+    if ((t->Register & BK4819_TRANSFER_READ) &&
+        BK4819_ShadowLookup(Register, &t->Value)) {
+#if defined(ENABLE_BK4819_SHADOW_CHECK)
+      // the comparison read ended the selection
+      bSelected = false;
+#endif
+      continue;
+    }
+
+    if (bSelected) {
+      BK4819_Reselect();
+    } else {
+      BK4819_Select();
+      bSelected = true;
+    }
+    if (t->Register & BK4819_TRANSFER_READ) {
+      BK4819_WriteU8(t->Register);
+      t->Value = BK4819_ReadU16();
+    } else {
+      gBK4819_Writes++;
+      BK4819_WriteU8(Register);
+      BK4819_WriteU16(t->Value);
+    }
+    BK4819_ShadowStore(Register, t->Value);
+  }
+  if (bSelected) {
+    BK4819_Deselect();
+  }
+  __set_PRIMASK(Mask);
 }
 
 void BK4819_WriteU8(uint8_t Data) {
   uint8_t i;
 
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
   for (i = 0; i < 8; i++) {
     if ((Data & 0x80U) == 0) {
-      GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+      GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
     } else {
-      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+      GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
     }
-    SYSTICK_DelayUs(1);
-    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
+    GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    BK4819_BusDelay();
     Data <<= 1;
-    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-    SYSTICK_DelayUs(1);
+    GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
   }
 }
 
 void BK4819_WriteU16(uint16_t Data) {
   uint8_t i;
 
-  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
   for (i = 0; i < 16; i++) {
     if ((Data & 0x8000U) == 0U) {
-      GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+      GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
     } else {
-      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+      GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
     }
-    SYSTICK_DelayUs(1);
-    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    BK4819_BusDelay();
+    GPIO_SetBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
     Data <<= 1;
-    SYSTICK_DelayUs(1);
-    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
+    GPIO_ClearBitIrqOff(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
   }
 }
 
@@ -187,7 +358,12 @@ void BK4819_SetAGC(uint8_t Value) {
   }
 }
 
+// The spectrum sampler also updates REG_33 from SysTick (BK4819_SelectFilter),
+// so the state is changed and written with interrupts off.
 void BK4819_ToggleGpioOut(BK4819_GPIO_PIN_t Pin, bool bSet) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
   if (bSet) {
     gBK4819_GpioOutState |= (0x40U >> Pin);
   } else {
@@ -195,29 +371,57 @@ void BK4819_ToggleGpioOut(BK4819_GPIO_PIN_t Pin, bool bSet) {
   }
 
   BK4819_WriteRegister(BK4819_REG_33, gBK4819_GpioOutState);
-}
-
-void BK4819_SetCDCSSCodeWord(uint32_t CodeWord) {
-  // Enable CDCSS
-  // Transmit positive CDCSS code
-  // CDCSS Mode
-  // CDCSS 23bit
+  __set_PRIMASK(Mask);
+}
+
+// Enable CDCSS
+// Transmit positive CDCSS code
+// CDCSS Mode
+// CDCSS 23bit
+// Enable Auto CDCSS Bw Mode
+// Enable Auto CTCSS Bw Mode
+// CTCSS/CDCSS Tx Gain1 Tuning = 51
+#define CDCSS_CONFIG                                                           \
+  (0 | BK4819_REG_51_ENABLE_CxCSS | BK4819_REG_51_GPIO6_PIN2_NORMAL |          \
+   BK4819_REG_51_TX_CDCSS_POSITIVE | BK4819_REG_51_MODE_CDCSS |                \
+   BK4819_REG_51_CDCSS_23_BIT | BK4819_REG_51_1050HZ_NO_DETECTION |            \
+   BK4819_REG_51_AUTO_CDCSS_BW_ENABLE | BK4819_REG_51_AUTO_CTCSS_BW_ENABLE |   \
+   (51U << BK4819_REG_51_SHIFT_CxCSS_TX_GAIN1))
+
+// CTC1 Frequency Control Word = 2775
+#define CDCSS_CTC1                                                             \
+  (0 | BK4819_REG_07_MODE_CTC1 | (2775U << BK4819_REG_07_SHIFT_FREQUENCY))
+
+// CTC2 Frequency Control Word = round_nearest(25391 / 55) = 462
+#define TAIL_55HZ_CTC2 ((1U << 13) | 462)
+
+static uint16_t BK4819_CtcssConfig(uint32_t FreqControlWord) {
+  if (FreqControlWord == 2625) { // Enables 1050Hz detection mode
+    // Enable TxCTCSS
+    // CTCSS Mode
+    // 1050/4 Detect Enable
+    // Enable Auto CDCSS Bw Mode
+    // Enable Auto CTCSS Bw Mode
+    // CTCSS/CDCSS Tx Gain1 Tuning = 74
+    return 0x944A;
+  }
+  // Enable TxCTCSS
+  // CTCSS Mode
   // Enable Auto CDCSS Bw Mode
   // Enable Auto CTCSS Bw Mode
-  // CTCSS/CDCSS Tx Gain1 Tuning = 51
-  BK4819_WriteRegister(
-      BK4819_REG_51,
-      0 | BK4819_REG_51_ENABLE_CxCSS | BK4819_REG_51_GPIO6_PIN2_NORMAL |
-          BK4819_REG_51_TX_CDCSS_POSITIVE | BK4819_REG_51_MODE_CDCSS |
-          BK4819_REG_51_CDCSS_23_BIT | BK4819_REG_51_1050HZ_NO_DETECTION |
-          BK4819_REG_51_AUTO_CDCSS_BW_ENABLE |
-          BK4819_REG_51_AUTO_CTCSS_BW_ENABLE |
-          (51U << BK4819_REG_51_SHIFT_CxCSS_TX_GAIN1));
+  // CTCSS/CDCSS Tx Gain1 Tuning = 74
+  return 0x904A;
+}
 
-  // CTC1 Frequency Control Word = 2775
-  BK4819_WriteRegister(BK4819_REG_07,
-                       0 | BK4819_REG_07_MODE_CTC1 |
-                           (2775U << BK4819_REG_07_SHIFT_FREQUENCY));
+static uint16_t BK4819_CtcssCtc1(uint32_t FreqControlWord) {
+  // CTC1 Frequency Control Word
+  return 0 | BK4819_REG_07_MODE_CTC1 |
+         ((FreqControlWord * 2065) / 1000) << BK4819_REG_07_SHIFT_FREQUENCY;
+}
+
+void BK4819_SetCDCSSCodeWord(uint32_t CodeWord) {
+  BK4819_WriteRegister(BK4819_REG_51, CDCSS_CONFIG);
+  BK4819_WriteRegister(BK4819_REG_07, CDCSS_CTC1);
 
   // Set the code word
   BK4819_WriteRegister(BK4819_REG_08, 0x0000 | ((CodeWord >> 0) & 0xFFF));
@@ -225,36 +429,21 @@ void BK4819_SetCDCSSCodeWord(uint32_t CodeWord) {
 }
 
 void BK4819_SetCTCSSFrequency(uint32_t FreqControlWord) {
-  uint16_t Config;
-
-  if (FreqControlWord == 2625) { // Enables 1050Hz detection mode
-    // Enable TxCTCSS
-    // CTCSS Mode
-    // 1050/4 Detect Enable
-    // Enable Auto CDCSS Bw Mode
-    // Enable Auto CTCSS Bw Mode
-    // CTCSS/CDCSS Tx Gain1 Tuning = 74
-    Config = 0x944A;
-  } else {
-    // Enable TxCTCSS
-    // CTCSS Mode
-    // Enable Auto CDCSS Bw Mode
-    // Enable Auto CTCSS Bw Mode
-    // CTCSS/CDCSS Tx Gain1 Tuning = 74
-    Config = 0x904A;
-  }
-  BK4819_WriteRegister(BK4819_REG_51, Config);
-  // CTC1 Frequency Control Word
-  BK4819_WriteRegister(BK4819_REG_07, 0 | BK4819_REG_07_MODE_CTC1 |
-                                          ((FreqControlWord * 2065) / 1000)
-                                              << BK4819_REG_07_SHIFT_FREQUENCY);
+  BK4819_WriteRegister(BK4819_REG_51, BK4819_CtcssConfig(FreqControlWord));
+  BK4819_WriteRegister(BK4819_REG_07, BK4819_CtcssCtc1(FreqControlWord));
 }
 
 void BK4819_Set55HzTailDetection(void) {
-  // CTC2 Frequency Control Word = round_nearest(25391 / 55) = 462
-  BK4819_WriteRegister(BK4819_REG_07, (1U << 13) | 462);
+  BK4819_WriteRegister(BK4819_REG_07, TAIL_55HZ_CTC2);
 }
 
+// 0xA000 is undocumented?
+#define VOX_ENABLE(Threshold) (0xA000 | ((Threshold) & 0x07FF))
+// 0x1800 is undocumented?
+#define VOX_DISABLE(Threshold) (0x1800 | ((Threshold) & 0x07FF))
+// Bottom 12 bits are undocumented, 15:12 vox disable delay *128ms
+#define VOX_DELAY 0x289A // vox disable delay = 128*5 = 640ms
+
 void BK4819_EnableVox(uint16_t VoxEnableThreshold,
                       uint16_t VoxDisableThreshold) {
   // VOX Algorithm
@@ -263,13 +452,9 @@ void BK4819_EnableVox(uint16_t VoxEnableThreshold,
   uint16_t REG_31_Value;
 
   REG_31_Value = BK4819_ReadRegister(BK4819_REG_31);
-  // 0xA000 is undocumented?
-  BK4819_WriteRegister(BK4819_REG_46, 0xA000 | (VoxEnableThreshold & 0x07FF));
-  // 0x1800 is undocumented?
-  BK4819_WriteRegister(BK4819_REG_79, 0x1800 | (VoxDisableThreshold & 0x07FF));
-  // Bottom 12 bits are undocumented, 15:12 vox disable delay *128ms
-  BK4819_WriteRegister(BK4819_REG_7A,
-                       0x289A); // vox disable delay = 128*5 = 640ms
+  BK4819_WriteRegister(BK4819_REG_46, VOX_ENABLE(VoxEnableThreshold));
+  BK4819_WriteRegister(BK4819_REG_79, VOX_DISABLE(VoxDisableThreshold));
+  BK4819_WriteRegister(BK4819_REG_7A, VOX_DELAY);
   // Enable VOX
   BK4819_WriteRegister(BK4819_REG_31, REG_31_Value | 4); // bit 2 - VOX Enable
 }
@@ -304,15 +489,27 @@ void BK4819_SetupPowerAmplifier(uint16_t Bias, uint32_t Frequency) {
 }
 
 void BK4819_SetFrequency(uint32_t Frequency) {
-  BK4819_WriteRegister(BK4819_REG_38, (Frequency >> 0) & 0xFFFF);
-  BK4819_WriteRegister(BK4819_REG_39, (Frequency >> 16) & 0xFFFF);
+  BK4819_Transaction_t t[] = {
+      {BK4819_REG_38, (Frequency >> 0) & 0xFFFF},
+      {BK4819_REG_39, (Frequency >> 16) & 0xFFFF},
+  };
+  BK4819_Transfer(t, ARRAY_SIZE(t));
 }
 
 uint32_t BK4819_GetFrequency() {
-  return (BK4819_ReadRegister(BK4819_REG_39) << 16) |
-         BK4819_ReadRegister(BK4819_REG_38);
+  BK4819_Transaction_t t[] = {
+      {BK4819_REG_39 | BK4819_TRANSFER_READ},
+      {BK4819_REG_38 | BK4819_TRANSFER_READ},
+  };
+  BK4819_Transfer(t, ARRAY_SIZE(t));
+  return ((uint32_t)t[0].Value << 16) | t[1].Value;
 }
 
+#define SQUELCH_CLOSE_GLITCH(Thresh) (0xA000 | (Thresh))
+#define SQUELCH_OPEN_GLITCH(Thresh) (0x6F00 | (Thresh))
+#define SQUELCH_NOISE(Close, Open) (((Close) << 8) | (Open))
+#define SQUELCH_RSSI(Open, Close) (((Open) << 8) | (Close))
+
 void BK4819_SetupSquelch(uint8_t SquelchOpenRSSIThresh,
                          uint8_t SquelchCloseRSSIThresh,
                          uint8_t SquelchOpenNoiseThresh,
@@ -320,20 +517,25 @@ void BK4819_SetupSquelch(uint8_t SquelchOpenRSSIThresh,
                          uint8_t SquelchCloseGlitchThresh,
                          uint8_t SquelchOpenGlitchThresh) {
   BK4819_WriteRegister(BK4819_REG_70, 0);
-  BK4819_WriteRegister(BK4819_REG_4D, 0xA000 | SquelchCloseGlitchThresh);
-  BK4819_WriteRegister(BK4819_REG_4E, 0x6F00 | SquelchOpenGlitchThresh);
-  BK4819_WriteRegister(BK4819_REG_4F,
-                       (SquelchCloseNoiseThresh << 8) | SquelchOpenNoiseThresh);
-  BK4819_WriteRegister(BK4819_REG_78,
-                       (SquelchOpenRSSIThresh << 8) | SquelchCloseRSSIThresh);
+  BK4819_WriteRegister(BK4819_REG_4D,
+                       SQUELCH_CLOSE_GLITCH(SquelchCloseGlitchThresh));
+  BK4819_WriteRegister(BK4819_REG_4E,
+                       SQUELCH_OPEN_GLITCH(SquelchOpenGlitchThresh));
+  BK4819_WriteRegister(
+      BK4819_REG_4F,
+      SQUELCH_NOISE(SquelchCloseNoiseThresh, SquelchOpenNoiseThresh));
+  BK4819_WriteRegister(
+      BK4819_REG_78, SQUELCH_RSSI(SquelchOpenRSSIThresh, SquelchCloseRSSIThresh));
   BK4819_SetAF(BK4819_AF_MUTE);
   BK4819_RX_TurnOn();
 }
 
+// AF Output Inverse Mode = Inverse
+// Undocumented bits 0x2040
+#define AF_CONFIG(AF) (0x6040 | ((AF) << 8))
+
 void BK4819_SetAF(BK4819_AF_Type_t AF) {
-  // AF Output Inverse Mode = Inverse
-  // Undocumented bits 0x2040
-  BK4819_WriteRegister(BK4819_REG_47, 0x6040 | (AF << 8));
+  BK4819_WriteRegister(BK4819_REG_47, AF_CONFIG(AF));
 }
 
 uint16_t BK4819_GetRegValue(RegisterSpec s) {
@@ -355,47 +557,61 @@ void BK4819_SetModulation(ModulationType type) {
   BK4819_SetRegValue(afcDisableRegSpec, type != MOD_FM);
 }
 
+// DSP Voltage Setting = 1
+// ANA LDO = 2.7v
+// VCO LDO = 2.7v
+// RF LDO = 2.7v
+// PLL LDO = 2.7v
+// ANA LDO bypass
+// VCO LDO bypass
+// RF LDO bypass
+// PLL LDO bypass
+// Reserved bit is 1 instead of 0
+// Enable DSP
+// Enable XTAL
+// Enable Band Gap
+#define RX_POWER 0x1F0F
+
+// Enable VCO Calibration
+// Enable RX Link
+// Enable AF DAC
+// Enable PLL/VCO
+// Disable PA Gain
+// Disable MIC ADC
+// Disable TX DSP
+// Enable RX DSP
+#define RX_LINK 0xBFF1
+
 void BK4819_RX_TurnOn(void) {
-  // DSP Voltage Setting = 1
-  // ANA LDO = 2.7v
-  // VCO LDO = 2.7v
-  // RF LDO = 2.7v
-  // PLL LDO = 2.7v
-  // ANA LDO bypass
-  // VCO LDO bypass
-  // RF LDO bypass
-  // PLL LDO bypass
-  // Reserved bit is 1 instead of 0
-  // Enable DSP
-  // Enable XTAL
-  // Enable Band Gap
-  BK4819_WriteRegister(BK4819_REG_37, 0x1F0F);
+  BK4819_WriteRegister(BK4819_REG_37, RX_POWER);
 
   // Turn off everything
   BK4819_WriteRegister(BK4819_REG_30, 0);
 
-  // Enable VCO Calibration
-  // Enable RX Link
-  // Enable AF DAC
-  // Enable PLL/VCO
-  // Disable PA Gain
-  // Disable MIC ADC
-  // Disable TX DSP
-  // Enable RX DSP
-  BK4819_WriteRegister(BK4819_REG_30, 0xBFF1);
+  BK4819_WriteRegister(BK4819_REG_30, RX_LINK);
 }
 
-void BK4819_SelectFilter(uint32_t Frequency) {
+static uint16_t BK4819_FilterGpio(uint16_t State, uint32_t Frequency) {
+  const uint16_t vhf = 0x40U >> BK4819_GPIO4_PIN32_VHF_LNA;
+  const uint16_t uhf = 0x40U >> BK4819_GPIO3_PIN31_UHF_LNA;
+
+  State &= ~(vhf | uhf);
   if (Frequency < 28000000) {
-    BK4819_ToggleGpioOut(BK4819_GPIO4_PIN32_VHF_LNA, true);
-    BK4819_ToggleGpioOut(BK4819_GPIO3_PIN31_UHF_LNA, false);
-  } else if (Frequency == 0xFFFFFFFF) {
-    BK4819_ToggleGpioOut(BK4819_GPIO4_PIN32_VHF_LNA, false);
-    BK4819_ToggleGpioOut(BK4819_GPIO3_PIN31_UHF_LNA, false);
-  } else {
-    BK4819_ToggleGpioOut(BK4819_GPIO4_PIN32_VHF_LNA, false);
-    BK4819_ToggleGpioOut(BK4819_GPIO3_PIN31_UHF_LNA, true);
+    State |= vhf;
+  } else if (Frequency != 0xFFFFFFFF) {
+    State |= uhf;
   }
+  return State;
+}
+
+void BK4819_SelectFilter(uint32_t Frequency) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  // both LNA switches live in REG_33, so set them with one bus write
+  __disable_irq();
+  gBK4819_GpioOutState = BK4819_FilterGpio(gBK4819_GpioOutState, Frequency);
+  BK4819_WriteRegister(BK4819_REG_33, gBK4819_GpioOutState);
+  __set_PRIMASK(Mask);
 }
 
 void BK4819_DisableScramble(void) {
@@ -405,12 +621,14 @@ void BK4819_DisableScramble(void) {
   BK4819_WriteRegister(BK4819_REG_31, Value & 0xFFFD);
 }
 
+#define SCRAMBLE_CONFIG(Type) (((Type) * 0x0408) + 0x68DC)
+
 void BK4819_EnableScramble(uint8_t Type) {
   uint16_t Value;
 
   Value = BK4819_ReadRegister(BK4819_REG_31);
   BK4819_WriteRegister(BK4819_REG_31, Value | 2);
-  BK4819_WriteRegister(BK4819_REG_71, (Type * 0x0408) + 0x68DC);
+  BK4819_WriteRegister(BK4819_REG_71, SCRAMBLE_CONFIG(Type));
 }
 
 void BK4819_DisableVox(void) {
@@ -422,14 +640,166 @@ void BK4819_DisableVox(void) {
 
 void BK4819_DisableDTMF(void) { BK4819_WriteRegister(BK4819_REG_24, 0); }
 
+#define DTMF_CONFIG                                                            \
+  (0 | (1U << BK4819_REG_24_SHIFT_UNKNOWN_15) |                                \
+   (24 << BK4819_REG_24_SHIFT_THRESHOLD) |                                     \
+   (1U << BK4819_REG_24_SHIFT_UNKNOWN_6) | BK4819_REG_24_ENABLE |              \
+   BK4819_REG_24_SELECT_DTMF | (14U << BK4819_REG_24_SHIFT_MAX_SYMBOLS))
+
 void BK4819_EnableDTMF(void) {
   BK4819_WriteRegister(BK4819_REG_21, 0x06D8);
-  BK4819_WriteRegister(BK4819_REG_24,
-                       0 | (1U << BK4819_REG_24_SHIFT_UNKNOWN_15) |
-                           (24 << BK4819_REG_24_SHIFT_THRESHOLD) |
-                           (1U << BK4819_REG_24_SHIFT_UNKNOWN_6) |
-                           BK4819_REG_24_ENABLE | BK4819_REG_24_SELECT_DTMF |
-                           (14U << BK4819_REG_24_SHIFT_MAX_SYMBOLS));
+  BK4819_WriteRegister(BK4819_REG_24, DTMF_CONFIG);
+}
+
+// Longest image BK4819_SetupRx() can produce, interrupt mask writes included
+#define RX_IMAGE_SIZE 32U
+
+typedef struct {
+  BK4819_Transaction_t t[RX_IMAGE_SIZE];
+  uint8_t Count; // writes that will go on the bus
+  uint8_t Total; // writes in the full image
+} RxImage_t;
+
+static void BK4819_ImagePut(RxImage_t *pImage, uint8_t Register,
+                            uint16_t Value, bool bForce) {
+  pImage->Total++;
+  if (bForce || !BK4819_ShadowMatches(Register, Value)) {
+    pImage->t[pImage->Count].Register = Register;
+    pImage->t[pImage->Count].Value = Value;
+    pImage->Count++;
+  }
+}
+
+void BK4819_SetupRx(const BK4819_RxSetup_t *pSetup) {
+  const uint16_t Off = (0x40U >> BK4819_GPIO0_PIN28_GREEN) |
+                       (0x40U >> BK4819_GPIO5_PIN1_RED) |
+                       (0x40U >> BK4819_GPIO1_PIN29_PA_ENABLE);
+  RxImage_t Image;
+  uint16_t Value;
+  uint8_t Mark;
+  uint8_t First;
+
+  // slot 0 is kept for masking interrupts while the image goes out
+  Image.Count = 1;
+  Image.Total = 1;
+
+  gBK4819_GpioOutState =
+      BK4819_FilterGpio(gBK4819_GpioOutState & ~Off, pSetup->Frequency) |
+      (0x40U >> BK4819_GPIO0_PIN28_RX_ENABLE);
+  BK4819_ImagePut(&Image, BK4819_REG_33, gBK4819_GpioOutState, false);
+  BK4819_ImagePut(&Image, BK4819_REG_43, listenBWRegValues[pSetup->Bandwidth],
+                  false);
+  // PA off, as BK4819_SetupPowerAmplifier(0, 0)
+  BK4819_ImagePut(&Image, BK4819_REG_36, 0x0088, false);
+  BK4819_ImagePut(&Image, BK4819_REG_7D,
+                  pSetup->MicSensitivityTuning | 0xE94F, false);
+
+  BK4819_ImagePut(&Image, BK4819_REG_70, 0, false);
+  BK4819_ImagePut(&Image, BK4819_REG_4D,
+                  SQUELCH_CLOSE_GLITCH(pSetup->SquelchCloseGlitchThresh),
+                  false);
+  BK4819_ImagePut(&Image, BK4819_REG_4E,
+                  SQUELCH_OPEN_GLITCH(pSetup->SquelchOpenGlitchThresh), false);
+  BK4819_ImagePut(&Image, BK4819_REG_4F,
+                  SQUELCH_NOISE(pSetup->SquelchCloseNoiseThresh,
+                                pSetup->SquelchOpenNoiseThresh),
+                  false);
+  BK4819_ImagePut(&Image, BK4819_REG_78,
+                  SQUELCH_RSSI(pSetup->SquelchOpenRSSIThresh,
+                               pSetup->SquelchCloseRSSIThresh),
+                  false);
+  BK4819_ImagePut(&Image, BK4819_REG_47, AF_CONFIG(BK4819_AF_MUTE), false);
+
+  Mark = Image.Count;
+  BK4819_ImagePut(&Image, BK4819_REG_38, pSetup->Frequency & 0xFFFF, false);
+  BK4819_ImagePut(&Image, BK4819_REG_39, pSetup->Frequency >> 16, false);
+  BK4819_ImagePut(&Image, BK4819_REG_37, RX_POWER, false);
+  // the PLL only picks up a new frequency when the RX link is restarted
+  if (Image.Count != Mark || !BK4819_ShadowMatches(BK4819_REG_30, RX_LINK)) {
+    BK4819_ImagePut(&Image, BK4819_REG_30, 0, true);
+    BK4819_ImagePut(&Image, BK4819_REG_30, RX_LINK, true);
+  } else {
+    Image.Total += 2;
+  }
+  BK4819_ImagePut(&Image, BK4819_REG_48, 0xB3A8, false);
+
+  switch (pSetup->SubAudio) {
+  case BK4819_SUBAUDIO_CTCSS:
+    BK4819_ImagePut(&Image, BK4819_REG_51,
+                    BK4819_CtcssConfig(pSetup->CtcssFrequency), false);
+    BK4819_ImagePut(&Image, BK4819_REG_07,
+                    BK4819_CtcssCtc1(pSetup->CtcssFrequency), false);
+    if (pSetup->bTail55Hz) {
+      BK4819_ImagePut(&Image, BK4819_REG_07, TAIL_55HZ_CTC2, false);
+    }
+    break;
+  case BK4819_SUBAUDIO_CDCSS: {
+    const uint16_t Lo = 0x0000 | ((pSetup->CdcssCodeWord >> 0) & 0xFFF);
+    const uint16_t Hi = 0x8000 | ((pSetup->CdcssCodeWord >> 12) & 0xFFF);
+    // the code word is latched as a pair, so never send half of it
+    const bool bWord = !BK4819_ShadowMatches(BK4819_REG_08, Lo) ||
+                       !BK4819_ShadowMatches(BK4819_REG_08, Hi);
+
+    BK4819_ImagePut(&Image, BK4819_REG_51, CDCSS_CONFIG, false);
+    BK4819_ImagePut(&Image, BK4819_REG_07, CDCSS_CTC1, false);
+    if (bWord) {
+      BK4819_ImagePut(&Image, BK4819_REG_08, Lo, true);
+      BK4819_ImagePut(&Image, BK4819_REG_08, Hi, true);
+    } else {
+      Image.Total += 2;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  Value = BK4819_ReadRegister(BK4819_REG_31);
+  if (pSetup->Scrambler != BK4819_SCRAMBLE_KEEP) {
+    if (pSetup->Scrambler) {
+      BK4819_ImagePut(&Image, BK4819_REG_71,
+                      SCRAMBLE_CONFIG(pSetup->Scrambler - 1), false);
+      Value |= 2;
+    } else {
+      Value &= ~2U;
+    }
+  }
+  if (pSetup->bVox) {
+    BK4819_ImagePut(&Image, BK4819_REG_46, VOX_ENABLE(pSetup->Vox1Threshold),
+                    false);
+    BK4819_ImagePut(&Image, BK4819_REG_79, VOX_DISABLE(pSetup->Vox0Threshold),
+                    false);
+    BK4819_ImagePut(&Image, BK4819_REG_7A, VOX_DELAY, false);
+    Value |= 4;
+  } else {
+    Value &= ~4U;
+  }
+  BK4819_ImagePut(&Image, BK4819_REG_31, Value, false);
+
+  if (pSetup->bDtmf) {
+    BK4819_ImagePut(&Image, BK4819_REG_21, 0x06D8, false);
+    BK4819_ImagePut(&Image, BK4819_REG_24, DTMF_CONFIG, false);
+  } else {
+    BK4819_ImagePut(&Image, BK4819_REG_24, 0, false);
+  }
+
+  Value = BK4819_ReadRegister(0x40);
+  BK4819_ImagePut(&Image, 0x40, (Value & ~0x7FFU) | 0x5AA, false);
+
+  First = 1;
+  if (Image.Count > 1) {
+    if (!BK4819_ShadowMatches(BK4819_REG_3F, 0)) {
+      Image.t[0].Register = BK4819_REG_3F;
+      Image.t[0].Value = 0;
+      First = 0;
+    }
+    BK4819_ImagePut(&Image, BK4819_REG_3F, pSetup->InterruptMask, true);
+  } else {
+    BK4819_ImagePut(&Image, BK4819_REG_3F, pSetup->InterruptMask, false);
+  }
+
+  gBK4819_WritesAvoided += Image.Total - (Image.Count - First);
+  BK4819_Transfer(&Image.t[First], Image.Count - First);
 }
 
 void BK4819_PlayTone(uint16_t Frequency, bool bTuningGainSwitch) {
@@ -637,28 +1007,41 @@ void BK4819_PlayDTMF(char Code) {
   }
 }
 
-void BK4819_PlayDTMFString(const char *pString, bool bDelayFirst,
-                           uint16_t FirstCodePersistTime,
-                           uint16_t HashCodePersistTime,
-                           uint16_t CodePersistTime,
-                           uint16_t CodeInternalTime) {
-  uint8_t i;
-  uint16_t Delay;
+uint16_t BK4819_PlayDTMFString(const char *pString, bool bDelayFirst,
+                               uint16_t FirstCodePersistTime,
+                               uint16_t HashCodePersistTime,
+                               uint16_t CodePersistTime,
+                               uint16_t CodeInternalTime, uint8_t *pStep) {
+  // Even steps start code i, odd ones end it.
+  uint8_t i = *pStep / 2;
 
-  for (i = 0; pString[i]; i++) {
-    BK4819_PlayDTMF(pString[i]);
-    BK4819_ExitTxMute();
-    if (bDelayFirst && i == 0) {
-      Delay = FirstCodePersistTime;
-    } else if (pString[i] == '*' || pString[i] == '#') {
-      Delay = HashCodePersistTime;
-    } else {
-      Delay = CodePersistTime;
-    }
-    SYSTEM_DelayMs(Delay);
+  if (*pStep == BK4819_STEP_END) {
+    BK4819_EnterTxMute();
+    return 0;
+  }
+  if (*pStep & 1U) {
     BK4819_EnterTxMute();
-    SYSTEM_DelayMs(CodeInternalTime);
+    i++;
+    *pStep = i * 2;
+    if (CodeInternalTime || pString[i] == '\0') {
+      return CodeInternalTime;
+    }
+  }
+  if (pString[i] == '\0') {
+    return 0;
+  }
+
+  BK4819_PlayDTMF(pString[i]);
+  BK4819_ExitTxMute();
+  *pStep = i * 2 + 1;
+  if (bDelayFirst && i == 0) {
+    return FirstCodePersistTime;
   }
+  if (pString[i] == '*' || pString[i] == '#') {
+    return HashCodePersistTime;
+  }
+
+  return CodePersistTime;
 }
 
 void BK4819_TransmitTone(bool bLocalLoopback, uint32_t Frequency) {
@@ -709,6 +1092,10 @@ uint16_t BK4819_GetRSSI(void) {
   return BK4819_ReadRegister(BK4819_REG_67) & 0x01FF;
 }
 
+uint8_t BK4819_GetExNoiseIndicator(void) {
+  return BK4819_ReadRegister(BK4819_REG_65) & 0x007F;
+}
+
 bool BK4819_GetFrequencyScanResult(uint32_t *pFrequency) {
   uint16_t High = BK4819_ReadRegister(BK4819_REG_0D);
   bool Finished = (High & 0x8000) == 0;
@@ -772,6 +1159,56 @@ uint8_t BK4819_GetDTMF_5TONE_Code(void) {
   return (BK4819_ReadRegister(BK4819_REG_0B) >> 8) & 0x0F;
 }
 
+// Drains the chip's pending interrupt requests into the event queue. Costs a
+// single REG_0C read when nothing is pending. Events are dropped if the queue
+// is full; the main loop empties it on every pass.
+uint8_t BK4819_PollInterrupts(void) {
+  uint8_t Count = 0;
+  uint16_t Status;
+
+  while ((Status = BK4819_ReadRegister(BK4819_REG_0C)) & 1U) {
+    const uint8_t Head = gEventHead;
+    volatile BK4819_Event_t *pEvent = &gEvents[Head % EVENT_QUEUE_SIZE];
+    uint16_t Mask;
+
+    BK4819_WriteRegister(BK4819_REG_02, 0);
+    Mask = BK4819_ReadRegister(BK4819_REG_02);
+    if ((uint8_t)(Head - gEventTail) >= EVENT_QUEUE_SIZE) {
+      continue;
+    }
+    pEvent->Mask = Mask;
+    pEvent->Status = Status;
+    pEvent->Code = (Mask & BK4819_REG_02_DTMF_5TONE_FOUND)
+                       ? BK4819_GetDTMF_5TONE_Code()
+                       : 0;
+    gEventHead = Head + 1;
+    Count++;
+  }
+
+  return Count;
+}
+
+bool BK4819_GetEvent(BK4819_Event_t *pEvent) {
+  const uint8_t Tail = gEventTail;
+
+  if (Tail == gEventHead) {
+    return false;
+  }
+  *pEvent = gEvents[Tail % EVENT_QUEUE_SIZE];
+  gEventTail = Tail + 1;
+
+  return true;
+}
+
+// Discards pending interrupt requests, both on the chip and already queued.
+void BK4819_ClearInterrupts(void) {
+  while (BK4819_ReadRegister(BK4819_REG_0C) & 1U) {
+    BK4819_WriteRegister(BK4819_REG_02, 0);
+    SYSTEM_DelayMs(1);
+  }
+  gEventTail = gEventHead;
+}
+
 uint8_t BK4819_GetCDCSSCodeType(void) {
   return (BK4819_ReadRegister(BK4819_REG_0C) >> 14) & 3;
 }
@@ -833,59 +1270,74 @@ void BK4819_PrepareFSKReceive(void) {
 }
 #endif
 
-void BK4819_PlayRoger(void) {
-  BK4819_EnterTxMute();
-  BK4819_SetAF(BK4819_AF_MUTE);
-  BK4819_WriteRegister(BK4819_REG_70, 0xE000);
-  BK4819_EnableTXLink();
-  SYSTEM_DelayMs(50);
-  BK4819_WriteRegister(BK4819_REG_71, 0x142A);
-  BK4819_ExitTxMute();
-  SYSTEM_DelayMs(80);
-  BK4819_EnterTxMute();
-  BK4819_WriteRegister(BK4819_REG_71, 0x1C3B);
-  BK4819_ExitTxMute();
-  SYSTEM_DelayMs(80);
-  BK4819_EnterTxMute();
-  BK4819_WriteRegister(BK4819_REG_70, 0x0000);
-  BK4819_WriteRegister(BK4819_REG_30, 0xC1FE);
+uint16_t BK4819_PlayRoger(uint8_t *pStep) {
+  switch ((*pStep)++) {
+  case 0:
+    BK4819_EnterTxMute();
+    BK4819_SetAF(BK4819_AF_MUTE);
+    BK4819_WriteRegister(BK4819_REG_70, 0xE000);
+    BK4819_EnableTXLink();
+    return 50;
+  case 1:
+    BK4819_WriteRegister(BK4819_REG_71, 0x142A);
+    BK4819_ExitTxMute();
+    return 80;
+  case 2:
+    BK4819_EnterTxMute();
+    BK4819_WriteRegister(BK4819_REG_71, 0x1C3B);
+    BK4819_ExitTxMute();
+    return 80;
+  default:
+    BK4819_EnterTxMute();
+    BK4819_WriteRegister(BK4819_REG_70, 0x0000);
+    BK4819_WriteRegister(BK4819_REG_30, 0xC1FE);
+    return 0;
+  }
 }
 
-void BK4819_PlayRogerMDC(void) {
+uint16_t BK4819_PlayRogerMDC(uint8_t *pStep) {
   uint8_t i;
 
-  BK4819_SetAF(BK4819_AF_MUTE);
-  BK4819_WriteRegister(
-      BK4819_REG_58,
-      0x37C3); // FSK Enable, RX Bandwidth FFSK1200/1800, 0xAA or 0x55 Preamble,
-               // 11 RX Gain, 101 RX Mode, FFSK1200/1800 TX
-  BK4819_WriteRegister(BK4819_REG_72, 0x3065); // Set Tone2 to 1200Hz
-  BK4819_WriteRegister(BK4819_REG_70,
-                       0x00E0); // Enable Tone2 and Set Tone2 Gain
-  BK4819_WriteRegister(BK4819_REG_5D,
-                       0x0D00); // Set FSK data length to 13 bytes
-  BK4819_WriteRegister(
-      BK4819_REG_59,
-      0x8068); // 4 byte sync length, 6 byte preamble, clear TX FIFO
-  BK4819_WriteRegister(
-      BK4819_REG_59,
-      0x0068); // Same, but clear TX FIFO is now unset (clearing done)
-  BK4819_WriteRegister(BK4819_REG_5A, 0x5555); // First two sync bytes
-  BK4819_WriteRegister(BK4819_REG_5B,
-                       0x55AA); // End of sync bytes. Total 4 bytes: 555555aa
-  BK4819_WriteRegister(BK4819_REG_5C, 0xAA30); // Disable CRC
-  for (i = 0; i < 7; i++) {
+  switch ((*pStep)++) {
+  case 0:
+    BK4819_SetAF(BK4819_AF_MUTE);
+    BK4819_WriteRegister(
+        BK4819_REG_58,
+        0x37C3); // FSK Enable, RX Bandwidth FFSK1200/1800, 0xAA or 0x55
+                 // Preamble, 11 RX Gain, 101 RX Mode, FFSK1200/1800 TX
+    BK4819_WriteRegister(BK4819_REG_72, 0x3065); // Set Tone2 to 1200Hz
+    BK4819_WriteRegister(BK4819_REG_70,
+                         0x00E0); // Enable Tone2 and Set Tone2 Gain
+    BK4819_WriteRegister(BK4819_REG_5D,
+                         0x0D00); // Set FSK data length to 13 bytes
+    BK4819_WriteRegister(
+        BK4819_REG_59,
+        0x8068); // 4 byte sync length, 6 byte preamble, clear TX FIFO
+    BK4819_WriteRegister(
+        BK4819_REG_59,
+        0x0068); // Same, but clear TX FIFO is now unset (clearing done)
+    BK4819_WriteRegister(BK4819_REG_5A, 0x5555); // First two sync bytes
+    BK4819_WriteRegister(BK4819_REG_5B,
+                         0x55AA); // End of sync bytes. Total 4 bytes: 555555aa
+    BK4819_WriteRegister(BK4819_REG_5C, 0xAA30); // Disable CRC
+    for (i = 0; i < 7; i++) {
+      BK4819_WriteRegister(
+          BK4819_REG_5F,
+          FSK_RogerTable[i]); // Send the data from the roger table
+    }
+    return 20;
+  case 1:
     BK4819_WriteRegister(
-        BK4819_REG_5F, FSK_RogerTable[i]); // Send the data from the roger table
+        BK4819_REG_59,
+        0x0868); // 4 sync bytes, 6 byte preamble, Enable FSK TX
+    return 180;
+  default:
+    // Stop FSK TX, reset Tone2, disable FSK.
+    BK4819_WriteRegister(BK4819_REG_59, 0x0068);
+    BK4819_WriteRegister(BK4819_REG_70, 0x0000);
+    BK4819_WriteRegister(BK4819_REG_58, 0x0000);
+    return 0;
   }
-  SYSTEM_DelayMs(20);
-  BK4819_WriteRegister(BK4819_REG_59,
-                       0x0868); // 4 sync bytes, 6 byte preamble, Enable FSK TX
-  SYSTEM_DelayMs(180);
-  // Stop FSK TX, reset Tone2, disable FSK.
-  BK4819_WriteRegister(BK4819_REG_59, 0x0068);
-  BK4819_WriteRegister(BK4819_REG_70, 0x0000);
-  BK4819_WriteRegister(BK4819_REG_58, 0x0000);
 }
 
 void BK4819_Enable_AfDac_DiscMode_TxDsp(void) {
@@ -926,15 +1378,24 @@ void BK4819_ToggleAFDAC(bool on) {
 
 void BK4819_TuneTo(uint32_t f, bool precise) {
   BK4819_SelectFilter(f);
-  BK4819_SetFrequency(f);
-  uint16_t reg = BK4819_ReadRegister(BK4819_REG_30);
+
+  BK4819_Transaction_t t[] = {
+      {BK4819_REG_38, f & 0xFFFF},
+      {BK4819_REG_39, (f >> 16) & 0xFFFF},
+      {BK4819_REG_30 | BK4819_TRANSFER_READ},
+      {BK4819_REG_30},
+      {BK4819_REG_30},
+  };
+  BK4819_Transfer(t, 3);
+
+  uint16_t reg = t[2].Value;
   if (precise) {
-    // BK4819_WriteRegister(BK4819_REG_30, 0);
-    BK4819_WriteRegister(BK4819_REG_30, 0x0200); // from radtel-rt-890-oefw
+    t[3].Value = 0x0200; // from radtel-rt-890-oefw
   } else {
-    BK4819_WriteRegister(BK4819_REG_30, reg & ~BK4819_REG_30_ENABLE_VCO_CALIB);
+    t[3].Value = reg & ~BK4819_REG_30_ENABLE_VCO_CALIB;
   }
-  BK4819_WriteRegister(BK4819_REG_30, reg);
+  t[4].Value = reg;
+  BK4819_Transfer(&t[3], 2);
 }
 
 void BK4819_SetToneFrequency(uint16_t f) {
@@ -49,18 +49,90 @@ enum BK4819_CssScanResult_t {
 };
 
 typedef enum BK4819_CssScanResult_t BK4819_CssScanResult_t;
+
+// OR into Register to clock a read instead of a write
+#define BK4819_TRANSFER_READ 0x80U
+
+typedef struct BK4819_Transaction_t {
+  uint8_t Register;
+  uint16_t Value;
+} BK4819_Transaction_t;
+
+// One drained interrupt request, with the status that goes stale once the
+// next one is raised.
+typedef struct BK4819_Event_t {
+  uint16_t Mask;   // REG_02 flags
+  uint16_t Status; // REG_0C (CxCSS code types)
+  uint8_t Code;    // DTMF/5-tone code, if BK4819_REG_02_DTMF_5TONE_FOUND
+} BK4819_Event_t;
+
+enum BK4819_SubAudio_t {
+  BK4819_SUBAUDIO_KEEP = 0U,
+  BK4819_SUBAUDIO_CTCSS = 1U,
+  BK4819_SUBAUDIO_CDCSS = 2U,
+};
+
+typedef enum BK4819_SubAudio_t BK4819_SubAudio_t;
+
+// Scrambler value that leaves REG_31 bit 1 and REG_71 as they are
+#define BK4819_SCRAMBLE_KEEP 0xFFU
+
+// Everything the receiver needs for one channel. BK4819_SetupRx() compiles it
+// into a register image and only sends what differs from the chip's shadow.
+typedef struct BK4819_RxSetup_t {
+  uint32_t Frequency;
+  BK4819_FilterBandwidth_t Bandwidth;
+  uint8_t SquelchOpenRSSIThresh;
+  uint8_t SquelchCloseRSSIThresh;
+  uint8_t SquelchOpenNoiseThresh;
+  uint8_t SquelchCloseNoiseThresh;
+  uint8_t SquelchCloseGlitchThresh;
+  uint8_t SquelchOpenGlitchThresh;
+  uint8_t MicSensitivityTuning;
+  BK4819_SubAudio_t SubAudio;
+  uint16_t CtcssFrequency; // 0.1 Hz, for BK4819_SUBAUDIO_CTCSS
+  bool bTail55Hz;
+  uint32_t CdcssCodeWord; // for BK4819_SUBAUDIO_CDCSS
+  uint8_t Scrambler;      // 0 = off, n = type n - 1, or BK4819_SCRAMBLE_KEEP
+  bool bVox;
+  uint16_t Vox1Threshold;
+  uint16_t Vox0Threshold;
+  bool bDtmf;
+  uint16_t InterruptMask;
+} BK4819_RxSetup_t;
+
 extern const uint16_t listenBWRegValues[3];
 
 extern bool gRxIdleMode;
 
+// reads served from the shadow
+extern uint32_t gBK4819_ShadowHits;
+#if defined(ENABLE_BK4819_SHADOW_CHECK)
+// shadow reads that disagreed with the chip
+extern uint32_t gBK4819_ShadowMismatches;
+#endif
+
+// register writes clocked onto the bus, and writes BK4819_SetupRx() skipped
+// because the chip already held the value
+extern uint32_t gBK4819_Writes;
+extern uint32_t gBK4819_WritesAvoided;
+
 void BK4819_Init(void);
 uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register);
 void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data);
+// Raw bus clocking; the caller holds interrupts off for the whole transfer.
 void BK4819_WriteU8(uint8_t Data);
 void BK4819_WriteU16(uint16_t Data);
+// Runs the list in order with interrupts held off once for all of it, the
+// bus accesses back to back; reads served by the shadow skip the bus.
+void BK4819_Transfer(BK4819_Transaction_t *pTransactions, uint8_t Count);
 
 void BK4819_SetAGC(uint8_t Value);
 
+uint8_t BK4819_PollInterrupts(void);
+bool BK4819_GetEvent(BK4819_Event_t *pEvent);
+void BK4819_ClearInterrupts(void);
+
 void BK4819_ToggleGpioOut(BK4819_GPIO_PIN_t Pin, bool bSet);
 
 void BK4819_SetCDCSSCodeWord(uint32_t CodeWord);
@@ -68,6 +140,7 @@ void BK4819_SetCTCSSFrequency(uint32_t BaudRate);
 void BK4819_Set55HzTailDetection(void);
 void BK4819_EnableVox(uint16_t Vox1Threshold, uint16_t Vox0Threshold);
 void BK4819_SetFilterBandwidth(BK4819_FilterBandwidth_t Bandwidth);
+void BK4819_SetupRx(const BK4819_RxSetup_t *pSetup);
 void BK4819_SetupPowerAmplifier(uint16_t Bias, uint32_t Frequency);
 void BK4819_SetFrequency(uint32_t Frequency);
 uint32_t BK4819_GetFrequency(void);
@@ -106,10 +179,6 @@ void BK4819_ExitDTMF_TX(bool bKeep);
 void BK4819_EnableTXLink(void);
 
 void BK4819_PlayDTMF(char Code);
-void BK4819_PlayDTMFString(const char *pString, bool bDelayFirst,
-                           uint16_t FirstCodePersistTime,
-                           uint16_t HashCodePersistTime,
-                           uint16_t CodePersistTime, uint16_t CodeInternalTime);
 
 void BK4819_TransmitTone(bool bLocalLoopback, uint32_t Frequency);
 
@@ -118,6 +187,7 @@ void BK4819_EnableCDCSS(void);
 void BK4819_EnableCTCSS(void);
 
 uint16_t BK4819_GetRSSI(void);
+uint8_t BK4819_GetExNoiseIndicator(void);
 
 bool BK4819_GetFrequencyScanResult(uint32_t *pFrequency);
 BK4819_CssScanResult_t BK4819_GetCxCSSScanResult(uint32_t *pCdcssFreq,
@@ -138,8 +208,19 @@ uint8_t BK4819_GetCTCType(void);
 void BK4819_SendFSKData(uint16_t *pData);
 void BK4819_PrepareFSKReceive(void);
 
-void BK4819_PlayRoger(void);
-void BK4819_PlayRogerMDC(void);
+// Roger tones and DTMF strings are played one step per call, starting from
+// *pStep = 0: each call returns the milliseconds to wait before the next one,
+// or 0 once the tone has finished. Setting *pStep to BK4819_STEP_END cuts it
+// short.
+#define BK4819_STEP_END 0xFFU
+
+uint16_t BK4819_PlayRoger(uint8_t *pStep);
+uint16_t BK4819_PlayRogerMDC(uint8_t *pStep);
+uint16_t BK4819_PlayDTMFString(const char *pString, bool bDelayFirst,
+                               uint16_t FirstCodePersistTime,
+                               uint16_t HashCodePersistTime,
+                               uint16_t CodePersistTime,
+                               uint16_t CodeInternalTime, uint8_t *pStep);
 
 void BK4819_Enable_AfDac_DiscMode_TxDsp(void);
 
@@ -48,3 +48,23 @@ uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size)
 	return Crc;
 }
 
+uint16_t CRC_Update(uint16_t Crc, const void *pBuffer, uint16_t Size)
+{
+	const uint8_t *pData = (const uint8_t *)pBuffer;
+	uint16_t i;
+	uint8_t j;
+
+	for (i = 0; i < Size; i++) {
+		Crc ^= pData[i] << 8;
+		for (j = 0; j < 8; j++) {
+			if (Crc & 0x8000U) {
+				Crc = (Crc << 1) ^ 0x1021U;
+			} else {
+				Crc <<= 1;
+			}
+		}
+	}
+
+	return Crc;
+}
+
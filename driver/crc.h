@@ -21,6 +21,9 @@
 
 void CRC_Init(void);
 uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size);
+// Software CRC-16/XMODEM that can be continued across buffers, starting
+// from Crc = 0. Matches CRC_Calculate over the concatenated data.
+uint16_t CRC_Update(uint16_t Crc, const void *pBuffer, uint16_t Size);
 
 #endif
 
@@ -18,7 +18,19 @@
 #include "../driver/i2c.h"
 #include "../driver/system.h"
 
-void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
+// Max number of address polls while the chip is busy programming a page.
+// Each poll is a start + address byte (~20us), so this covers the 5ms tWR
+// of the BL24C64 with plenty of margin before falling back to the old 10ms.
+#define EEPROM_POLL_LIMIT 1000U
+
+static uint8_t gPage[EEPROM_PAGE_SIZE];
+static uint16_t gPageAddress = 0xFFFFU;
+static uint32_t gPageDirty;
+static uint8_t gBatchDepth;
+
+EEPROM_Stats_t gEepromStats;
+
+static void ReadChip(uint16_t Address, void *pBuffer, uint8_t Size)
 {
 	I2C_Start();
 
@@ -36,20 +48,120 @@ void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
 	I2C_Stop();
 }
 
-void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
+static void WaitForWrite(void)
+{
+	uint16_t i;
+
+	for (i = 0; i < EEPROM_POLL_LIMIT; i++) {
+		int Ack;
 
+		I2C_Start();
+		Ack = I2C_Write(0xA0);
+		I2C_Stop();
+		if (Ack == 0) {
+			gEepromStats.Polls += i;
+			return;
+		}
+	}
+
+	gEepromStats.Timeouts++;
+	SYSTEM_DelayMs(10);
+}
+
+static void FlushPage(void)
 {
+	uint8_t First;
+	uint8_t Last;
+
+	if (gPageDirty == 0) {
+		return;
+	}
+
+	First = 0;
+	while ((gPageDirty & (1U << First)) == 0) {
+		First++;
+	}
+	Last = EEPROM_PAGE_SIZE - 1;
+	while ((gPageDirty & (1U << Last)) == 0) {
+		Last--;
+	}
+
+	// Untouched bytes between First and Last were read from the chip when the
+	// page was opened, so rewriting them as part of the burst is harmless.
 	I2C_Start();
 
 	I2C_Write(0xA0);
 
-	I2C_Write((Address >> 8) & 0xFF);
-	I2C_Write((Address >> 0) & 0xFF);
+	I2C_Write(((gPageAddress + First) >> 8) & 0xFF);
+	I2C_Write(((gPageAddress + First) >> 0) & 0xFF);
 
-	I2C_WriteBuffer(pBuffer, 8);
+	I2C_WriteBuffer(gPage + First, Last - First + 1);
 
 	I2C_Stop();
 
-	SYSTEM_DelayMs(10);
+	WaitForWrite();
+
+	gEepromStats.PageWrites++;
+	gEepromStats.BytesWritten += Last - First + 1;
+	gPageDirty = 0;
+}
+
+void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
+{
+	uint8_t *pData = (uint8_t *)pBuffer;
+	uint8_t i;
+
+	ReadChip(Address, pBuffer, Size);
+
+	// Overlay bytes still waiting in the write-combining page.
+	if (gPageDirty == 0) {
+		return;
+	}
+	for (i = 0; i < Size; i++) {
+		const uint16_t Offset = (uint16_t)(Address + i - gPageAddress);
+
+		if (Offset < EEPROM_PAGE_SIZE && (gPageDirty & (1U << Offset))) {
+			pData[i] = gPage[Offset];
+		}
+	}
+}
+
+void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
+{
+	const uint8_t *pData = (const uint8_t *)pBuffer;
+	uint8_t i;
+
+	gEepromStats.BytesRequested += 8;
+
+	// The CPS may hand over any offset, so the 8 bytes can straddle a page.
+	for (i = 0; i < 8; i++) {
+		const uint16_t PageAddress = (Address + i) & ~(EEPROM_PAGE_SIZE - 1U);
+		const uint8_t Offset = (Address + i) - PageAddress;
+
+		if (PageAddress != gPageAddress) {
+			FlushPage();
+			ReadChip(PageAddress, gPage, EEPROM_PAGE_SIZE);
+			gPageAddress = PageAddress;
+		}
+		if (gPage[Offset] != pData[i]) {
+			gPage[Offset] = pData[i];
+			gPageDirty |= 1U << Offset;
+		}
+	}
+
+	if (gBatchDepth == 0) {
+		FlushPage();
+	}
 }
 
+void EEPROM_BeginBatch(void)
+{
+	gBatchDepth++;
+}
+
+void EEPROM_EndBatch(void)
+{
+	if (gBatchDepth && --gBatchDepth == 0) {
+		FlushPage();
+	}
+}
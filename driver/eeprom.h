@@ -19,8 +19,27 @@
 
 #include <stdint.h>
 
+// BL24C64 page size. Writes are gathered per page and burst in one cycle.
+#define EEPROM_PAGE_SIZE 32U
+
+typedef struct {
+	uint32_t BytesRequested;
+	uint32_t BytesWritten;
+	uint16_t PageWrites;
+	uint16_t Timeouts;
+	uint32_t Polls;
+} EEPROM_Stats_t;
+
+extern EEPROM_Stats_t gEepromStats;
+
 void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size);
 void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer);
 
+// Writes between Begin/End are coalesced into whole-page bursts; outside a
+// batch every EEPROM_WriteBuffer is flushed immediately (skipping unchanged
+// bytes). Batches nest.
+void EEPROM_BeginBatch(void);
+void EEPROM_EndBatch(void);
+
 #endif
 
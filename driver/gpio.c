@@ -14,11 +14,20 @@
  *     limitations under the License.
  */
 
+#include "ARMCM0.h"
 #include "../driver/gpio.h"
 
+// The ports have no set/clear registers, and interrupt handlers drive pins
+// too (the LCD DMA handler toggles A0 on GPIOB, the spectrum sampler clocks
+// the BK4819 on GPIOC), so each read-modify-write runs with interrupts off.
+
 void GPIO_ClearBit(volatile uint32_t *pReg, uint8_t Bit)
 {
+	const uint32_t Mask = __get_PRIMASK();
+
+	__disable_irq();
 	*pReg &= ~(1U << Bit);
+	__set_PRIMASK(Mask);
 }
 
 uint8_t GPIO_CheckBit(volatile const uint32_t *pReg, uint8_t Bit)
@@ -28,11 +37,29 @@ uint8_t GPIO_CheckBit(volatile const uint32_t *pReg, uint8_t Bit)
 
 void GPIO_FlipBit(volatile uint32_t *pReg, uint8_t Bit)
 {
+	const uint32_t Mask = __get_PRIMASK();
+
+	__disable_irq();
 	*pReg ^= 1U << Bit;
+	__set_PRIMASK(Mask);
 }
 
 void GPIO_SetBit(volatile uint32_t *pReg, uint8_t Bit)
 {
+	const uint32_t Mask = __get_PRIMASK();
+
+	__disable_irq();
 	*pReg |= 1U << Bit;
+	__set_PRIMASK(Mask);
+}
+
+
+void GPIO_ClearBitIrqOff(volatile uint32_t *pReg, uint8_t Bit)
+{
+	*pReg &= ~(1U << Bit);
 }
 
+void GPIO_SetBitIrqOff(volatile uint32_t *pReg, uint8_t Bit)
+{
+	*pReg |= 1U << Bit;
+}
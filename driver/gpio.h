@@ -65,5 +65,10 @@ uint8_t GPIO_CheckBit(volatile const uint32_t *pReg, uint8_t Bit);
 void GPIO_FlipBit(volatile uint32_t *pReg, uint8_t Bit);
 void GPIO_SetBit(volatile uint32_t *pReg, uint8_t Bit);
 
+// Same without the interrupt masking, for bit-banged buses that already keep
+// interrupts off for the whole transfer.
+void GPIO_ClearBitIrqOff(volatile uint32_t *pReg, uint8_t Bit);
+void GPIO_SetBitIrqOff(volatile uint32_t *pReg, uint8_t Bit);
+
 #endif
 
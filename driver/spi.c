@@ -57,6 +57,13 @@ void SPI_WaitForUndocumentedTxFifoStatusBit(void)
 	} while (Timeout <= 100000);
 }
 
+void SPI_WriteByte(volatile SPI_Port_t *pPort, uint8_t Value)
+{
+	while ((pPort->FIFOST & SPI_FIFOST_TFF_MASK) != SPI_FIFOST_TFF_BITS_NOT_FULL) {
+	}
+	pPort->WDR = Value;
+}
+
 void SPI_Disable(volatile uint32_t *pCR)
 {
 	*pCR = (*pCR & ~SPI_CR_SPE_MASK) | SPI_CR_SPE_BITS_DISABLE;
@@ -37,6 +37,7 @@ typedef struct {
 
 void SPI0_Init(void);
 void SPI_WaitForUndocumentedTxFifoStatusBit(void);
+void SPI_WriteByte(volatile SPI_Port_t *pPort, uint8_t Value);
 
 void SPI_Disable(volatile uint32_t *pCR);
 void SPI_Configure(volatile SPI_Port_t *pPort, SPI_Config_t *pConfig);
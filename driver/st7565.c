@@ -15,6 +15,11 @@
  */
 
 #include "driver/st7565.h"
+#if defined(ENABLE_LCD_DMA)
+#include "ARMCM0.h"
+#include "bsp/dp32g030/dma.h"
+#include "bsp/dp32g030/irq.h"
+#endif
 #include "bsp/dp32g030/gpio.h"
 #include "bsp/dp32g030/spi.h"
 #include "driver/gpio.h"
@@ -22,31 +27,208 @@
 #include "driver/system.h"
 #include "misc.h"
 #include <stdint.h>
+#include <string.h>
 
 uint8_t gStatusLine[128];
 uint8_t gFrameBuffer[7][128];
 
+// What the panel currently shows, page 0 being the status line. Blits only
+// send the column span that differs from it.
+static uint8_t gSentPages[8][128];
+// bit N set when gSentPages[N] matches the panel RAM
+static uint8_t gSentPagesValid;
+
+// Find the column span of pLine that differs from what was sent last time.
+// Returns false when the page is already up to date.
+static bool ST7565_GetDirtySpan(uint8_t Page, const uint8_t *pLine,
+                                uint8_t *pStart, uint8_t *pEnd) {
+  const uint8_t *pSent = gSentPages[Page];
+  uint8_t Start = 0;
+  uint8_t End = LCD_WIDTH;
+
+  if (gSentPagesValid & (1U << Page)) {
+    while (Start < End && pLine[Start] == pSent[Start]) {
+      Start++;
+    }
+    if (Start == End) {
+      return false;
+    }
+    while (pLine[End - 1] == pSent[End - 1]) {
+      End--;
+    }
+  }
+
+  *pStart = Start;
+  *pEnd = End;
+  return true;
+}
+
+#if defined(ENABLE_LCD_DMA)
+// gSentPages doubles as the DMA source: a page is copied there when queued,
+// so the UI may keep drawing into gFrameBuffer while the flush runs. Only
+// the page on the wire is locked; any other page can be queued or widened
+// while a flush is running and goes out with it.
+#define ST7565_NO_PAGE 0xFF
+
+static uint8_t gSpanStart[8];
+static uint8_t gSpanEnd[8];
+static volatile uint8_t gQueuedPages;
+static volatile uint8_t gActivePage = ST7565_NO_PAGE;
+static volatile bool gFlushActive;
+
+static void ST7565_QueuePage(uint8_t Page, const uint8_t *pLine) {
+  uint8_t Start, End;
+  uint32_t Mask;
+
+  for (;;) {
+    Mask = __get_PRIMASK();
+    __disable_irq();
+    if (!ST7565_GetDirtySpan(Page, pLine, &Start, &End)) {
+      __set_PRIMASK(Mask);
+      return;
+    }
+    if (gActivePage != Page) {
+      break;
+    }
+    __set_PRIMASK(Mask);
+  }
+
+  memcpy(&gSentPages[Page][Start], &pLine[Start], End - Start);
+  if (gQueuedPages & (1U << Page)) {
+    if (gSpanStart[Page] < Start) {
+      Start = gSpanStart[Page];
+    }
+    if (gSpanEnd[Page] > End) {
+      End = gSpanEnd[Page];
+    }
+  }
+  gSpanStart[Page] = Start;
+  gSpanEnd[Page] = End;
+  gSentPagesValid |= 1U << Page;
+  gQueuedPages |= 1U << Page;
+
+  __set_PRIMASK(Mask);
+}
+
+// Runs from thread context for the first page, then from HandlerDMA
+static void ST7565_SendNextPage(void) {
+  uint8_t Page;
+
+  SPI_WaitForUndocumentedTxFifoStatusBit();
+  gActivePage = ST7565_NO_PAGE;
+
+  if (!gQueuedPages) {
+    SPI0->CR &= ~SPI_CR_TXDMAEN_MASK;
+    SPI_ToggleMasterMode(&SPI0->CR, true);
+    gFlushActive = false;
+    return;
+  }
+
+  for (Page = 0; !(gQueuedPages & (1U << Page)); Page++) {
+  }
+  gQueuedPages &= ~(1U << Page);
+  gActivePage = Page;
+
+  ST7565_SelectColumnAndLine(gSpanStart[Page] + 4U, Page);
+  GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
+
+  DMA_CH1->MSADDR = (uint32_t)(uintptr_t)&gSentPages[Page][gSpanStart[Page]];
+  DMA_CH1->MDADDR = (uint32_t)(uintptr_t)&SPI0->WDR;
+  DMA_CH1->MOD = 0
+                 // Source
+                 | DMA_CH_MOD_MS_ADDMOD_BITS_INCREMENT |
+                 DMA_CH_MOD_MS_SIZE_BITS_8BIT | DMA_CH_MOD_MS_SEL_BITS_SRAM
+                 // Destination, SPI0 TX request
+                 | DMA_CH_MOD_MD_ADDMOD_BITS_NONE |
+                 DMA_CH_MOD_MD_SIZE_BITS_8BIT |
+                 DMA_CH_MOD_MD_SEL_BITS_HSREQ_MS3;
+  DMA_CH1->CTR =
+      0 | DMA_CH_CTR_CH_EN_BITS_ENABLE |
+      (((gSpanEnd[Page] - gSpanStart[Page] - 1U) << DMA_CH_CTR_LENGTH_SHIFT) &
+       DMA_CH_CTR_LENGTH_MASK) |
+      DMA_CH_CTR_LOOP_BITS_DISABLE | DMA_CH_CTR_PRI_BITS_LOW;
+}
+
+// A flush already running picks the new pages up from HandlerDMA.
+static void ST7565_StartFlush(void) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  if (gFlushActive || !gQueuedPages) {
+    __set_PRIMASK(Mask);
+    return;
+  }
+  gFlushActive = true;
+
+  SPI_ToggleMasterMode(&SPI0->CR, false);
+  ST7565_WriteByte(0x40);
+  SPI0->CR |= SPI_CR_TXDMAEN_MASK;
+
+  DMA_INTST = DMA_INTST_CH1_TC_INTST_BITS_SET;
+  DMA_INTEN |= DMA_INTEN_CH1_TC_INTEN_BITS_ENABLE;
+  DMA_CTR = (DMA_CTR & ~DMA_CTR_DMAEN_MASK) | DMA_CTR_DMAEN_BITS_ENABLE;
+
+  ST7565_SendNextPage();
+  __set_PRIMASK(Mask);
+}
+
+void HandlerDMA(void);
+
+void HandlerDMA(void) {
+  if (DMA_INTST & DMA_INTST_CH1_TC_INTST_MASK) {
+    DMA_INTST = DMA_INTST_CH1_TC_INTST_BITS_SET;
+    ST7565_SendNextPage();
+  }
+}
+
+bool ST7565_IsFlushDone(void) { return !gFlushActive; }
+
+void ST7565_WaitForFlush(void) {
+  while (gFlushActive) {
+  }
+}
+#else
+static void ST7565_BlitPage(uint8_t Page, const uint8_t *pLine) {
+  uint8_t *pSent = gSentPages[Page];
+  uint8_t Start, End;
+
+  if (!ST7565_GetDirtySpan(Page, pLine, &Start, &End)) {
+    return;
+  }
+
+  ST7565_SelectColumnAndLine(Start + 4U, Page);
+  GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
+  for (uint8_t Column = Start; Column < End; Column++) {
+    pSent[Column] = pLine[Column];
+    SPI_WriteByte(SPI0, pSent[Column]);
+  }
+  SPI_WaitForUndocumentedTxFifoStatusBit();
+  gSentPagesValid |= 1U << Page;
+}
+
+bool ST7565_IsFlushDone(void) { return true; }
+
+void ST7565_WaitForFlush(void) {}
+#endif
+
 void ST7565_DrawLine(uint8_t Column, uint8_t Line, uint16_t Size,
                      const uint8_t *pBitmap, bool bIsClearMode) {
   uint16_t i;
 
+  ST7565_WaitForFlush();
+  gSentPagesValid &= ~(1U << Line);
+
   SPI_ToggleMasterMode(&SPI0->CR, false);
   ST7565_SelectColumnAndLine(Column + 4U, Line);
   GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
 
   if (!bIsClearMode) {
     for (i = 0; i < Size; i++) {
-      while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) !=
-             SPI_FIFOST_TFF_BITS_NOT_FULL) {
-      }
-      SPI0->WDR = pBitmap[i];
+      SPI_WriteByte(SPI0, pBitmap[i]);
     }
   } else {
     for (i = 0; i < Size; i++) {
-      while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) !=
-             SPI_FIFOST_TFF_BITS_NOT_FULL) {
-      }
-      SPI0->WDR = 0;
+      SPI_WriteByte(SPI0, 0);
     }
   }
 
@@ -56,57 +238,50 @@ void ST7565_DrawLine(uint8_t Column, uint8_t Line, uint16_t Size,
 
 void ST7565_BlitFullScreen(void) {
   uint8_t Line;
-  uint8_t Column;
 
+#if defined(ENABLE_LCD_DMA)
+  for (Line = 0; Line < ARRAY_SIZE(gFrameBuffer); Line++) {
+    ST7565_QueuePage(Line + 1U, gFrameBuffer[Line]);
+  }
+  ST7565_StartFlush();
+#else
   SPI_ToggleMasterMode(&SPI0->CR, false);
   ST7565_WriteByte(0x40);
 
   for (Line = 0; Line < ARRAY_SIZE(gFrameBuffer); Line++) {
-    ST7565_SelectColumnAndLine(4U, Line + 1U);
-    GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
-    for (Column = 0; Column < ARRAY_SIZE(gFrameBuffer[0]); Column++) {
-      while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) !=
-             SPI_FIFOST_TFF_BITS_NOT_FULL) {
-      }
-      SPI0->WDR = gFrameBuffer[Line][Column];
-    }
-    SPI_WaitForUndocumentedTxFifoStatusBit();
+    ST7565_BlitPage(Line + 1U, gFrameBuffer[Line]);
   }
 
   //SYSTEM_DelayMs(20);
   SPI_ToggleMasterMode(&SPI0->CR, true);
+#endif
 }
 
 void ST7565_BlitStatusLine(void) {
-  uint8_t i;
-
+#if defined(ENABLE_LCD_DMA)
+  ST7565_QueuePage(0, gStatusLine);
+  ST7565_StartFlush();
+#else
   SPI_ToggleMasterMode(&SPI0->CR, false);
   ST7565_WriteByte(0x40);
-  ST7565_SelectColumnAndLine(4, 0);
-  GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
-
-  for (i = 0; i < ARRAY_SIZE(gStatusLine); i++) {
-    while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) !=
-           SPI_FIFOST_TFF_BITS_NOT_FULL) {
-    }
-    SPI0->WDR = gStatusLine[i];
-  }
-  SPI_WaitForUndocumentedTxFifoStatusBit();
+  ST7565_BlitPage(0, gStatusLine);
   SPI_ToggleMasterMode(&SPI0->CR, true);
+#endif
 }
 
 void ST7565_FillScreen(uint8_t Value) {
   uint8_t i, j;
 
+  ST7565_WaitForFlush();
+  memset(gSentPages, Value, sizeof(gSentPages));
+  gSentPagesValid = 0xFF;
+
   SPI_ToggleMasterMode(&SPI0->CR, false);
   for (i = 0; i < 8; i++) {
     ST7565_SelectColumnAndLine(0, i);
     GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
     for (j = 0; j < 132; j++) {
-      while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) !=
-             SPI_FIFOST_TFF_BITS_NOT_FULL) {
-      }
-      SPI0->WDR = Value;
+      SPI_WriteByte(SPI0, Value);
     }
     SPI_WaitForUndocumentedTxFifoStatusBit();
   }
@@ -115,6 +290,9 @@ void ST7565_FillScreen(uint8_t Value) {
 
 void ST7565_Init(void) {
   SPI0_Init();
+#if defined(ENABLE_LCD_DMA)
+  NVIC_EnableIRQ(DP32_DMA_IRQn);
+#endif
   ST7565_Configure_GPIO_B11();
   SPI_ToggleMasterMode(&SPI0->CR, false);
   ST7565_WriteByte(0xE2);
@@ -144,6 +322,8 @@ void ST7565_Init(void) {
 }
 
 void ST7565_Configure_GPIO_B11(void) {
+  ST7565_WaitForFlush();
+  gSentPagesValid = 0;
   GPIO_SetBit(&GPIOB->DATA, GPIOB_PIN_ST7565_RES);
   SYSTEM_DelayMs(1);
   GPIO_ClearBit(&GPIOB->DATA, GPIOB_PIN_ST7565_RES);
@@ -154,21 +334,13 @@ void ST7565_Configure_GPIO_B11(void) {
 
 void ST7565_SelectColumnAndLine(uint8_t Column, uint8_t Line) {
   GPIO_ClearBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
-  while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) != SPI_FIFOST_TFF_BITS_NOT_FULL) {
-  }
-  SPI0->WDR = Line + 0xB0;
-  while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) != SPI_FIFOST_TFF_BITS_NOT_FULL) {
-  }
-  SPI0->WDR = ((Column >> 4) & 0x0F) | 0x10;
-  while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) != SPI_FIFOST_TFF_BITS_NOT_FULL) {
-  }
-  SPI0->WDR = ((Column >> 0) & 0x0F);
+  SPI_WriteByte(SPI0, Line + 0xB0);
+  SPI_WriteByte(SPI0, ((Column >> 4) & 0x0F) | 0x10);
+  SPI_WriteByte(SPI0, ((Column >> 0) & 0x0F));
   SPI_WaitForUndocumentedTxFifoStatusBit();
 }
 
 void ST7565_WriteByte(uint8_t Value) {
   GPIO_ClearBit(&GPIOB->DATA, GPIOB_PIN_ST7565_A0);
-  while ((SPI0->FIFOST & SPI_FIFOST_TFF_MASK) != SPI_FIFOST_TFF_BITS_NOT_FULL) {
-  }
-  SPI0->WDR = Value;
+  SPI_WriteByte(SPI0, Value);
 }
@@ -33,6 +33,9 @@ void ST7565_Init(void);
 void ST7565_Configure_GPIO_B11(void);
 void ST7565_SelectColumnAndLine(uint8_t Column, uint8_t Line);
 void ST7565_WriteByte(uint8_t Value);
+// Blits return once the changed pages are queued when ENABLE_LCD_DMA is set
+bool ST7565_IsFlushDone(void);
+void ST7565_WaitForFlush(void);
 
 #endif
 
@@ -21,12 +21,25 @@
 // 0x20000324
 static uint32_t gTickMultiplier;
 
+static volatile uint32_t gSleepCycles;
+static uint32_t gIdleWindowStart;
+
 void SYSTICK_Init(void)
 {
 	SysTick_Config(480000);
 	gTickMultiplier = 48;
 }
 
+void SYSTICK_SetPeriodUs(uint32_t Period)
+{
+	SysTick_Config(Period * gTickMultiplier);
+}
+
+uint32_t SYSTICK_GetPhaseUs(void)
+{
+	return (SysTick->LOAD - SysTick->VAL) / gTickMultiplier;
+}
+
 void SYSTICK_DelayUs(uint32_t Delay)
 {
 	uint32_t i;
@@ -52,3 +65,41 @@ void SYSTICK_DelayUs(uint32_t Delay)
 	} while (i < Delay * gTickMultiplier);
 }
 
+// Must be called with interrupts disabled, once the caller has checked that
+// there is nothing left to do. A pending interrupt still wakes the core; its
+// handler runs when interrupts are enabled again.
+void SYSTICK_Sleep(void)
+{
+	uint32_t Before;
+	uint32_t After;
+
+	(void)SysTick->CTRL; // clears COUNTFLAG
+	Before = SysTick->VAL;
+	__WFI();
+	After = SysTick->VAL;
+	if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+		gSleepCycles += Before + SysTick->LOAD + 1 - After;
+	} else {
+		gSleepCycles += Before - After;
+	}
+}
+
+uint8_t SYSTICK_GetIdlePercent(void)
+{
+	const uint32_t Ticks = gGlobalSysTickCounter - gIdleWindowStart;
+	uint32_t Cycles;
+
+	__disable_irq();
+	Cycles = gSleepCycles;
+	gSleepCycles = 0;
+	__enable_irq();
+	gIdleWindowStart += Ticks;
+
+	if (Ticks == 0) {
+		return 0;
+	}
+
+	// A tick is 10ms whatever the SysTick period: with a subtick handler
+	// LOAD is shorter and several interrupts make up one tick.
+	return Cycles / (Ticks * (10000 / 100) * gTickMultiplier);
+}
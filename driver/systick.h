@@ -21,6 +21,15 @@
 
 void SYSTICK_Init(void);
 void SYSTICK_DelayUs(uint32_t Delay);
+// Reloads the interrupt period, 10000 for the normal tick.
+void SYSTICK_SetPeriodUs(uint32_t Period);
+// Time since the last SysTick interrupt was due.
+uint32_t SYSTICK_GetPhaseUs(void);
+
+// Waits for the next interrupt, accounting the time spent asleep.
+void SYSTICK_Sleep(void);
+// Share of the time spent in SYSTICK_Sleep() since the previous call.
+uint8_t SYSTICK_GetIdlePercent(void);
 
 #endif
 
@@ -21,15 +21,14 @@
 #include "driver/uart.h"
 
 static bool UART_IsLogEnabled;
-uint8_t UART_DMA_Buffer[256];
+uint8_t UART_DMA_Buffer[UART_DMA_BUFFER_SIZE];
 
-void UART_Init(void)
+static uint32_t GetBaudDivisor(uint32_t BaudRate)
 {
 	uint32_t Delta;
 	uint32_t Positive;
 	uint32_t Frequency;
 
-	UART1->CTRL = (UART1->CTRL & ~UART_CTRL_UARTEN_MASK) | UART_CTRL_UARTEN_BITS_DISABLE;
 	Delta = SYSCON_RC_FREQ_DELTA;
 	Positive = (Delta & SYSCON_RC_FREQ_DELTA_RCHF_SIG_MASK) >> SYSCON_RC_FREQ_DELTA_RCHF_SIG_SHIFT;
 	Frequency = (Delta & SYSCON_RC_FREQ_DELTA_RCHF_DELTA_MASK) >> SYSCON_RC_FREQ_DELTA_RCHF_DELTA_SHIFT;
@@ -39,7 +38,16 @@ void UART_Init(void)
 		Frequency = 48000000U - Frequency;
 	}
 
-	UART1->BAUD = Frequency / 39053U;
+	// The stock divisor for 38400 is Frequency / 39053, i.e. the rate is
+	// padded by ~1/59. Keep the same correction for other rates.
+	return Frequency / (BaudRate + BaudRate / 59U);
+}
+
+void UART_Init(void)
+{
+	UART1->CTRL = (UART1->CTRL & ~UART_CTRL_UARTEN_MASK) | UART_CTRL_UARTEN_BITS_DISABLE;
+
+	UART1->BAUD = GetBaudDivisor(UART_BAUD_DEFAULT);
 	UART1->CTRL = UART_CTRL_RXEN_BITS_ENABLE | UART_CTRL_TXEN_BITS_ENABLE | UART_CTRL_RXDMAEN_BITS_ENABLE;
 	UART1->RXTO = 4;
 	UART1->FC = 0;
@@ -73,7 +81,7 @@ void UART_Init(void)
 		;
 	DMA_CH0->CTR = 0
 		| DMA_CH_CTR_CH_EN_BITS_ENABLE
-		| ((0xFF << DMA_CH_CTR_LENGTH_SHIFT) & DMA_CH_CTR_LENGTH_MASK)
+		| (((sizeof(UART_DMA_Buffer) - 1) << DMA_CH_CTR_LENGTH_SHIFT) & DMA_CH_CTR_LENGTH_MASK)
 		| DMA_CH_CTR_LOOP_BITS_ENABLE
 		| DMA_CH_CTR_PRI_BITS_MEDIUM
 		;
@@ -96,6 +104,15 @@ void UART_Send(const void *pBuffer, uint32_t Size)
 	}
 }
 
+void UART_SetBaudRate(uint32_t BaudRate)
+{
+	while (UART1->IF & UART_IF_TXBUSY_MASK) {
+	}
+	UART1->CTRL = (UART1->CTRL & ~UART_CTRL_UARTEN_MASK) | UART_CTRL_UARTEN_BITS_DISABLE;
+	UART1->BAUD = GetBaudDivisor(BaudRate);
+	UART1->CTRL |= UART_CTRL_UARTEN_BITS_ENABLE;
+}
+
 void UART_LogSend(const void *pBuffer, uint32_t Size)
 {
 	if (UART_IsLogEnabled) {
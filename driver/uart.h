@@ -20,10 +20,21 @@
 
 #include <stdint.h>
 
-extern uint8_t UART_DMA_Buffer[256];
+#define UART_BAUD_DEFAULT 38400U
+
+// Bulk CPS transfers keep a whole write window in flight, so the RX ring
+// has to hold it while the main loop is busy programming the EEPROM.
+#if defined(ENABLE_UART_BULK)
+#define UART_DMA_BUFFER_SIZE 512
+#else
+#define UART_DMA_BUFFER_SIZE 256
+#endif
+
+extern uint8_t UART_DMA_Buffer[UART_DMA_BUFFER_SIZE];
 
 void UART_Init(void);
 void UART_Send(const void *pBuffer, uint32_t Size);
+void UART_SetBaudRate(uint32_t BaudRate);
 void UART_LogSend(const void *pBuffer, uint32_t Size);
 
 #endif
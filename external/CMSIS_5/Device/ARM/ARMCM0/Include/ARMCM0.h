@@ -0,0 +1,3 @@
+#ifndef ARMCM0_H
+#error host shim not included
+#endif
@@ -0,0 +1,7 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stddef.h>
+void _putchar(char c);
+int printf_(const char* f, ...) { char b[256]; va_list a; va_start(a,f); int n=vsnprintf(b,sizeof b,f,a); va_end(a); for(int i=0;b[i];i++) _putchar(b[i]); return n; }
+int sprintf_(char* s, const char* f, ...) { va_list a; va_start(a,f); int n=vsprintf(s,f,a); va_end(a); return n; }
+int snprintf_(char* s, size_t c, const char* f, ...) { va_list a; va_start(a,f); int n=vsnprintf(s,c,f,a); va_end(a); return n; }
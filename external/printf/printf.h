@@ -0,0 +1,12 @@
+#ifndef _PRINTF_H_
+#define _PRINTF_H_
+#include <stdarg.h>
+#include <stddef.h>
+void _putchar(char character);
+#define printf printf_
+int printf_(const char* format, ...);
+#define sprintf sprintf_
+int sprintf_(char* buffer, const char* format, ...);
+#define snprintf  snprintf_
+int  snprintf_(char* buffer, size_t count, const char* format, ...);
+#endif
@@ -14,11 +14,13 @@
  *     limitations under the License.
  */
 
+#include "app/app.h"
 #include "app/dtmf.h"
 #include <string.h>
 #if defined(ENABLE_FMRADIO)
 #include "app/fm.h"
 #endif
+#include "audio.h"
 #include "bsp/dp32g030/gpio.h"
 #include "dcs.h"
 #if defined(ENABLE_FMRADIO)
@@ -58,20 +60,50 @@ void FUNCTION_Init(void) {
   g_CTCSS_Lost = false;
   g_VOX_Lost = false;
   g_SquelchLost = false;
-  gTailNoteEliminationCountdown = 0;
+  SCHEDULER_Cancel(&gTailNoteEliminationTimer);
   gFlagTteComplete = false;
   gFoundCTCSS = false;
   gFoundCDCSS = false;
-  gFoundCTCSSCountdown = 0;
-  gFoundCDCSSCountdown = 0;
+  SCHEDULER_Cancel(&gFoundCTCSSTimer);
+  SCHEDULER_Cancel(&gFoundCDCSSTimer);
   gEndOfRxDetectedMaybe = false;
-  gSystickCountdown2 = 0;
+}
+
+// Follows the DTMF reply, which has to go out unscrambled and without the
+// alarm tone.
+static void StartTransmitAudio(void) {
+  if (gCurrentFunction != FUNCTION_TRANSMIT) {
+    return;
+  }
+#if defined(ENABLE_TX1750)
+  if (gAlarmState != ALARM_STATE_OFF) {
+    if (gAlarmState == ALARM_STATE_TX1750) {
+      BK4819_TransmitTone(true, 1750);
+    }
+    SYSTEM_DelayMs(2);
+    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
+    gEnableSpeaker = true;
+    return;
+  }
+#endif
+  if (gCurrentVfo->SCRAMBLING_TYPE && gSetting_ScrambleEnable) {
+    BK4819_EnableScramble(gCurrentVfo->SCRAMBLING_TYPE - 1U);
+  } else {
+    BK4819_DisableScramble();
+  }
 }
 
 void FUNCTION_Select(FUNCTION_Type_t Function) {
   FUNCTION_Type_t PreviousFunction;
   bool bWasPowerSave;
 
+  // Tones are cut short rather than left to play over RX or TX.
+  if (Function == FUNCTION_TRANSMIT || Function == FUNCTION_RECEIVE ||
+      Function == FUNCTION_MONITOR) {
+    AUDIO_Stop();
+    APP_AbandonEndTransmission();
+  }
+
   PreviousFunction = gCurrentFunction;
   bWasPowerSave = (PreviousFunction == FUNCTION_POWER_SAVE);
   gCurrentFunction = Function;
@@ -133,24 +165,7 @@ void FUNCTION_Select(FUNCTION_Type_t Function) {
     RADIO_enableTX();
     BK4819_ToggleGpioOut(BK4819_GPIO5_PIN1_RED, true);
 
-    DTMF_Reply();
-
-#if defined(ENABLE_TX1750)
-    if (gAlarmState != ALARM_STATE_OFF) {
-      if (gAlarmState == ALARM_STATE_TX1750) {
-        BK4819_TransmitTone(true, 1750);
-      }
-      SYSTEM_DelayMs(2);
-      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-      gEnableSpeaker = true;
-      break;
-    }
-#endif
-    if (gCurrentVfo->SCRAMBLING_TYPE && gSetting_ScrambleEnable) {
-      BK4819_EnableScramble(gCurrentVfo->SCRAMBLING_TYPE - 1U);
-    } else {
-      BK4819_DisableScramble();
-    }
+    DTMF_Reply(StartTransmitAudio);
     break;
   }
   gBatterySaveCountdown = 1000;
@@ -0,0 +1,361 @@
+/* BK4819 model for the host build.
+ *
+ * Decodes the 3-wire bus from the GPIOC pins driven by driver/bk4819.c and
+ * backs it with a register file. Reads of the signal meters (RSSI, noise,
+ * glitch) are computed from a synthetic RF environment loaded from a text
+ * file with one entry per line:
+ *
+ *   noise <floor_dbm> [jitter_db]
+ *   <frequency_hz> <level_dbm> [width_hz] [start_ms]
+ *
+ * The RSSI squelch settles SQUELCH_SETTLE_US after every retune or threshold
+ * change, follows carriers keying up, and raises the REG_02 squelch
+ * interrupts enabled in REG_3F, so the time from squelch open to the audio
+ * path being switched on can be measured.
+ *
+ * Writes to the tone, TX mute and FSK registers and audio path switches can
+ * be traced to a file with their time, to check the sequence the tone
+ * player produces.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/bk4819-regs.h"
+#include "host/host.h"
+
+#define MAX_CARRIERS 32
+#define SQUELCH_SETTLE_US 1000U
+
+typedef struct {
+  uint32_t Frequency; // Hz
+  int16_t Level;      // dBm
+  uint32_t Width;     // Hz
+  uint64_t Start;     // us
+} Carrier_t;
+
+static Carrier_t gCarriers[MAX_CARRIERS];
+static uint8_t gCarrierCount;
+static int16_t gNoiseFloor = -125;
+static uint8_t gNoiseJitter = 2;
+
+static uint16_t gRegisters[128];
+
+static struct {
+  bool bOpen;
+  uint64_t SettleAt;  // no decision before this
+  uint64_t OpenedAt;  // last open not yet followed by an unmute, 0 if none
+  uint16_t Pending;   // raised, REG_0C bit 0
+  uint16_t Latched;   // handed over by the REG_02 write
+} gSquelch;
+
+static struct {
+  bool Scn;
+  bool Scl;
+  bool bActive;
+  uint8_t Bit;
+  uint8_t Register;
+  bool bRead;
+  uint16_t Value;
+} gBus = {.Scn = true};
+
+static FILE *gToneLog;
+
+HOST_BK4819_Stats_t gHostBK4819Stats;
+
+int HOST_BK4819_LoadEnvironment(const char *pPath) {
+  char Line[128];
+  FILE *f = fopen(pPath, "r");
+
+  if (f == NULL) {
+    return -1;
+  }
+
+  gCarrierCount = 0;
+  while (fgets(Line, sizeof(Line), f)) {
+    long a, b, c, d;
+    int n;
+
+    if (Line[0] == '#') {
+      continue;
+    }
+    n = sscanf(Line, "noise %ld %ld", &a, &b);
+    if (n >= 1) {
+      gNoiseFloor = a;
+      if (n == 2) {
+        gNoiseJitter = b;
+      }
+      continue;
+    }
+    n = sscanf(Line, "%ld %ld %ld %ld", &a, &b, &c, &d);
+    if (n >= 2 && gCarrierCount < MAX_CARRIERS) {
+      gCarriers[gCarrierCount].Frequency = a;
+      gCarriers[gCarrierCount].Level = b;
+      gCarriers[gCarrierCount].Width = n >= 3 ? c : 12500;
+      gCarriers[gCarrierCount].Start = n == 4 ? d * 1000ULL : 0;
+      gCarrierCount++;
+    }
+  }
+  fclose(f);
+
+  return 0;
+}
+
+static uint32_t GetFrequency(void) {
+  return ((uint32_t)gRegisters[BK4819_REG_39] << 16 |
+          gRegisters[BK4819_REG_38]) *
+         10U;
+}
+
+// Strongest carrier at the tuned frequency, falling off by 6dB for every
+// half channel width outside its occupied band.
+static int16_t GetSignalLevel(void) {
+  const uint32_t Frequency = GetFrequency();
+  const uint64_t Now = HOST_GetTimeUs();
+  int16_t Level = -200;
+  uint8_t i;
+
+  for (i = 0; i < gCarrierCount; i++) {
+    const Carrier_t *c = &gCarriers[i];
+    const uint32_t Half = c->Width / 2 ? c->Width / 2 : 1;
+    const uint32_t Offset = Frequency > c->Frequency
+                                ? Frequency - c->Frequency
+                                : c->Frequency - Frequency;
+    int32_t l = c->Level;
+
+    if (c->Start > Now) {
+      continue;
+    }
+    if (Offset > Half) {
+      l -= 6 * (int32_t)((Offset - Half + Half - 1) / Half);
+    }
+    if (l > Level) {
+      Level = l;
+    }
+  }
+
+  return Level;
+}
+
+// 0.5dB steps from -160dBm
+static int32_t GetRssi(void) {
+  const int16_t Signal = GetSignalLevel();
+
+  return ((Signal > gNoiseFloor ? Signal : gNoiseFloor) + 160) * 2;
+}
+
+// When the last carrier keyed up
+static uint64_t GetLastKeyUp(uint64_t Now) {
+  uint64_t Last = 0;
+  uint8_t i;
+
+  for (i = 0; i < gCarrierCount; i++) {
+    if (gCarriers[i].Start <= Now && gCarriers[i].Start > Last) {
+      Last = gCarriers[i].Start;
+    }
+  }
+
+  return Last;
+}
+
+static void UpdateSquelch(void) {
+  const uint64_t Now = HOST_GetTimeUs();
+  const uint16_t Thresholds = gRegisters[BK4819_REG_78];
+  const int32_t Rssi = GetRssi();
+  bool bOpen = gSquelch.bOpen;
+
+  if (Now < gSquelch.SettleAt) {
+    return;
+  }
+
+  if (!bOpen && Rssi >= (Thresholds >> 8)) {
+    bOpen = true;
+  } else if (bOpen && Rssi < (Thresholds & 0xFFU)) {
+    bOpen = false;
+  }
+  if (bOpen != gSquelch.bOpen) {
+    const uint16_t Event =
+        bOpen ? BK4819_REG_02_SQUELCH_LOST : BK4819_REG_02_SQUELCH_FOUND;
+
+    const uint64_t KeyUp = GetLastKeyUp(Now);
+
+    gSquelch.bOpen = bOpen;
+    gSquelch.OpenedAt = 0;
+    if (bOpen) {
+      gSquelch.OpenedAt =
+          KeyUp > gSquelch.SettleAt ? KeyUp : gSquelch.SettleAt;
+    }
+    gSquelch.Pending |= Event & gRegisters[BK4819_REG_3F];
+    if (bOpen) {
+      gHostBK4819Stats.SquelchOpens++;
+    }
+  }
+}
+
+static uint16_t ReadMeter(uint8_t Register) {
+  const int16_t Signal = GetSignalLevel();
+  const int16_t Floor = gNoiseFloor;
+  const int16_t Snr = Signal > Floor ? Signal - Floor : 0;
+  int32_t Rssi;
+
+  switch (Register) {
+  case BK4819_REG_67:
+    // with some noise on the floor
+    Rssi = GetRssi();
+    if (gNoiseJitter) {
+      Rssi += rand() % (4 * gNoiseJitter + 1) - 2 * gNoiseJitter;
+    }
+    return Rssi < 0 ? 0 : Rssi > 0x1FF ? 0x1FF : Rssi;
+  case BK4819_REG_65:
+    return Snr > 60 ? 0 : 0x7F - Snr * 2;
+  case BK4819_REG_63:
+    return Snr > 20 ? 0 : 0xFF - Snr * 12;
+  }
+
+  return 0;
+}
+
+static uint16_t ReadRegister(uint8_t Register) {
+  gHostBK4819Stats.Reads++;
+
+  switch (Register) {
+  case BK4819_REG_02:
+    return gSquelch.Latched;
+  case BK4819_REG_0C:
+    UpdateSquelch();
+    return gSquelch.Pending ? 1U : 0U;
+  case BK4819_REG_63:
+  case BK4819_REG_65:
+  case BK4819_REG_67:
+    return ReadMeter(Register);
+  }
+
+  return gRegisters[Register];
+}
+
+static void TraceTone(const char *pFormat, ...) {
+  const uint64_t Now = HOST_GetTimeUs();
+  va_list Args;
+
+  fprintf(gToneLog, "%6u.%u ", (unsigned int)(Now / 1000U),
+          (unsigned int)(Now / 100U % 10U));
+  va_start(Args, pFormat);
+  vfprintf(gToneLog, pFormat, Args);
+  va_end(Args);
+  fputc('\n', gToneLog);
+  fflush(gToneLog);
+}
+
+static void WriteRegister(uint8_t Register, uint16_t Value) {
+  gHostBK4819Stats.Writes++;
+
+  if (gToneLog) {
+    switch (Register) {
+    case BK4819_REG_30:
+    case BK4819_REG_50:
+    case BK4819_REG_59:
+    case BK4819_REG_70:
+    case BK4819_REG_71:
+    case BK4819_REG_72:
+      TraceTone("REG_%02X %04X", Register, Value);
+      break;
+    }
+  }
+
+  if (Register == BK4819_REG_00 && (Value & 0x8000U)) {
+    memset(gRegisters, 0, sizeof(gRegisters));
+    memset(&gSquelch, 0, sizeof(gSquelch));
+    return;
+  }
+  switch (Register) {
+  case BK4819_REG_02:
+    gSquelch.Latched = gSquelch.Pending;
+    gSquelch.Pending = 0;
+    break;
+  case BK4819_REG_39:
+    // the squelch starts closed on every new frequency
+    gHostBK4819Stats.Tunes++;
+    gSquelch.bOpen = false;
+    gSquelch.OpenedAt = 0;
+    // fall through
+  case BK4819_REG_78:
+    gSquelch.SettleAt = HOST_GetTimeUs() + SQUELCH_SETTLE_US;
+    break;
+  }
+  gRegisters[Register] = Value;
+}
+
+int HOST_BK4819_SetToneLog(const char *pPath) {
+  gToneLog = fopen(pPath, "w");
+
+  return gToneLog ? 0 : -1;
+}
+
+void HOST_BK4819_AudioPath(bool bEnabled) {
+  static bool bWasEnabled;
+  static bool bTracedEnabled;
+  uint32_t Latency;
+
+  if (gToneLog && bEnabled != bTracedEnabled) {
+    bTracedEnabled = bEnabled;
+    TraceTone("audio %s", bEnabled ? "on" : "off");
+  }
+
+  if (!bEnabled || bWasEnabled || gSquelch.OpenedAt == 0) {
+    bWasEnabled = bEnabled;
+    return;
+  }
+  bWasEnabled = true;
+
+  Latency = HOST_GetTimeUs() - gSquelch.OpenedAt;
+  gSquelch.OpenedAt = 0;
+  gHostBK4819Stats.Unmutes++;
+  gHostBK4819Stats.UnmuteLatencyTotalUs += Latency;
+  if (Latency > gHostBK4819Stats.UnmuteLatencyMaxUs) {
+    gHostBK4819Stats.UnmuteLatencyMaxUs = Latency;
+  }
+}
+
+void HOST_BK4819_Pins(bool Scn, bool Scl, bool Sda) {
+  if (gBus.Scn && !Scn) {
+    gBus.bActive = true;
+    gBus.Bit = 0;
+    gBus.Register = 0;
+    gBus.Value = 0;
+  } else if (!gBus.Scn && Scn) {
+    gBus.bActive = false;
+  } else if (gBus.bActive && !gBus.Scl && Scl) {
+    if (gBus.Bit < 8) {
+      gBus.Register = (gBus.Register << 1) | Sda;
+      if (++gBus.Bit == 8) {
+        gBus.bRead = gBus.Register & 0x80U;
+        gBus.Register &= 0x7FU;
+        if (gBus.bRead) {
+          gBus.Value = ReadRegister(gBus.Register);
+        }
+      }
+    } else if (gBus.Bit < 24) {
+      if (!gBus.bRead) {
+        gBus.Value = (gBus.Value << 1) | Sda;
+      }
+      if (++gBus.Bit == 24 && !gBus.bRead) {
+        WriteRegister(gBus.Register, gBus.Value);
+      }
+    }
+  }
+
+  gBus.Scn = Scn;
+  gBus.Scl = Scl;
+}
+
+bool HOST_BK4819_GetSda(bool *pLevel) {
+  if (!gBus.bActive || !gBus.bRead || gBus.Bit < 8 || gBus.Bit >= 24) {
+    return false;
+  }
+
+  // The master samples each bit before raising SCL for it.
+  *pLevel = (gBus.Value >> (23 - gBus.Bit)) & 1U;
+  return true;
+}
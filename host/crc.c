@@ -0,0 +1,26 @@
+/* CRC driver for the host build.
+ *
+ * The DP32G030 CRC engine is not modelled, so the CCITT checksum of UART
+ * commands and replies is computed in software.
+ */
+
+#include "driver/crc.h"
+
+void CRC_Init(void) {}
+
+uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size) {
+  return CRC_Update(0, pBuffer, Size);
+}
+
+uint16_t CRC_Update(uint16_t Crc, const void *pBuffer, uint16_t Size) {
+  const uint8_t *pData = (const uint8_t *)pBuffer;
+
+  for (uint16_t i = 0; i < Size; i++) {
+    Crc ^= pData[i] << 8;
+    for (uint8_t j = 0; j < 8; j++) {
+      Crc = Crc & 0x8000U ? (Crc << 1) ^ 0x1021U : Crc << 1;
+    }
+  }
+
+  return Crc;
+}
@@ -0,0 +1,205 @@
+/* BL24C64 model for the host build.
+ *
+ * Decodes the bit-banged I2C bus from the GPIOA pins driven by driver/i2c.c.
+ * Page writes wrap inside 32-byte pages and are programmed on STOP; the chip
+ * then NACKs its address for the 5ms write cycle, like the real part, so
+ * the driver's ACK polling is exercised. The contents are backed by an image
+ * file that is rewritten after every programmed page.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host/host.h"
+
+#define EEPROM_SIZE 0x2000U
+#define EEPROM_PAGE 32U
+#define EEPROM_WRITE_CYCLE_US 5000U
+
+enum {
+  STATE_IDLE,
+  STATE_DEVICE,
+  STATE_OFFSET_HI,
+  STATE_OFFSET_LO,
+  STATE_WRITE,
+  STATE_READ,
+};
+
+static uint8_t gMemory[EEPROM_SIZE];
+static FILE *gImage;
+static uint64_t gBusyUntil;
+
+static uint8_t gPage[EEPROM_PAGE];
+static uint32_t gPageDirty;
+static uint16_t gPageAddress;
+
+static struct {
+  bool Scl;
+  bool Sda;
+  uint8_t State;
+  uint8_t Bit;
+  uint8_t Shift;
+  bool bTransmit;
+  bool bMasterAck;
+  bool SdaOut;
+  uint16_t Address;
+} gBus = {.Scl = true, .Sda = true, .SdaOut = true};
+
+HOST_EEPROM_Stats_t gHostEepromStats;
+
+int HOST_EEPROM_Load(const char *pPath) {
+  memset(gMemory, 0xFF, sizeof(gMemory));
+
+  gImage = fopen(pPath, "r+b");
+  if (gImage == NULL) {
+    gImage = fopen(pPath, "w+b");
+    if (gImage == NULL) {
+      return -1;
+    }
+    fwrite(gMemory, 1, sizeof(gMemory), gImage);
+    fflush(gImage);
+    return 0;
+  }
+
+  if (fread(gMemory, 1, sizeof(gMemory), gImage) != sizeof(gMemory)) {
+    // short image: keep the erased tail
+  }
+
+  return 0;
+}
+
+static void ProgramPage(void) {
+  uint8_t i;
+
+  if (gPageDirty == 0) {
+    return;
+  }
+
+  for (i = 0; i < EEPROM_PAGE; i++) {
+    if (gPageDirty & (1U << i)) {
+      gMemory[gPageAddress + i] = gPage[i];
+      gHostEepromStats.BytesWritten++;
+    }
+  }
+  gPageDirty = 0;
+  gHostEepromStats.PageWrites++;
+  gBusyUntil = HOST_GetTimeUs() + EEPROM_WRITE_CYCLE_US;
+
+  if (gImage) {
+    fseek(gImage, gPageAddress, SEEK_SET);
+    fwrite(gMemory + gPageAddress, 1, EEPROM_PAGE, gImage);
+    fflush(gImage);
+  }
+}
+
+static bool ReceiveByte(uint8_t Byte) {
+  switch (gBus.State) {
+  case STATE_DEVICE:
+    if ((Byte & 0xFEU) != 0xA0U) {
+      gBus.State = STATE_IDLE;
+      return false;
+    }
+    if (HOST_GetTimeUs() < gBusyUntil) {
+      gHostEepromStats.BusyNacks++;
+      gBus.State = STATE_IDLE;
+      return false;
+    }
+    gBus.State = (Byte & 1U) ? STATE_READ : STATE_OFFSET_HI;
+    return true;
+
+  case STATE_OFFSET_HI:
+    gBus.Address = (Byte << 8) & (EEPROM_SIZE - 1);
+    gBus.State = STATE_OFFSET_LO;
+    return true;
+
+  case STATE_OFFSET_LO:
+    gBus.Address |= Byte;
+    gPageAddress = gBus.Address & ~(EEPROM_PAGE - 1);
+    gPageDirty = 0;
+    gBus.State = STATE_WRITE;
+    return true;
+
+  case STATE_WRITE:
+    gPage[gBus.Address & (EEPROM_PAGE - 1)] = Byte;
+    gPageDirty |= 1U << (gBus.Address & (EEPROM_PAGE - 1));
+    gBus.Address = gPageAddress | ((gBus.Address + 1) & (EEPROM_PAGE - 1));
+    return true;
+  }
+
+  return false;
+}
+
+static void LoadTransmitByte(void) {
+  gBus.Shift = gMemory[gBus.Address];
+  gBus.Address = (gBus.Address + 1) & (EEPROM_SIZE - 1);
+  gBus.SdaOut = gBus.Shift >> 7;
+  gHostEepromStats.BytesRead++;
+}
+
+static void OnRisingEdge(bool Sda) {
+  if (gBus.Bit < 8) {
+    if (!gBus.bTransmit) {
+      gBus.Shift = (gBus.Shift << 1) | Sda;
+    }
+    gBus.Bit++;
+  } else {
+    gBus.bMasterAck = !Sda;
+    gBus.Bit = 9;
+  }
+}
+
+static void OnFallingEdge(void) {
+  if (gBus.Bit == 8) {
+    // release for the master's ACK, or acknowledge what we received
+    gBus.SdaOut = gBus.bTransmit ? true : !ReceiveByte(gBus.Shift);
+  } else if (gBus.Bit == 9) {
+    gBus.Bit = 0;
+    gBus.Shift = 0;
+    gBus.SdaOut = true;
+    if (gBus.bTransmit) {
+      if (gBus.bMasterAck) {
+        LoadTransmitByte();
+      } else {
+        gBus.bTransmit = false;
+        gBus.State = STATE_IDLE;
+      }
+    } else if (gBus.State == STATE_READ) {
+      gBus.bTransmit = true;
+      LoadTransmitByte();
+    }
+  } else if (gBus.bTransmit) {
+    gBus.SdaOut = (gBus.Shift >> (7 - gBus.Bit)) & 1U;
+  }
+}
+
+void HOST_EEPROM_Pins(bool Scl, bool Sda) {
+  const bool Line = Sda && gBus.SdaOut;
+
+  if (gBus.Scl && Scl && gBus.Sda != Line) {
+    if (!Line) {
+      // START, or a repeated START that aborts a pending page write
+      gBus.State = STATE_DEVICE;
+      gPageDirty = 0;
+    } else {
+      if (gBus.State == STATE_WRITE) {
+        ProgramPage();
+      }
+      gBus.State = STATE_IDLE;
+    }
+    gBus.Bit = 0;
+    gBus.Shift = 0;
+    gBus.bTransmit = false;
+    gBus.SdaOut = true;
+  } else if (gBus.State != STATE_IDLE || gBus.bTransmit) {
+    if (!gBus.Scl && Scl) {
+      OnRisingEdge(Sda);
+    } else if (gBus.Scl && !Scl) {
+      OnFallingEdge();
+    }
+  }
+
+  gBus.Scl = Scl;
+  gBus.Sda = Sda && gBus.SdaOut;
+}
+
+bool HOST_EEPROM_GetSda(void) { return gBus.SdaOut; }
@@ -0,0 +1,86 @@
+/* GPIO driver for the host build.
+ *
+ * Same register semantics as driver/gpio.c, including the interrupt masking
+ * around each read-modify-write, but every change to the pins of a
+ * bit-banged bus is forwarded to the matching device model, and reads of a
+ * data line return the wired-AND of master and device.
+ */
+
+#include "bsp/dp32g030/gpio.h"
+#include "driver/gpio.h"
+#include "host/host.h"
+
+static bool IsOutput(volatile uint32_t *pDir, uint8_t Bit) {
+  return (*pDir >> Bit) & 1U;
+}
+
+static bool MasterLevel(volatile uint32_t *pData, volatile uint32_t *pDir,
+                        uint8_t Bit) {
+  // A released (input) pin floats high through the bus pull-up.
+  return !IsOutput(pDir, Bit) || ((*pData >> Bit) & 1U);
+}
+
+static void UpdateBuses(volatile const uint32_t *pReg) {
+  if (pReg == &GPIOA->DATA) {
+    HOST_EEPROM_Pins(
+        (GPIOA->DATA >> GPIOA_PIN_I2C_SCL) & 1U,
+        MasterLevel(&GPIOA->DATA, &GPIOA->DIR, GPIOA_PIN_I2C_SDA));
+  } else if (pReg == &GPIOC->DATA) {
+    HOST_BK4819_AudioPath((GPIOC->DATA >> GPIOC_PIN_AUDIO_PATH) & 1U);
+    HOST_BK4819_Pins(
+        (GPIOC->DATA >> GPIOC_PIN_BK4819_SCN) & 1U,
+        (GPIOC->DATA >> GPIOC_PIN_BK4819_SCL) & 1U,
+        MasterLevel(&GPIOC->DATA, &GPIOC->DIR, GPIOC_PIN_BK4819_SDA));
+  }
+}
+
+void GPIO_ClearBit(volatile uint32_t *pReg, uint8_t Bit) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  *pReg &= ~(1U << Bit);
+  UpdateBuses(pReg);
+  __set_PRIMASK(Mask);
+}
+
+uint8_t GPIO_CheckBit(volatile const uint32_t *pReg, uint8_t Bit) {
+  bool Level;
+
+  if (pReg == &GPIOA->DATA && Bit == GPIOA_PIN_I2C_SDA) {
+    return MasterLevel(&GPIOA->DATA, &GPIOA->DIR, Bit) && HOST_EEPROM_GetSda();
+  }
+  if (pReg == &GPIOC->DATA && Bit == GPIOC_PIN_BK4819_SDA &&
+      HOST_BK4819_GetSda(&Level)) {
+    return Level;
+  }
+
+  return (*pReg >> Bit) & 1U;
+}
+
+void GPIO_FlipBit(volatile uint32_t *pReg, uint8_t Bit) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  *pReg ^= 1U << Bit;
+  UpdateBuses(pReg);
+  __set_PRIMASK(Mask);
+}
+
+void GPIO_SetBit(volatile uint32_t *pReg, uint8_t Bit) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  *pReg |= 1U << Bit;
+  UpdateBuses(pReg);
+  __set_PRIMASK(Mask);
+}
+
+void GPIO_ClearBitIrqOff(volatile uint32_t *pReg, uint8_t Bit) {
+  *pReg &= ~(1U << Bit);
+  UpdateBuses(pReg);
+}
+
+void GPIO_SetBitIrqOff(volatile uint32_t *pReg, uint8_t Bit) {
+  *pReg |= 1U << Bit;
+  UpdateBuses(pReg);
+}
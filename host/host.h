@@ -0,0 +1,76 @@
+/* Models used by the host simulation build (make host).
+ *
+ * The firmware runs unmodified on top of these: peripheral registers are
+ * plain memory mapped at their DP32G030 addresses, the bit-banged BK4819
+ * and I2C EEPROM buses are decoded from GPIO edges, the LCD is decoded from
+ * the bytes sent on SPI0, and the keyboard, ADC, SysTick, UART and CRC
+ * drivers are replaced by host versions.
+ */
+
+#ifndef HOST_HOST_H
+#define HOST_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t Reads;
+  uint32_t Writes;
+  uint32_t Tunes;
+  uint32_t SquelchOpens;
+  uint32_t Unmutes; // audio path switched on after a squelch open
+  uint32_t UnmuteLatencyTotalUs;
+  uint32_t UnmuteLatencyMaxUs;
+} HOST_BK4819_Stats_t;
+
+typedef struct {
+  uint32_t BytesRead;
+  uint32_t BytesWritten;
+  uint32_t PageWrites;
+  uint32_t BusyNacks;
+} HOST_EEPROM_Stats_t;
+
+typedef struct {
+  uint32_t Blits;
+  uint32_t BytesSent;
+} HOST_LCD_Stats_t;
+
+typedef struct {
+  uint32_t BytesSent;
+  uint32_t BytesDropped; // sent while the pty was full
+  uint32_t BytesReceived;
+} HOST_UART_Stats_t;
+
+extern HOST_BK4819_Stats_t gHostBK4819Stats;
+extern HOST_EEPROM_Stats_t gHostEepromStats;
+extern HOST_LCD_Stats_t gHostLcdStats;
+extern HOST_UART_Stats_t gHostUartStats;
+
+int HOST_MapPeripherals(void);
+
+uint64_t HOST_GetTimeUs(void);
+
+int HOST_BK4819_LoadEnvironment(const char *pPath);
+void HOST_BK4819_Pins(bool Scn, bool Scl, bool Sda);
+bool HOST_BK4819_GetSda(bool *pLevel);
+void HOST_BK4819_AudioPath(bool bEnabled);
+int HOST_BK4819_SetToneLog(const char *pPath);
+
+int HOST_EEPROM_Load(const char *pPath);
+void HOST_EEPROM_Pins(bool Scl, bool Sda);
+bool HOST_EEPROM_GetSda(void);
+
+void HOST_LCD_SetOutput(const char *pPath);
+void HOST_LCD_Write(bool A0, uint8_t Value);
+void HOST_LCD_Release(void);
+const uint8_t *HOST_LCD_GetPage(uint8_t Page);
+
+void HOST_SPI_PollDma(void);
+
+void HOST_KEYBOARD_Init(void);
+
+int HOST_UART_Open(const char *pPath);
+void HOST_UART_Poll(void);
+uint32_t HOST_UART_GetBaudRate(void);
+
+#endif
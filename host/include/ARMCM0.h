@@ -0,0 +1,54 @@
+/* Host stand-in for the CMSIS device header.
+ *
+ * The host build force-includes this file, so the ARMCM0_H guard also turns
+ * the relative "../external/CMSIS_5/..." includes into no-ops.
+ */
+
+#ifndef ARMCM0_H
+#define ARMCM0_H
+
+#include <stdint.h>
+
+#define __IM volatile const
+#define __OM volatile
+#define __IOM volatile
+
+typedef int IRQn_Type;
+
+typedef struct {
+  __IOM uint32_t CTRL;
+  __IOM uint32_t LOAD;
+  __IOM uint32_t VAL;
+  __IM uint32_t CALIB;
+} SysTick_Type;
+
+extern SysTick_Type HOST_SysTick;
+#define SysTick (&HOST_SysTick)
+
+void HOST_DisableIrq(void);
+void HOST_EnableIrq(void);
+uint32_t HOST_GetIrqMask(void);
+void HOST_WaitForInterrupt(void);
+void HOST_Reset(void);
+
+static inline void __disable_irq(void) { HOST_DisableIrq(); }
+static inline void __enable_irq(void) { HOST_EnableIrq(); }
+static inline uint32_t __get_PRIMASK(void) { return HOST_GetIrqMask(); }
+static inline void __set_PRIMASK(uint32_t Mask) {
+  if (Mask & 1U) {
+    HOST_DisableIrq();
+  } else {
+    HOST_EnableIrq();
+  }
+}
+static inline void __WFI(void) { HOST_WaitForInterrupt(); }
+static inline void __NOP(void) {}
+static inline void __DSB(void) {}
+static inline void __ISB(void) {}
+
+static inline void NVIC_EnableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+static inline void NVIC_DisableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type IRQn) { (void)IRQn; }
+static inline void NVIC_SystemReset(void) { HOST_Reset(); }
+
+#endif
@@ -0,0 +1,106 @@
+/* Keyboard driver for the host build.
+ *
+ * Keys are read from the terminal without blocking. Each key press is held
+ * for a few polls so it passes the firmware's debounce, then released.
+ *
+ *   0-9 digits   m/Enter MENU   k/j UP/DOWN   e/Backspace EXIT
+ *   * STAR       f/# F          [ ] SIDE1/SIDE2
+ *   p toggles PTT  H holds the next key long enough for a long press
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "bsp/dp32g030/gpio.h"
+#include "driver/gpio.h"
+#include "driver/keyboard.h"
+#include "host/host.h"
+
+#define KEY_HOLD_POLLS 8
+#define KEY_LONG_HOLD_POLLS 40
+
+KEY_Code_t gKeyReading0 = KEY_INVALID;
+KEY_Code_t gKeyReading1 = KEY_INVALID;
+uint16_t gDebounceCounter;
+bool gWasFKeyPressed;
+
+static struct termios gSavedTermios;
+static bool gTermiosSaved;
+
+static void RestoreTerminal(void) {
+  if (gTermiosSaved) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &gSavedTermios);
+  }
+}
+
+void HOST_KEYBOARD_Init(void) {
+  if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &gSavedTermios) == 0) {
+    struct termios Raw = gSavedTermios;
+
+    Raw.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(STDIN_FILENO, TCSANOW, &Raw);
+    gTermiosSaved = true;
+    atexit(RestoreTerminal);
+  }
+  fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+static KEY_Code_t MapKey(char c) {
+  if (c >= '0' && c <= '9') {
+    return KEY_0 + (c - '0');
+  }
+  switch (c) {
+  case 'm':
+  case '\n':
+    return KEY_MENU;
+  case 'k':
+    return KEY_UP;
+  case 'j':
+    return KEY_DOWN;
+  case 'e':
+  case 0x7F:
+    return KEY_EXIT;
+  case '*':
+    return KEY_STAR;
+  case 'f':
+  case '#':
+    return KEY_F;
+  case '[':
+    return KEY_SIDE1;
+  case ']':
+    return KEY_SIDE2;
+  }
+
+  return KEY_INVALID;
+}
+
+KEY_Code_t KEYBOARD_Poll(void) {
+  static KEY_Code_t Key = KEY_INVALID;
+  static uint8_t Hold;
+  static bool bLong;
+  char c;
+
+  if (Hold) {
+    Hold--;
+    return Key;
+  }
+  if (read(STDIN_FILENO, &c, 1) == 1) {
+    if (c == 'p') {
+      // PTT is a GPIO, pulled up while released
+      GPIOC->DATA ^= 1U << GPIOC_PIN_PTT;
+      return KEY_INVALID;
+    }
+    if (c == 'H') {
+      bLong = true;
+      return KEY_INVALID;
+    }
+    Key = MapKey(c);
+    Hold = bLong ? KEY_LONG_HOLD_POLLS : KEY_HOLD_POLLS;
+    bLong = false;
+    return Key;
+  }
+
+  return KEY_INVALID;
+}
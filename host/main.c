@@ -0,0 +1,118 @@
+/* Entry point of the host simulation build.
+ *
+ *   uvk5-host [-e eeprom.bin] [-r rf.txt] [-l lcd.pbm] [-t tones.txt]
+ *             [-u tty]
+ *
+ * Maps the peripheral address space (host/peripherals.c), loads the device
+ * models and runs the unmodified Main(). Bus statistics are printed on exit
+ * (Ctrl-C). -t traces the tone register writes and audio path switches with
+ * their time in ms. -u exposes the UART as a pseudo terminal linked at the
+ * given path.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "driver/bk4819.h"
+#include "driver/eeprom.h"
+#include "host/host.h"
+#include "misc.h"
+
+void Main(void);
+
+static void PrintStats(void) {
+  const HOST_BK4819_Stats_t *pRadio = &gHostBK4819Stats;
+
+  fprintf(stderr, "idle: %u%%\n", gIdlePercent);
+  fprintf(stderr,
+          "squelch: %u opens, %u unmutes, latency avg %u us, max %u us\n",
+          pRadio->SquelchOpens, pRadio->Unmutes,
+          pRadio->Unmutes ? pRadio->UnmuteLatencyTotalUs / pRadio->Unmutes
+                          : 0,
+          pRadio->UnmuteLatencyMaxUs);
+  fprintf(stderr,
+          "bk4819: %u reads, %u writes, %u tunes, %u setup writes avoided\n"
+          "eeprom: %u bytes read, %u bytes written, %u pages, %u busy NACKs\n"
+          "eeprom driver: %u bytes requested, %u written, %u pages, %u polls, "
+          "%u timeouts\n"
+          "lcd: %u blits, %u bytes\n"
+          "uart: %u bytes sent, %u dropped, %u received\n",
+          gHostBK4819Stats.Reads, gHostBK4819Stats.Writes,
+          gHostBK4819Stats.Tunes, gBK4819_WritesAvoided,
+          gHostEepromStats.BytesRead,
+          gHostEepromStats.BytesWritten, gHostEepromStats.PageWrites,
+          gHostEepromStats.BusyNacks, gEepromStats.BytesRequested,
+          gEepromStats.BytesWritten, gEepromStats.PageWrites,
+          gEepromStats.Polls, gEepromStats.Timeouts, gHostLcdStats.Blits,
+          gHostLcdStats.BytesSent, gHostUartStats.BytesSent,
+          gHostUartStats.BytesDropped, gHostUartStats.BytesReceived);
+}
+
+static void OnInterrupt(int Signal) {
+  (void)Signal;
+  exit(0);
+}
+
+static void Usage(const char *pName) {
+  fprintf(stderr,
+          "usage: %s [-e eeprom.bin] [-r rf.txt] [-l lcd.pbm] [-t tones.txt] "
+          "[-u tty]\n",
+          pName);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *pEeprom = "eeprom.bin";
+  int c;
+
+  while ((c = getopt(argc, argv, "e:r:l:t:u:")) != -1) {
+    switch (c) {
+    case 'e':
+      pEeprom = optarg;
+      break;
+    case 'r':
+      if (HOST_BK4819_LoadEnvironment(optarg)) {
+        perror(optarg);
+        return 1;
+      }
+      break;
+    case 'l':
+      HOST_LCD_SetOutput(optarg);
+      break;
+    case 't':
+      if (HOST_BK4819_SetToneLog(optarg)) {
+        perror(optarg);
+        return 1;
+      }
+      break;
+    case 'u':
+      if (HOST_UART_Open(optarg)) {
+        perror(optarg);
+        return 1;
+      }
+      break;
+    default:
+      Usage(argv[0]);
+    }
+  }
+
+  if (HOST_MapPeripherals()) {
+    perror("mmap");
+    return 1;
+  }
+  if (HOST_EEPROM_Load(pEeprom)) {
+    perror(pEeprom);
+    return 1;
+  }
+
+  HOST_KEYBOARD_Init();
+  atexit(PrintStats);
+  signal(SIGINT, OnInterrupt);
+  signal(SIGTERM, OnInterrupt);
+
+  Main();
+
+  return 0;
+}
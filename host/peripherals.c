@@ -0,0 +1,36 @@
+/* Peripheral address space of the host build, shared by the simulator and
+ * the host tests.
+ *
+ * The DP32G030 peripheral registers become plain memory at their real
+ * addresses, seeded with the inputs the firmware polls during boot.
+ */
+
+#include <sys/mman.h>
+
+#include "bsp/dp32g030/gpio.h"
+#include "bsp/dp32g030/saradc.h"
+#include "driver/gpio.h"
+#include "host/host.h"
+
+#define PERIPHERAL_BASE 0x40000000UL
+#define PERIPHERAL_SIZE 0x000C0000UL
+
+#define HOST_BATTERY_ADC 2200U
+
+int HOST_MapPeripherals(void) {
+  volatile ADC_Channel_t *pChannels;
+
+  if (mmap((void *)PERIPHERAL_BASE, PERIPHERAL_SIZE, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+    return -1;
+  }
+
+  // PTT released, battery present, conversions always complete.
+  GPIOC->DATA |= 1U << GPIOC_PIN_PTT;
+  pChannels = (volatile ADC_Channel_t *)&SARADC_CH0;
+  pChannels[4].DATA = HOST_BATTERY_ADC;
+  pChannels[9].STAT = ADC_CHx_STAT_EOC_BITS_COMPLETE;
+  pChannels[9].DATA = 0;
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* SPI driver for the host build.
+ *
+ * Same register semantics as driver/spi.c, but every byte written to SPI0 is
+ * handed to the ST7565 model with the current A0 level, and releasing the
+ * bus ends a blit. With ENABLE_LCD_DMA the DMA channel 1 transfers queued by
+ * the LCD driver are run from the tick handler, which then raises the
+ * transfer-complete interrupt like the hardware does.
+ */
+
+#include "bsp/dp32g030/dma.h"
+#include "bsp/dp32g030/gpio.h"
+#include "bsp/dp32g030/spi.h"
+#include "driver/gpio.h"
+#include "driver/spi.h"
+#include "host/host.h"
+
+void SPI0_Init(void) {
+  SPI_Config_t Config = {
+      .MSTR = 1,
+      .SPR = 2,
+      .CPHA = 1,
+      .CPOL = 1,
+  };
+
+  SPI_Disable(&SPI0->CR);
+  SPI_Configure(SPI0, &Config);
+  SPI_Enable(&SPI0->CR);
+}
+
+// The model never has a byte in flight.
+void SPI_WaitForUndocumentedTxFifoStatusBit(void) {}
+
+static void SendByte(volatile SPI_Port_t *pPort, uint8_t Value) {
+  if (pPort == SPI0) {
+    HOST_LCD_Write((GPIOB->DATA >> GPIOB_PIN_ST7565_A0) & 1U, Value);
+  }
+}
+
+void SPI_WriteByte(volatile SPI_Port_t *pPort, uint8_t Value) {
+  pPort->WDR = Value;
+  SendByte(pPort, Value);
+}
+
+void SPI_Disable(volatile uint32_t *pCR) {
+  *pCR = (*pCR & ~SPI_CR_SPE_MASK) | SPI_CR_SPE_BITS_DISABLE;
+}
+
+void SPI_Configure(volatile SPI_Port_t *pPort, SPI_Config_t *pConfig) {
+  SPI_Disable(&pPort->CR);
+  pPort->CR = (pPort->CR & ~(SPI_CR_SPR_MASK | SPI_CR_CPHA_MASK |
+                             SPI_CR_CPOL_MASK | SPI_CR_MSTR_MASK |
+                             SPI_CR_LSB_MASK | SPI_CR_RF_CLR_MASK)) |
+              ((pConfig->SPR << SPI_CR_SPR_SHIFT) & SPI_CR_SPR_MASK) |
+              ((pConfig->CPHA << SPI_CR_CPHA_SHIFT) & SPI_CR_CPHA_MASK) |
+              ((pConfig->CPOL << SPI_CR_CPOL_SHIFT) & SPI_CR_CPOL_MASK) |
+              ((pConfig->MSTR << SPI_CR_MSTR_SHIFT) & SPI_CR_MSTR_MASK) |
+              ((pConfig->LSB << SPI_CR_LSB_SHIFT) & SPI_CR_LSB_MASK);
+}
+
+void SPI_ToggleMasterMode(volatile uint32_t *pCR, bool bIsMaster) {
+  if (bIsMaster) {
+    *pCR = (*pCR & ~SPI_CR_MSR_SSN_MASK) | SPI_CR_MSR_SSN_BITS_ENABLE;
+    if (pCR == &SPI0->CR) {
+      HOST_LCD_Release();
+    }
+  } else {
+    *pCR = (*pCR & ~SPI_CR_MSR_SSN_MASK) | SPI_CR_MSR_SSN_BITS_DISABLE;
+  }
+}
+
+void SPI_Enable(volatile uint32_t *pCR) {
+  *pCR = (*pCR & ~SPI_CR_SPE_MASK) | SPI_CR_SPE_BITS_ENABLE;
+}
+
+#if defined(ENABLE_LCD_DMA)
+void HandlerDMA(void);
+
+// The channel address registers are 32 bits wide, which is why the host
+// binary is linked without PIE.
+void HOST_SPI_PollDma(void) {
+  volatile DMA_Channel_t *pChannel = DMA_CH1;
+
+  while ((DMA_CTR & DMA_CTR_DMAEN_MASK) &&
+         (pChannel->CTR & DMA_CH_CTR_CH_EN_MASK) &&
+         pChannel->MDADDR == (uint32_t)(uintptr_t)&SPI0->WDR &&
+         (SPI0->CR & SPI_CR_TXDMAEN_MASK)) {
+    const uint8_t *pSource =
+        (const uint8_t *)(uintptr_t)pChannel->MSADDR;
+    const uint32_t Length =
+        ((pChannel->CTR & DMA_CH_CTR_LENGTH_MASK) >> DMA_CH_CTR_LENGTH_SHIFT) +
+        1U;
+    uint32_t i;
+
+    for (i = 0; i < Length; i++) {
+      SendByte(SPI0, pSource[i]);
+    }
+    pChannel->CTR &= ~DMA_CH_CTR_CH_EN_MASK;
+    DMA_INTST |= DMA_INTST_CH1_TC_INTST_MASK;
+    if (!(DMA_INTEN & DMA_INTEN_CH1_TC_INTEN_MASK)) {
+      break;
+    }
+    HandlerDMA();
+    // write-one-to-clear, which plain memory does not do for the handler
+    DMA_INTST &= ~DMA_INTST_CH1_TC_INTST_MASK;
+  }
+}
+#else
+void HOST_SPI_PollDma(void) {}
+#endif
@@ -0,0 +1,105 @@
+/* ST7565 model for the host build.
+ *
+ * The real driver/st7565.c runs on top of host/spi.c, which hands every byte
+ * shifted out on SPI0 to this model together with the A0 level. Commands
+ * select the page and column, data bytes land in the 132x64 display RAM and
+ * advance the column like the controller does. When the driver releases the
+ * bus after writing data, the visible 128 columns are written out as a PBM
+ * image, so the UI can be watched with any image viewer (or diffed in a
+ * regression test).
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host/host.h"
+
+#define LCD_COLUMNS 132U
+#define LCD_PAGES 8U
+#define LCD_FIRST_COLUMN 4U
+
+static uint8_t gPanel[LCD_PAGES][LCD_COLUMNS];
+static uint8_t gPage;
+static uint8_t gColumn;
+static bool gDataWritten;
+static bool gContrastNext;
+static const char *gOutput;
+
+HOST_LCD_Stats_t gHostLcdStats;
+
+void HOST_LCD_SetOutput(const char *pPath) { gOutput = pPath; }
+
+const uint8_t *HOST_LCD_GetPage(uint8_t Page) {
+  return &gPanel[Page][LCD_FIRST_COLUMN];
+}
+
+static void Dump(void) {
+  char Temp[256];
+  FILE *f;
+  uint8_t x, y;
+
+  if (gOutput == NULL) {
+    return;
+  }
+
+  snprintf(Temp, sizeof(Temp), "%s.tmp", gOutput);
+  f = fopen(Temp, "wb");
+  if (f == NULL) {
+    return;
+  }
+  fprintf(f, "P4\n128 64\n");
+  for (y = 0; y < 64; y++) {
+    for (x = 0; x < 128; x += 8) {
+      const uint8_t *pLine = HOST_LCD_GetPage(y >> 3);
+      uint8_t Byte = 0;
+      uint8_t i;
+
+      for (i = 0; i < 8; i++) {
+        Byte = (Byte << 1) | ((pLine[x + i] >> (y & 7)) & 1U);
+      }
+      fputc(Byte, f);
+    }
+  }
+  fclose(f);
+  rename(Temp, gOutput);
+}
+
+void HOST_LCD_Write(bool A0, uint8_t Value) {
+  gHostLcdStats.BytesSent++;
+
+  if (A0) {
+    gPanel[gPage][gColumn] = Value;
+    // the column address stops at the last column
+    if (gColumn < LCD_COLUMNS - 1U) {
+      gColumn++;
+    }
+    gDataWritten = true;
+    return;
+  }
+
+  // Everything else (bias, power control, contrast, ...) only matters to
+  // the glass. The contrast command takes its value in the next byte.
+  if (gContrastNext) {
+    gContrastNext = false;
+  } else if (Value == 0x81) {
+    gContrastNext = true;
+  } else if ((Value & 0xF0) == 0xB0) {
+    gPage = Value & 0x07;
+  } else if ((Value & 0xF0) == 0x10) {
+    gColumn = ((Value & 0x0F) << 4) | (gColumn & 0x0F);
+  } else if ((Value & 0xF0) == 0x00) {
+    gColumn = (gColumn & 0xF0) | Value;
+  }
+  if (gColumn >= LCD_COLUMNS) {
+    gColumn = LCD_COLUMNS - 1U;
+  }
+}
+
+void HOST_LCD_Release(void) {
+  if (!gDataWritten) {
+    return;
+  }
+  gDataWritten = false;
+  gHostLcdStats.Blits++;
+  Dump();
+}
@@ -0,0 +1,151 @@
+/* SysTick driver for the host build.
+ *
+ * The 10ms tick is a SIGALRM interval timer calling SystickHandler() on the
+ * main thread, so it preempts the firmware just like the interrupt does.
+ * __disable_irq()/__enable_irq() block and unblock that signal.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "ARMCM0.h"
+#include "driver/systick.h"
+#include "host/host.h"
+#include "misc.h"
+
+void SystickHandler(void);
+
+SysTick_Type HOST_SysTick;
+
+static volatile uint64_t gSleepUs;
+// Mirrors the SIGALRM bit of the signal mask, so that the GPIO and BK4819
+// critical sections do not cost a system call each.
+static volatile bool gIrqMasked;
+static uint32_t gIdleWindowStart;
+
+uint64_t HOST_GetTimeUs(void) {
+  static uint64_t Start;
+  struct timespec ts;
+  uint64_t Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  Now = (uint64_t)ts.tv_sec * 1000000U + ts.tv_nsec / 1000U;
+  if (Start == 0) {
+    Start = Now;
+  }
+
+  return Now - Start;
+}
+
+static void OnTick(int Signal) {
+  const bool bMasked = gIrqMasked;
+
+  (void)Signal;
+  // the kernel blocks SIGALRM while its handler runs
+  gIrqMasked = true;
+  HOST_UART_Poll();
+  HOST_SPI_PollDma();
+  SystickHandler();
+  gIrqMasked = bMasked;
+}
+
+void SYSTICK_Init(void) {
+  struct sigaction Action = {0};
+  struct itimerval Timer = {
+      .it_interval = {.tv_usec = 10000},
+      .it_value = {.tv_usec = 10000},
+  };
+
+  Action.sa_handler = OnTick;
+  Action.sa_flags = SA_RESTART;
+  sigemptyset(&Action.sa_mask);
+  sigaction(SIGALRM, &Action, NULL);
+  setitimer(ITIMER_REAL, &Timer, NULL);
+}
+
+void SYSTICK_SetPeriodUs(uint32_t Period) {
+  struct itimerval Timer = {
+      .it_interval = {.tv_usec = Period},
+      .it_value = {.tv_usec = Period},
+  };
+
+  setitimer(ITIMER_REAL, &Timer, NULL);
+}
+
+// Like LOAD - VAL on the chip, so a signal held off by __disable_irq()
+// shows up as a late phase.
+uint32_t SYSTICK_GetPhaseUs(void) {
+  struct itimerval Timer;
+
+  getitimer(ITIMER_REAL, &Timer);
+
+  return Timer.it_interval.tv_usec - Timer.it_value.tv_usec;
+}
+
+void SYSTICK_DelayUs(uint32_t Delay) {
+  const uint64_t End = HOST_GetTimeUs() + Delay;
+
+  while (HOST_GetTimeUs() < End) {
+  }
+}
+
+static void SetIrqMask(int How) {
+  sigset_t Set;
+
+  sigemptyset(&Set);
+  sigaddset(&Set, SIGALRM);
+  sigprocmask(How, &Set, NULL);
+}
+
+void HOST_DisableIrq(void) {
+  if (!gIrqMasked) {
+    SetIrqMask(SIG_BLOCK);
+    gIrqMasked = true;
+  }
+}
+
+void HOST_EnableIrq(void) {
+  if (gIrqMasked) {
+    gIrqMasked = false;
+    SetIrqMask(SIG_UNBLOCK);
+  }
+}
+
+uint32_t HOST_GetIrqMask(void) { return gIrqMasked; }
+
+void HOST_WaitForInterrupt(void) {
+  sigset_t Set;
+
+  // Sleep until the next tick; its handler runs before this returns.
+  sigprocmask(SIG_BLOCK, NULL, &Set);
+  sigdelset(&Set, SIGALRM);
+  sigsuspend(&Set);
+}
+
+void SYSTICK_Sleep(void) {
+  const uint64_t Before = HOST_GetTimeUs();
+
+  HOST_WaitForInterrupt();
+  gSleepUs += HOST_GetTimeUs() - Before;
+}
+
+uint8_t SYSTICK_GetIdlePercent(void) {
+  const uint32_t Ticks = gGlobalSysTickCounter - gIdleWindowStart;
+  uint64_t Us;
+
+  HOST_DisableIrq();
+  Us = gSleepUs;
+  gSleepUs = 0;
+  HOST_EnableIrq();
+  gIdleWindowStart += Ticks;
+
+  return Ticks ? Us / (Ticks * 100U) : 0;
+}
+
+void HOST_Reset(void) {
+  fprintf(stderr, "uvk5-host: NVIC_SystemReset\n");
+  exit(0);
+}
@@ -0,0 +1,351 @@
+/* Background sounds against the BK4819 model: the roger tone steps through
+ * its two tones on the 10ms ticks the blocking version waited, queued sounds
+ * follow each other and call back when done, and AUDIO_Stop() silences the
+ * chip without running any callback, as keying up again relies on. A sound
+ * played in power save wakes the chip and puts it back to sleep only if the
+ * radio is still in power save when the sound ends.
+ *
+ * DTMF replies are compared with a copy of the blocking DTMF_Reply() that
+ * keeps time on a counter instead of sleeping: each register change must
+ * land on the same 10ms.
+ */
+
+#include <string.h>
+
+#include "app/dtmf.h"
+#include "audio.h"
+#include "board.h"
+#include "driver/bk4819.h"
+#include "functions.h"
+#include "host/host.h"
+#include "host/test/test.h"
+#include "misc.h"
+#include "settings.h"
+
+void SystickHandler(void);
+
+static uint32_t gDoneAt[2];
+static uint8_t gDoneCount[2];
+
+static void Done0(void) {
+  gDoneAt[0] = gGlobalSysTickCounter;
+  gDoneCount[0]++;
+}
+
+// chains a second sound, as the roger tone does with the EOT ID
+static void Done1(void) {
+  gDoneAt[1] = gGlobalSysTickCounter;
+  gDoneCount[1]++;
+  AUDIO_PlayRoger(ROGER_MODE_ROGER, Done0);
+}
+
+static void Reset(void) {
+  gDoneCount[0] = 0;
+  gDoneCount[1] = 0;
+}
+
+// One main loop pass per tick, as APP_TimeSlice10ms runs AUDIO_Update()
+static void Tick(void) {
+  SystickHandler();
+  AUDIO_Update();
+}
+
+// The blocking roger: tone 1 on, 50ms, 0x142A for 80ms, 0x1C3B for 80ms, off
+static void CheckRogerTiming(void) {
+  static const struct {
+    uint8_t Tick;
+    uint16_t Reg70;
+    uint16_t Reg71;
+  } Steps[] = {{0, 0xE000, 0}, {5, 0xE000, 0x142A}, {13, 0xE000, 0x1C3B},
+               {21, 0x0000, 0x1C3B}};
+  uint32_t Start;
+  uint8_t Step = 0, t;
+
+  Reset();
+  BK4819_WriteRegister(BK4819_REG_71, 0);
+  AUDIO_PlayRoger(ROGER_MODE_ROGER, Done0);
+  CHECK(AUDIO_IsPlaying());
+  CHECK_EQ(gDoneCount[0], 0);
+
+  Start = gGlobalSysTickCounter;
+  AUDIO_Update();
+  for (t = 0; t <= 30; t++) {
+    if (Step < ARRAY_SIZE(Steps) && Steps[Step].Tick == t) {
+      CHECK_EQ(BK4819_ReadRegister(BK4819_REG_70), Steps[Step].Reg70);
+      CHECK_EQ(BK4819_ReadRegister(BK4819_REG_71), Steps[Step].Reg71);
+      Step++;
+    } else if (Step && Step < ARRAY_SIZE(Steps)) {
+      // nothing changes between steps
+      CHECK_EQ(BK4819_ReadRegister(BK4819_REG_71), Steps[Step - 1].Reg71);
+    }
+    Tick();
+  }
+  CHECK_EQ(Step, ARRAY_SIZE(Steps));
+  CHECK_EQ(gDoneCount[0], 1);
+  CHECK_EQ(gDoneAt[0] - Start, 21);
+  CHECK(!AUDIO_IsPlaying());
+}
+
+// A sound queued from a callback starts on the next pass
+static void CheckChain(void) {
+  uint32_t Start;
+  uint8_t t;
+
+  Reset();
+  AUDIO_PlayRoger(ROGER_MODE_ROGER, Done1);
+  Start = gGlobalSysTickCounter;
+  AUDIO_Update();
+  for (t = 0; t < 60; t++) {
+    Tick();
+  }
+  CHECK_EQ(gDoneCount[1], 1);
+  CHECK_EQ(gDoneAt[1] - Start, 21);
+  CHECK_EQ(gDoneCount[0], 1);
+  CHECK_EQ(gDoneAt[0] - gDoneAt[1], 22);
+  CHECK(!AUDIO_IsPlaying());
+}
+
+// Keying up during the roger: the tone stops, neither the roger's callback
+// nor the sound it would have chained runs, and nothing plays afterwards.
+static void CheckStop(void) {
+  uint8_t t;
+
+  Reset();
+  AUDIO_PlayRoger(ROGER_MODE_ROGER, Done1);
+  AUDIO_PlayBeep(BEEP_500HZ_60MS_DOUBLE_BEEP);
+  AUDIO_Update();
+  for (t = 0; t < 7; t++) {
+    Tick();
+  }
+  CHECK_EQ(BK4819_ReadRegister(BK4819_REG_71), 0x142A);
+
+  AUDIO_Stop();
+  CHECK(!AUDIO_IsPlaying());
+  CHECK_EQ(BK4819_ReadRegister(BK4819_REG_70), 0);
+  CHECK_EQ(gDoneCount[1], 0);
+
+  for (t = 0; t < 60; t++) {
+    Tick();
+  }
+  CHECK_EQ(gDoneCount[0], 0);
+  CHECK_EQ(gDoneCount[1], 0);
+  CHECK_EQ(BK4819_ReadRegister(BK4819_REG_70), 0);
+}
+
+// A full queue refuses the sound straight away, and says so through pDone
+static void CheckQueueFull(void) {
+  uint8_t i;
+
+  Reset();
+  for (i = 0; i < 5; i++) {
+    AUDIO_PlayRoger(ROGER_MODE_ROGER, Done0);
+  }
+  CHECK_EQ(gDoneCount[0], 1);
+  while (AUDIO_IsPlaying()) {
+    Tick();
+  }
+  CHECK_EQ(gDoneCount[0], 5);
+}
+
+// Plays a beep from power save, leaving it for Function after a few ticks
+static void CheckPowerSave(FUNCTION_Type_t Function, bool bAsleep) {
+  uint8_t t;
+
+  gCurrentFunction = FUNCTION_POWER_SAVE;
+  gRxIdleMode = true;
+  BK4819_Sleep();
+  AUDIO_PlayBeep(BEEP_1KHZ_60MS_OPTIONAL);
+  AUDIO_Update();
+  CHECK(BK4819_ReadRegister(BK4819_REG_37) != 0x1D00);
+  for (t = 0; t < 3; t++) {
+    Tick();
+  }
+  gCurrentFunction = Function;
+  gRxIdleMode = Function == FUNCTION_POWER_SAVE;
+  while (AUDIO_IsPlaying()) {
+    Tick();
+  }
+  CHECK_EQ(BK4819_ReadRegister(BK4819_REG_37) == 0x1D00, bAsleep);
+  gCurrentFunction = FUNCTION_FOREGROUND;
+  gRxIdleMode = false;
+}
+
+#define MAX_CHANGES 64U
+
+typedef struct {
+  uint16_t At;
+  uint16_t Reg50;
+  uint16_t Reg70;
+  uint16_t Reg71;
+  uint16_t Reg72;
+} Change_t;
+
+typedef struct {
+  Change_t List[MAX_CHANGES];
+  uint8_t Count;
+} Timeline_t;
+
+// Adds the chip's state at At ms, unless it is the same as the last one
+static void Record(Timeline_t *pTimeline, uint16_t At) {
+  const Change_t Change = {
+      .At = At,
+      .Reg50 = BK4819_ReadRegister(BK4819_REG_50),
+      .Reg70 = BK4819_ReadRegister(BK4819_REG_70),
+      .Reg71 = BK4819_ReadRegister(BK4819_REG_71),
+      .Reg72 = BK4819_ReadRegister(BK4819_REG_72),
+  };
+
+  if (pTimeline->Count) {
+    const Change_t *pLast = &pTimeline->List[pTimeline->Count - 1];
+
+    if (pLast->Reg50 == Change.Reg50 && pLast->Reg70 == Change.Reg70 &&
+        pLast->Reg71 == Change.Reg71 && pLast->Reg72 == Change.Reg72) {
+      return;
+    }
+  }
+  if (pTimeline->Count < MAX_CHANGES) {
+    pTimeline->List[pTimeline->Count++] = Change;
+  }
+}
+
+// The blocking reply, with SYSTEM_DelayMs() advancing *pClock
+static void LegacyDelay(Timeline_t *pTimeline, uint16_t *pClock,
+                        uint16_t Delay) {
+  Record(pTimeline, *pClock);
+  *pClock += Delay;
+}
+
+static void LegacyReply(Timeline_t *pTimeline, uint16_t *pClock,
+                        const char *pString, uint16_t Preload) {
+  uint16_t Delay;
+  uint8_t i;
+
+  LegacyDelay(pTimeline, pClock, Preload);
+  BK4819_EnterDTMF_TX(gEeprom.DTMF_SIDE_TONE);
+  for (i = 0; pString[i]; i++) {
+    BK4819_PlayDTMF(pString[i]);
+    BK4819_ExitTxMute();
+    if (i == 0) {
+      Delay = gEeprom.DTMF_FIRST_CODE_PERSIST_TIME;
+    } else if (pString[i] == '*' || pString[i] == '#') {
+      Delay = gEeprom.DTMF_HASH_CODE_PERSIST_TIME;
+    } else {
+      Delay = gEeprom.DTMF_CODE_PERSIST_TIME;
+    }
+    LegacyDelay(pTimeline, pClock, Delay);
+    BK4819_EnterTxMute();
+    LegacyDelay(pTimeline, pClock, gEeprom.DTMF_CODE_INTERVAL_TIME);
+  }
+  BK4819_ExitDTMF_TX(false);
+  Record(pTimeline, *pClock);
+}
+
+static uint16_t gRepliesAt[2];
+static uint8_t gReplies;
+
+static void ReplySent(void) {
+  if (gReplies < ARRAY_SIZE(gRepliesAt)) {
+    gRepliesAt[gReplies] = gGlobalSysTickCounter;
+  }
+  gReplies++;
+}
+
+// The same chip state before either version plays
+static void Idle(void) {
+  BK4819_ExitDTMF_TX(false);
+  BK4819_WriteRegister(BK4819_REG_71, 0);
+  BK4819_WriteRegister(BK4819_REG_72, 0);
+}
+
+static void CheckSame(const Timeline_t *pLegacy, const Timeline_t *pNow) {
+  uint8_t i;
+
+  CHECK_EQ(pNow->Count, pLegacy->Count);
+  for (i = 0; i < pLegacy->Count && i < pNow->Count; i++) {
+    CHECK_EQ(pNow->List[i].At, pLegacy->List[i].At);
+    CHECK(memcmp(&pNow->List[i], &pLegacy->List[i], sizeof(Change_t)) == 0);
+  }
+}
+
+// Two replies queued back to back, both built in DTMF_Reply()'s buffer: the
+// first must still send its own string once the second has been queued.
+static void CheckDTMFReply(void) {
+  static Timeline_t Legacy[2], Now[2];
+  uint16_t Clock;
+  uint32_t Start;
+  uint16_t Ticks;
+  uint8_t Reply = 0;
+
+  gEeprom.DTMF_SIDE_TONE = true;
+  gEeprom.DTMF_PRELOAD_TIME = 30; // raised to 60 with the side tone
+  gEeprom.DTMF_FIRST_CODE_PERSIST_TIME = 200;
+  gEeprom.DTMF_HASH_CODE_PERSIST_TIME = 150;
+  gEeprom.DTMF_CODE_PERSIST_TIME = 70;
+  gEeprom.DTMF_CODE_INTERVAL_TIME = 50;
+  gEeprom.DTMF_SEPARATE_CODE = '*';
+  strcpy(gEeprom.ANI_DTMF_ID, "456");
+  strcpy(gDTMF_String, "1239");
+  gDTMF_CallMode = DTMF_CALL_MODE_NOT_GROUP;
+
+  Idle();
+  Clock = 0;
+  LegacyReply(&Legacy[0], &Clock, "1239*456", 60);
+  Clock = 0;
+  LegacyReply(&Legacy[1], &Clock, "456*AAAAA", 60);
+
+  Idle();
+  gReplies = 0;
+  gDTMF_ReplyState = DTMF_REPLY_ANI;
+  DTMF_Reply(ReplySent);
+  gDTMF_ReplyState = DTMF_REPLY_AAAAA;
+  DTMF_Reply(ReplySent);
+  CHECK_EQ(gReplies, 0);
+
+  Start = gGlobalSysTickCounter;
+  AUDIO_Update();
+  Record(&Now[0], 0);
+  for (Ticks = 0; AUDIO_IsPlaying() && Ticks < 1000; Ticks++) {
+    Tick();
+    Record(&Now[Reply], (gGlobalSysTickCounter - Start) * 10);
+    if (Reply == 0 && gReplies) {
+      // the second starts on the pass after the first is done
+      Reply = 1;
+      Start = gGlobalSysTickCounter + 1;
+    }
+  }
+  CHECK_EQ(gReplies, 2);
+  CheckSame(&Legacy[0], &Now[0]);
+  CheckSame(&Legacy[1], &Now[1]);
+  CHECK_EQ(gRepliesAt[1] - gRepliesAt[0], Clock / 10 + 1);
+}
+
+// Nothing to send still lets the caller carry on
+static void CheckNoReply(void) {
+  gReplies = 0;
+  gDTMF_ReplyState = DTMF_REPLY_NONE;
+  gDTMF_CallState = DTMF_CALL_STATE_CALL_OUT;
+  DTMF_Reply(ReplySent);
+  CHECK_EQ(gReplies, 1);
+  CHECK(!AUDIO_IsPlaying());
+  gDTMF_CallState = DTMF_CALL_STATE_NONE;
+}
+
+int main(void) {
+  if (HOST_MapPeripherals()) {
+    return 1;
+  }
+  BOARD_GPIO_Init();
+  BK4819_Init();
+  gEeprom.BEEP_CONTROL = true;
+
+  CheckRogerTiming();
+  CheckChain();
+  CheckStop();
+  CheckQueueFull();
+  CheckPowerSave(FUNCTION_POWER_SAVE, true);
+  CheckPowerSave(FUNCTION_FOREGROUND, false);
+  CheckDTMFReply();
+  CheckNoReply();
+
+  return TEST_Finish("audio");
+}
@@ -0,0 +1,256 @@
+/* BK4819 register access benchmark.
+ *
+ * Times register reads, writes and batched transfers through the real driver
+ * and the bus model, against a copy of the original driver that waited 1us
+ * around every clock edge. Both run on the same host GPIO and model, so the
+ * difference is the bus timing the driver spends, which is what dominated
+ * a register access on the radio. A batched transfer must beat the same
+ * accesses made one call at a time.
+ *
+ * A read of a shadowed register is counted as a shadow hit in every build,
+ * and stays off the bus unless the shadow check is built in.
+ */
+
+#include <stdio.h>
+
+#include "board.h"
+#include "bsp/dp32g030/gpio.h"
+#include "bsp/dp32g030/portcon.h"
+#include "driver/bk4819.h"
+#include "driver/gpio.h"
+#include "driver/systick.h"
+#include "host/host.h"
+#include "host/test/test.h"
+#include "misc.h"
+
+#define OPS 2000U
+
+// Register 0x01 is not shadowed, so every read goes to the bus.
+#define TEST_REG ((BK4819_REGISTER_t)0x01)
+
+static void LegacyWriteU8(uint8_t Data) {
+  uint8_t i;
+
+  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  for (i = 0; i < 8; i++) {
+    if ((Data & 0x80U) == 0) {
+      GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+    } else {
+      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+    }
+    SYSTICK_DelayUs(1);
+    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    SYSTICK_DelayUs(1);
+    Data <<= 1;
+    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    SYSTICK_DelayUs(1);
+  }
+}
+
+static void LegacyWriteU16(uint16_t Data) {
+  uint8_t i;
+
+  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  for (i = 0; i < 16; i++) {
+    if ((Data & 0x8000U) == 0U) {
+      GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+    } else {
+      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+    }
+    SYSTICK_DelayUs(1);
+    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    Data <<= 1;
+    SYSTICK_DelayUs(1);
+    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    SYSTICK_DelayUs(1);
+  }
+}
+
+static uint16_t LegacyReadU16(void) {
+  uint16_t Value = 0;
+  uint8_t i;
+
+  PORTCON_PORTC_IE = (PORTCON_PORTC_IE & ~PORTCON_PORTC_IE_C2_MASK) |
+                     PORTCON_PORTC_IE_C2_BITS_ENABLE;
+  GPIOC->DIR = (GPIOC->DIR & ~GPIO_DIR_2_MASK) | GPIO_DIR_2_BITS_INPUT;
+  SYSTICK_DelayUs(1);
+
+  for (i = 0; i < 16; i++) {
+    Value <<= 1;
+    Value |= GPIO_CheckBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+    GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    SYSTICK_DelayUs(1);
+    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+    SYSTICK_DelayUs(1);
+  }
+  PORTCON_PORTC_IE = (PORTCON_PORTC_IE & ~PORTCON_PORTC_IE_C2_MASK) |
+                     PORTCON_PORTC_IE_C2_BITS_DISABLE;
+  GPIOC->DIR = (GPIOC->DIR & ~GPIO_DIR_2_MASK) | GPIO_DIR_2_BITS_OUTPUT;
+
+  return Value;
+}
+
+static uint16_t LegacyReadRegister(uint8_t Register) {
+  uint16_t Value;
+
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  SYSTICK_DelayUs(1);
+  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  LegacyWriteU8(Register | 0x80);
+  Value = LegacyReadU16();
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  SYSTICK_DelayUs(1);
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+
+  return Value;
+}
+
+static void LegacyWriteRegister(uint8_t Register, uint16_t Data) {
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  SYSTICK_DelayUs(1);
+  GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  LegacyWriteU8(Register);
+  SYSTICK_DelayUs(1);
+  LegacyWriteU16(Data);
+  SYSTICK_DelayUs(1);
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCN);
+  SYSTICK_DelayUs(1);
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SCL);
+  GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_BK4819_SDA);
+}
+
+static void CheckShadowHits(void) {
+  const uint32_t Hits = gBK4819_ShadowHits;
+  uint32_t Reads;
+
+  BK4819_WriteRegister(BK4819_REG_30, 0x1234);
+  Reads = gHostBK4819Stats.Reads;
+  CHECK_EQ(BK4819_ReadRegister(BK4819_REG_30), 0x1234);
+  CHECK_EQ(gBK4819_ShadowHits - Hits, 1);
+#if defined(ENABLE_BK4819_SHADOW_CHECK)
+  // the check build reads the chip too, to compare
+  CHECK_EQ(gHostBK4819Stats.Reads - Reads, 1);
+#else
+  CHECK_EQ(gHostBK4819Stats.Reads - Reads, 0);
+#endif
+}
+
+// Shadowed reads inside a transfer skip the bus without breaking the
+// accesses around them
+static void CheckMixedTransfer(void) {
+  BK4819_Transaction_t Batch[] = {
+      {BK4819_REG_30, 0x4321},
+      {TEST_REG, 0x1111},
+      {BK4819_REG_30 | BK4819_TRANSFER_READ},
+      {TEST_REG | BK4819_TRANSFER_READ},
+      {TEST_REG, 0x2222},
+  };
+  const uint32_t Reads = gHostBK4819Stats.Reads;
+  const uint32_t Writes = gHostBK4819Stats.Writes;
+
+  BK4819_Transfer(Batch, ARRAY_SIZE(Batch));
+  CHECK_EQ(Batch[2].Value, 0x4321);
+  CHECK_EQ(Batch[3].Value, 0x1111);
+#if defined(ENABLE_BK4819_SHADOW_CHECK)
+  CHECK_EQ(gHostBK4819Stats.Reads - Reads, 2);
+#else
+  CHECK_EQ(gHostBK4819Stats.Reads - Reads, 1);
+#endif
+  CHECK_EQ(gHostBK4819Stats.Writes - Writes, 3);
+  CHECK_EQ(LegacyReadRegister(TEST_REG), 0x2222);
+  CHECK_EQ(LegacyReadRegister(BK4819_REG_30), 0x4321);
+}
+
+static uint32_t OpsPerSecond(uint64_t Start) {
+  const uint64_t Us = HOST_GetTimeUs() - Start;
+
+  return Us ? OPS * 1000000ULL / Us : 0;
+}
+
+int main(void) {
+  BK4819_Transaction_t Batch[8];
+  uint32_t LegacyReads, LegacyWrites, Reads, Writes, Pairs, Transfers, Ops;
+  uint64_t Start;
+  uint16_t Value = 0;
+  uint32_t i;
+  uint8_t j, Run;
+
+  if (HOST_MapPeripherals()) {
+    return 1;
+  }
+  BOARD_GPIO_Init();
+  BK4819_Init();
+
+  Start = HOST_GetTimeUs();
+  for (i = 0; i < OPS; i++) {
+    LegacyWriteRegister(TEST_REG, i);
+  }
+  LegacyWrites = OpsPerSecond(Start);
+  Start = HOST_GetTimeUs();
+  for (i = 0; i < OPS; i++) {
+    Value = LegacyReadRegister(TEST_REG);
+  }
+  LegacyReads = OpsPerSecond(Start);
+  CHECK_EQ(Value, OPS - 1);
+
+  Start = HOST_GetTimeUs();
+  for (i = 0; i < OPS; i++) {
+    BK4819_WriteRegister(TEST_REG, i ^ 0x5A5A);
+  }
+  Writes = OpsPerSecond(Start);
+  Start = HOST_GetTimeUs();
+  for (i = 0; i < OPS; i++) {
+    Value = BK4819_ReadRegister(TEST_REG);
+  }
+  Reads = OpsPerSecond(Start);
+  CHECK_EQ(Value, (OPS - 1) ^ 0x5A5A);
+  CHECK_EQ(LegacyReadRegister(TEST_REG), Value);
+
+  // alternating write/read pairs, as BK4819_TuneTo issues them, in batches
+  // and one call at a time; best of a few runs, the gap is small next to
+  // host scheduling noise
+  Pairs = 0;
+  Transfers = 0;
+  for (Run = 0; Run < 5; Run++) {
+    Start = HOST_GetTimeUs();
+    for (i = 0; i < OPS; i += 8) {
+      for (j = 0; j < 8; j += 2) {
+        Batch[j].Register = TEST_REG;
+        Batch[j].Value = i + j;
+        Batch[j + 1].Register = TEST_REG | BK4819_TRANSFER_READ;
+      }
+      BK4819_Transfer(Batch, 8);
+      for (j = 0; j < 8; j += 2) {
+        CHECK_EQ(Batch[j + 1].Value, i + j);
+      }
+    }
+    Ops = OpsPerSecond(Start);
+    Transfers = Ops > Transfers ? Ops : Transfers;
+
+    Start = HOST_GetTimeUs();
+    for (i = 0; i < OPS; i += 2) {
+      BK4819_WriteRegister(TEST_REG, i);
+      Value = BK4819_ReadRegister(TEST_REG);
+    }
+    Ops = OpsPerSecond(Start);
+    Pairs = Ops > Pairs ? Ops : Pairs;
+    CHECK_EQ(Value, OPS - 2);
+  }
+
+  CheckMixedTransfer();
+
+  CheckShadowHits();
+
+  CHECK(Reads > LegacyReads);
+  CHECK(Writes > LegacyWrites);
+  CHECK(Transfers > Pairs);
+  fprintf(stderr,
+          "bk4819: ops/s  legacy read %u write %u, now read %u write %u, "
+          "write/read pairs single %u transfer %u\n",
+          LegacyReads, LegacyWrites, Reads, Writes, Pairs, Transfers);
+
+  return TEST_Finish("bk4819");
+}
@@ -0,0 +1,266 @@
+/* MR channel index and name cache against the EEPROM model: hit rate of the
+ * scanlist view scrolling through 200 named channels, and the time
+ * RADIO_ConfigureChannel takes per memory scan step with them and without.
+ * Channels with tones or an offset are read from the EEPROM every time. Memory scan hops
+ * over the 200 channels are timed with register images and without.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "driver/bk4819.h"
+#include "driver/eeprom.h"
+#include "frequencies.h"
+#include "functions.h"
+#include "host/host.h"
+#include "host/test/test.h"
+#include "misc.h"
+#include "radio.h"
+#include "settings.h"
+
+#define IMAGE_SIZE 0x2000U
+#define SCAN_STEPS 400U
+#define SCANLIST_ROWS 7U
+
+static uint32_t ChannelFrequency(uint8_t Channel) {
+  return 14500000U + Channel * 1250U;
+}
+
+static int WriteImage(int File) {
+  static uint8_t Image[IMAGE_SIZE];
+  uint16_t Channel;
+
+  memset(Image, 0xFF, sizeof(Image));
+  for (Channel = MR_CHANNEL_FIRST; Channel <= MR_CHANNEL_LAST; Channel++) {
+    const uint32_t Frequency = ChannelFrequency(Channel);
+
+    memcpy(&Image[Channel * 16], &Frequency, sizeof(Frequency));
+    memset(&Image[Channel * 16 + 4], 0, 12);
+    Image[0x0D60 + Channel] = MR_CH_SCANLIST1 | BAND3_136MHz;
+    sprintf((char *)&Image[0x0F50 + Channel * 16], "CH %u", Channel);
+  }
+
+  return write(File, Image, sizeof(Image)) != sizeof(Image);
+}
+
+// The view redraws its 7 rows, the cursor two rows down, on every key press
+static void CheckScanlistScroll(void) {
+  const uint16_t Hits = gChannelCacheHits;
+  const uint16_t Misses = gChannelCacheMisses;
+  const uint32_t Bytes = gHostEepromStats.BytesRead;
+  char Name[16], Expected[16];
+  uint8_t Cursor, Row, First;
+
+  SETTINGS_InvalidateChannelCache();
+  for (Cursor = 0; Cursor <= MR_CHANNEL_LAST; Cursor++) {
+    First = Cursor < 2 ? 0 : Cursor - 2;
+    if (First > MR_CHANNEL_LAST + 1 - SCANLIST_ROWS) {
+      First = MR_CHANNEL_LAST + 1 - SCANLIST_ROWS;
+    }
+    for (Row = 0; Row < SCANLIST_ROWS; Row++) {
+      GetChannelName(First + Row, Name);
+      sprintf(Expected, "CH %u", First + Row);
+      CHECK(strcmp(Name, Expected) == 0);
+    }
+  }
+
+  // every channel is read once, the rest of a redraw comes from RAM
+  CHECK_EQ(gChannelCacheMisses - Misses, MR_CHANNEL_LAST + 1);
+  CHECK_EQ(gHostEepromStats.BytesRead - Bytes, (MR_CHANNEL_LAST + 1) * 10);
+  fprintf(stderr, "channels: scanlist scroll %u hits %u misses, %u%% hits\n",
+          gChannelCacheHits - Hits, gChannelCacheMisses - Misses,
+          (gChannelCacheHits - Hits) * 100U /
+              (gChannelCacheHits - Hits + gChannelCacheMisses - Misses));
+}
+
+// Configures SCAN_STEPS channels round a list of Count and returns the
+// average microseconds per step
+static uint32_t ScanSteps(uint8_t Count, bool bCached) {
+  const uint16_t Hits = gChannelCacheHits;
+  const uint16_t Misses = gChannelCacheMisses;
+  const uint64_t Start = HOST_GetTimeUs();
+  uint32_t Us;
+  uint16_t Step;
+  uint8_t Channel;
+
+  SETTINGS_InvalidateChannelCache();
+  for (Step = 0; Step < SCAN_STEPS; Step++) {
+    Channel = Step % Count;
+    if (!bCached) {
+      SETTINGS_InvalidateChannelCache();
+    }
+    gEeprom.ScreenChannel[0] = Channel;
+    RADIO_ConfigureChannel(0, 2);
+    CHECK_EQ(gEeprom.VfoInfo[0].CHANNEL_SAVE, Channel);
+    CHECK_EQ(gEeprom.VfoInfo[0].pRX->Frequency, ChannelFrequency(Channel));
+  }
+  Us = (HOST_GetTimeUs() - Start) / SCAN_STEPS;
+
+  fprintf(stderr,
+          "channels: %3u channel list %s, %u us/step, %u hits %u misses\n",
+          Count, bCached ? "cached  " : "uncached", Us,
+          gChannelCacheHits - Hits, gChannelCacheMisses - Misses);
+
+  return Us;
+}
+
+static void CheckScanSteps(void) {
+  const uint32_t Uncached = ScanSteps(10, false);
+  uint32_t Bytes = gHostEepromStats.BytesRead;
+  uint16_t Misses = gChannelCacheMisses;
+  const uint32_t Cached = ScanSteps(10, true);
+
+  // a step reads the record twice and the name once, only the first visit
+  // of each channel goes to the EEPROM
+  CHECK_EQ(gChannelCacheMisses - Misses, 2 * 10);
+  CHECK_EQ(gHostEepromStats.BytesRead - Bytes, 10 * (16 + 10));
+  CHECK(Cached < Uncached);
+
+  // the index holds every record, only names overflow their cache
+  Bytes = gHostEepromStats.BytesRead;
+  Misses = gChannelCacheMisses;
+  ScanSteps(MR_CHANNEL_LAST + 1, true);
+  CHECK_EQ(gChannelCacheMisses - Misses, MR_CHANNEL_LAST + 1 + SCAN_STEPS);
+  CHECK_EQ(gHostEepromStats.BytesRead - Bytes,
+           (MR_CHANNEL_LAST + 1) * 16 + SCAN_STEPS * 10);
+}
+
+// A channel with tones and an offset does not fit the index: it is read
+// from the EEPROM every time, and reads back the same
+static void CheckNotPlain(void) {
+  const uint8_t Channel = 5;
+  const uint32_t Offset = 60000;
+  uint8_t Record[16];
+  uint32_t Bytes;
+  uint8_t i;
+
+  EEPROM_ReadBuffer(Channel * 16, Record, sizeof(Record));
+  memcpy(&Record[4], &Offset, sizeof(Offset));
+  Record[8] = 8;
+  Record[9] = 8;
+  Record[10] = (CODE_TYPE_CONTINUOUS_TONE << 4) | CODE_TYPE_CONTINUOUS_TONE;
+  EEPROM_WriteBuffer(Channel * 16, &Record[0]);
+  EEPROM_WriteBuffer(Channel * 16 + 8, &Record[8]);
+  SETTINGS_InvalidateChannelCache();
+
+  for (i = 0; i < 3; i++) {
+    Bytes = gHostEepromStats.BytesRead;
+    gEeprom.ScreenChannel[0] = Channel;
+    RADIO_ConfigureChannel(0, 2);
+    CHECK_EQ(gEeprom.VfoInfo[0].ConfigRX.Frequency, ChannelFrequency(Channel));
+    CHECK_EQ(gEeprom.VfoInfo[0].FREQUENCY_OF_DEVIATION, Offset);
+    CHECK_EQ(gEeprom.VfoInfo[0].ConfigRX.CodeType, CODE_TYPE_CONTINUOUS_TONE);
+    CHECK_EQ(gEeprom.VfoInfo[0].ConfigRX.Code, 8);
+    // the whole record to index it, then each half as it is asked for; the
+    // name stays cached
+    CHECK_EQ(gHostEepromStats.BytesRead - Bytes, i ? 8 + 8 : 16 + 8 + 10);
+  }
+}
+
+static void CheckInvalidate(void) {
+  const char Name[8] = "RENAMED";
+  uint32_t Frequency = ChannelFrequency(3) + 2500;
+  uint8_t Record[8];
+  char Read[16];
+
+  GetChannelName(3, Read);
+  gEeprom.ScreenChannel[0] = 3;
+  RADIO_ConfigureChannel(0, 2);
+  EEPROM_WriteBuffer(0x0F50 + 3 * 16, Name);
+  EEPROM_ReadBuffer(3 * 16, Record, sizeof(Record));
+  memcpy(Record, &Frequency, sizeof(Frequency));
+  EEPROM_WriteBuffer(3 * 16, Record);
+  SETTINGS_InvalidateChannelCache();
+  GetChannelName(3, Read);
+  CHECK(strcmp(Read, Name) == 0);
+  RADIO_ConfigureChannel(0, 2);
+  CHECK_EQ(gEeprom.VfoInfo[0].ConfigRX.Frequency, Frequency);
+
+  // back to the image the scans expect
+  Frequency = ChannelFrequency(3);
+  memcpy(Record, &Frequency, sizeof(Frequency));
+  EEPROM_WriteBuffer(3 * 16, Record);
+  SETTINGS_InvalidateChannelCache();
+}
+
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+// Hops round all channels Laps times as MR_NextChannel() does and returns
+// hops per second
+static uint32_t ScanHops(uint8_t Laps) {
+  const uint8_t VFO = gEeprom.RX_VFO;
+  const uint64_t Start = HOST_GetTimeUs();
+  uint16_t Channel;
+  uint8_t Lap;
+
+  for (Lap = 0; Lap < Laps; Lap++) {
+    for (Channel = MR_CHANNEL_FIRST; Channel <= MR_CHANNEL_LAST; Channel++) {
+      gEeprom.MrChannel[VFO] = Channel;
+      gEeprom.ScreenChannel[VFO] = Channel;
+      RADIO_TuneScanChannel(Channel);
+      CHECK_EQ(gEeprom.VfoInfo[VFO].pRX->Frequency, ChannelFrequency(Channel));
+    }
+  }
+
+  return (uint64_t)Laps * (MR_CHANNEL_LAST + 1) * 1000000U /
+         (HOST_GetTimeUs() - Start);
+}
+
+// The scan starts without touching the EEPROM, the first lap reads each
+// channel as a scan without images does, the laps after it hop from RAM.
+static void CheckScanHops(void) {
+  uint32_t Bytes, Plain, First, Later;
+
+  BK4819_Init();
+  BOARD_EEPROM_LoadCalibration();
+  RADIO_ConfigureChannel(0, 2);
+  RADIO_ConfigureChannel(1, 2);
+  RADIO_SelectVfos();
+  RADIO_SetupRegisters(true);
+  gCurrentFunction = FUNCTION_FOREGROUND;
+  RADIO_DropScanImages();
+  Plain = ScanHops(2);
+
+  Bytes = gHostEepromStats.BytesRead;
+  RADIO_PrepareScanImages(0);
+  CHECK_EQ(gHostEepromStats.BytesRead, Bytes);
+  First = ScanHops(1);
+  Bytes = gHostEepromStats.BytesRead;
+  Later = ScanHops(4);
+  CHECK_EQ(gHostEepromStats.BytesRead, Bytes);
+  CHECK(Later > Plain);
+  RADIO_DropScanImages();
+
+  fprintf(stderr,
+          "channels: 200 channel scan, hops/s without images %u, first lap "
+          "%u, later laps %u\n",
+          Plain, First, Later);
+}
+#endif
+
+int main(void) {
+  char Path[] = "/tmp/uvk5-eeprom-XXXXXX";
+  const int File = mkstemp(Path);
+
+  if (File < 0 || WriteImage(File) || HOST_MapPeripherals() ||
+      HOST_EEPROM_Load(Path)) {
+    perror(Path);
+    return 1;
+  }
+  BOARD_EEPROM_Init();
+
+  CheckScanlistScroll();
+  CheckScanSteps();
+  CheckInvalidate();
+  CheckNotPlain();
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+  CheckScanHops();
+#endif
+
+  close(File);
+  unlink(Path);
+
+  return TEST_Finish("channels");
+}
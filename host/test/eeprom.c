@@ -0,0 +1,112 @@
+/* EEPROM driver against the BL24C64 model: writes at any offset land where
+ * they were asked to, batches are burst as whole pages, and the programming
+ * throughput of a full image upload.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "driver/eeprom.h"
+#include "host/host.h"
+#include "host/test/test.h"
+
+#define IMAGE_SIZE 0x2000U
+
+static uint8_t gExpected[IMAGE_SIZE];
+
+static void CheckImage(void) {
+  uint8_t Buffer[128];
+  uint16_t Address;
+
+  for (Address = 0; Address < IMAGE_SIZE; Address += sizeof(Buffer)) {
+    EEPROM_ReadBuffer(Address, Buffer, sizeof(Buffer));
+    CHECK(memcmp(Buffer, &gExpected[Address], sizeof(Buffer)) == 0);
+  }
+}
+
+// The chip wraps at its end, like the model.
+static void Write(uint16_t Address, const uint8_t *pData) {
+  uint8_t i;
+
+  for (i = 0; i < 8; i++) {
+    gExpected[(Address + i) & (IMAGE_SIZE - 1U)] = pData[i];
+  }
+  EEPROM_WriteBuffer(Address, pData);
+}
+
+// Offsets from the CPS are not necessarily 8-byte aligned, and may straddle
+// a 32-byte page.
+static void CheckUnaligned(void) {
+  const uint8_t Data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  const uint32_t Pages = gHostEepromStats.PageWrites;
+
+  Write(0x101C, Data);
+  CHECK_EQ(gHostEepromStats.PageWrites - Pages, 2);
+  Write(0x1003, Data);
+  Write(0x1FFA, Data);
+  CheckImage();
+
+  EEPROM_BeginBatch();
+  Write(0x0FFB, Data);
+  Write(0x0FF3, Data);
+  EEPROM_EndBatch();
+  CheckImage();
+}
+
+static void CheckUpload(void) {
+  const uint32_t Pages = gHostEepromStats.PageWrites;
+  const uint32_t Requested = gEepromStats.BytesRequested;
+  uint8_t Data[8];
+  uint64_t Start, Us;
+  uint16_t Address;
+  uint8_t i;
+
+  Start = HOST_GetTimeUs();
+  EEPROM_BeginBatch();
+  for (Address = 0; Address < IMAGE_SIZE; Address += 8) {
+    for (i = 0; i < 8; i++) {
+      Data[i] = rand();
+    }
+    Write(Address, Data);
+  }
+  EEPROM_EndBatch();
+  Us = HOST_GetTimeUs() - Start;
+
+  CHECK_EQ(gEepromStats.BytesRequested - Requested, IMAGE_SIZE);
+  CHECK_EQ(gHostEepromStats.PageWrites - Pages, IMAGE_SIZE / EEPROM_PAGE_SIZE);
+  // Writing 8 bytes every 10ms was the old rate.
+  CHECK(Us < IMAGE_SIZE / 8 * 10000U);
+  fprintf(stderr, "eeprom: %u bytes in %u ms, %u bytes/s, %u busy polls\n",
+          IMAGE_SIZE, (unsigned)(Us / 1000U),
+          (unsigned)(IMAGE_SIZE * 1000000ULL / Us), gEepromStats.Polls);
+  CheckImage();
+
+  // Rewriting the same image skips every page.
+  EEPROM_BeginBatch();
+  for (Address = 0; Address < IMAGE_SIZE; Address += 8) {
+    EEPROM_WriteBuffer(Address, &gExpected[Address]);
+  }
+  EEPROM_EndBatch();
+  CHECK_EQ(gHostEepromStats.PageWrites - Pages, IMAGE_SIZE / EEPROM_PAGE_SIZE);
+}
+
+int main(void) {
+  char Path[] = "/tmp/uvk5-eeprom-XXXXXX";
+  const int File = mkstemp(Path);
+
+  if (File < 0 || HOST_MapPeripherals() || HOST_EEPROM_Load(Path)) {
+    perror(Path);
+    return 1;
+  }
+  memset(gExpected, 0xFF, sizeof(gExpected));
+
+  CheckUnaligned();
+  CheckUpload();
+
+  close(File);
+  unlink(Path);
+
+  return TEST_Finish("eeprom");
+}
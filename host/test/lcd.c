@@ -0,0 +1,218 @@
+/* ST7565 driver against the panel model: what the driver sends over SPI0
+ * must end up on the glass, and a blit only sends the columns that changed.
+ *
+ * The main, menu and scanlist screens are rendered through the firmware's
+ * own code, and the SPI bytes of their first frame, of a frame after one
+ * change and of a repeat of the same frame are reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app/menu.h"
+#include "apps/scanlist.h"
+#include "board.h"
+#include "driver/bk4819.h"
+#include "driver/st7565.h"
+#include "driver/systick.h"
+#include "host/host.h"
+#include "host/test/test.h"
+#include "misc.h"
+#include "radio.h"
+#include "settings.h"
+#include "ui/main.h"
+#include "ui/menu.h"
+
+#define FULL_FRAME (1 + 7 * (3 + LCD_WIDTH))
+
+static void CheckPanel(void) {
+  uint8_t Line;
+
+  CHECK(memcmp(HOST_LCD_GetPage(0), gStatusLine, LCD_WIDTH) == 0);
+  for (Line = 0; Line < 7; Line++) {
+    CHECK(memcmp(HOST_LCD_GetPage(Line + 1U), gFrameBuffer[Line],
+                 LCD_WIDTH) == 0);
+  }
+}
+
+static uint32_t BlitBytes(void) {
+  const uint32_t Before = gHostLcdStats.BytesSent;
+
+  ST7565_BlitFullScreen();
+  ST7565_WaitForFlush();
+
+  return gHostLcdStats.BytesSent - Before;
+}
+
+// Start line command, then per changed page the page and column address
+// and the changed span.
+static void CheckBytesSent(void) {
+  uint8_t Line;
+
+  memset(gFrameBuffer, 0x55, sizeof(gFrameBuffer));
+  CHECK_EQ(BlitBytes(), FULL_FRAME);
+  CheckPanel();
+
+  CHECK(BlitBytes() <= 1);
+
+  gFrameBuffer[2][40] |= 0x02;
+  CHECK_EQ(BlitBytes(), 1 + 3 + 1);
+  CheckPanel();
+
+  gFrameBuffer[5][3] = 0;
+  gFrameBuffer[5][9] = 0;
+  CHECK_EQ(BlitBytes(), 1 + 3 + 7);
+  CheckPanel();
+
+  // a spectrum trace touches every column of the pages it covers
+  for (Line = 1; Line < 5; Line++) {
+    memset(gFrameBuffer[Line], 0x80 >> Line, LCD_WIDTH);
+  }
+  CHECK_EQ(BlitBytes(), 1 + 4 * (3 + LCD_WIDTH));
+  CheckPanel();
+}
+
+// Bytes one call of pRender sends, the blit included
+static uint32_t RenderBytes(void (*pRender)(void)) {
+  const uint32_t Before = gHostLcdStats.BytesSent;
+
+  pRender();
+  ST7565_WaitForFlush();
+  CheckPanel();
+
+  return gHostLcdStats.BytesSent - Before;
+}
+
+// From a blank panel: the first frame, the frame after pChange, and the
+// same frame again, which must send no page
+static void CheckScreen(const char *pName, void (*pRender)(void),
+                        void (*pChange)(void)) {
+  uint32_t First, Changed, Again;
+
+  memset(gFrameBuffer, 0, sizeof(gFrameBuffer));
+  BlitBytes();
+
+  First = RenderBytes(pRender);
+  pChange();
+  Changed = RenderBytes(pRender);
+  Again = RenderBytes(pRender);
+
+  CHECK(First <= FULL_FRAME);
+  CHECK(Changed <= FULL_FRAME);
+  CHECK(Again <= 1);
+  fprintf(stderr,
+          "lcd: %-8s SPI bytes per frame: first %u, after a change %u, "
+          "unchanged %u (full frame %u)\n",
+          pName, First, Changed, Again, FULL_FRAME);
+}
+
+// the next step up on VFO A
+static void StepFrequency(void) {
+  gEeprom.VfoInfo[0].pRX->Frequency += gEeprom.VfoInfo[0].StepFrequency;
+}
+
+static void MenuDown(void) {
+  gMenuCursor++;
+  MENU_ShowCurrentSetting();
+}
+
+static void ScanlistDown(void) { SCANLIST_key(KEY_DOWN, true, false); }
+
+static void CheckScreens(void) {
+  BOARD_EEPROM_Init();
+  BK4819_Init();
+  BOARD_EEPROM_LoadCalibration();
+  RADIO_ConfigureChannel(0, 2);
+  RADIO_ConfigureChannel(1, 2);
+  RADIO_SelectVfos();
+  RADIO_SetupRegisters(true);
+  gMenuListCount = MENU_ITEMS_COUNT - 6;
+
+  CheckScreen("main", UI_DisplayMain, StepFrequency);
+  gMenuCursor = 0;
+  MENU_ShowCurrentSetting();
+  CheckScreen("menu", UI_DisplayMenu, MenuDown);
+  CheckScreen("scanlist", SCANLIST_render, ScanlistDown);
+}
+
+#if defined(ENABLE_LCD_DMA)
+// With the tick held off the flush cannot progress past its first page, so
+// a blit that waited for the whole flush would never return.
+static void CheckBlitDuringFlush(void) {
+  memset(gFrameBuffer, 0x11, sizeof(gFrameBuffer));
+  __disable_irq();
+  ST7565_BlitFullScreen();
+  CHECK(!ST7565_IsFlushDone());
+  gFrameBuffer[6][0] = 0x22;
+  gFrameBuffer[6][100] = 0x22;
+  ST7565_BlitFullScreen();
+  CHECK(!ST7565_IsFlushDone());
+  __enable_irq();
+  ST7565_WaitForFlush();
+  CheckPanel();
+}
+#endif
+
+int main(void) {
+  uint8_t Line;
+  uint8_t i;
+
+  if (HOST_MapPeripherals()) {
+    return 1;
+  }
+  // runs the DMA flush when built with ENABLE_LCD_DMA
+  SYSTICK_Init();
+
+  ST7565_Init();
+  for (Line = 0; Line < 8; Line++) {
+    for (i = 0; i < LCD_WIDTH; i++) {
+      CHECK_EQ(HOST_LCD_GetPage(Line)[i], 0);
+    }
+  }
+
+  for (i = 0; i < LCD_WIDTH; i++) {
+    gStatusLine[i] = i;
+    for (Line = 0; Line < 7; Line++) {
+      gFrameBuffer[Line][i] = rand();
+    }
+  }
+  ST7565_BlitStatusLine();
+  ST7565_BlitFullScreen();
+  ST7565_WaitForFlush();
+  CheckPanel();
+
+  // partial updates, including the first and last column
+  gFrameBuffer[0][0] ^= 0x01;
+  gFrameBuffer[3][64] ^= 0x80;
+  gFrameBuffer[6][LCD_WIDTH - 1] ^= 0x10;
+  ST7565_BlitFullScreen();
+  ST7565_WaitForFlush();
+  CheckPanel();
+
+  // DrawLine writes the panel behind the driver's back
+  ST7565_DrawLine(10, 4, 8, gStatusLine, false);
+  for (i = 0; i < 8; i++) {
+    CHECK_EQ(HOST_LCD_GetPage(4)[10 + i], gStatusLine[i]);
+  }
+  ST7565_BlitFullScreen();
+  ST7565_WaitForFlush();
+  CheckPanel();
+
+  ST7565_FillScreen(0xFF);
+  for (i = 0; i < LCD_WIDTH; i++) {
+    CHECK_EQ(HOST_LCD_GetPage(7)[i], 0xFF);
+  }
+  ST7565_BlitFullScreen();
+  ST7565_BlitStatusLine();
+  ST7565_WaitForFlush();
+  CheckPanel();
+
+  CheckBytesSent();
+  CheckScreens();
+#if defined(ENABLE_LCD_DMA)
+  CheckBlitDuringFlush();
+#endif
+
+  return TEST_Finish("lcd");
+}
@@ -0,0 +1,202 @@
+/* Timer wheel: every timer fires on the tick it was armed for, whichever
+ * level it was placed on, also when cancelled, re-armed from a callback or
+ * running across the wrap of gGlobalSysTickCounter. The test drives the
+ * SysTick handler itself, so no time passes between ticks.
+ */
+
+#include <string.h>
+
+#include "host/host.h"
+#include "host/test/test.h"
+#include "misc.h"
+#include "scheduler.h"
+
+#define TIMERS 16U
+
+void SystickHandler(void);
+
+static SCHEDULER_Timer_t gTimers[TIMERS];
+static uint32_t gFiredAt[TIMERS];
+static uint16_t gFiredCount[TIMERS];
+static volatile bool gFlag;
+
+#define DEFINE_CALLBACK(n)                                                     \
+  static void Fired##n(void) {                                                 \
+    gFiredAt[n] = gGlobalSysTickCounter;                                       \
+    gFiredCount[n]++;                                                          \
+  }
+
+DEFINE_CALLBACK(0)
+DEFINE_CALLBACK(1)
+DEFINE_CALLBACK(2)
+DEFINE_CALLBACK(3)
+DEFINE_CALLBACK(4)
+DEFINE_CALLBACK(5)
+DEFINE_CALLBACK(6)
+DEFINE_CALLBACK(7)
+DEFINE_CALLBACK(8)
+DEFINE_CALLBACK(9)
+DEFINE_CALLBACK(10)
+DEFINE_CALLBACK(11)
+DEFINE_CALLBACK(12)
+DEFINE_CALLBACK(13)
+DEFINE_CALLBACK(14)
+
+static void (*const gCallbacks[TIMERS])(void) = {
+    Fired0, Fired1, Fired2,  Fired3,  Fired4,  Fired5,  Fired6,  Fired7,
+    Fired8, Fired9, Fired10, Fired11, Fired12, Fired13, Fired14, NULL,
+};
+
+static void Reset(void) {
+  uint8_t i;
+
+  for (i = 0; i < TIMERS; i++) {
+    SCHEDULER_Cancel(&gTimers[i]);
+  }
+  memset(gTimers, 0, sizeof(gTimers));
+  memset(gFiredAt, 0, sizeof(gFiredAt));
+  memset(gFiredCount, 0, sizeof(gFiredCount));
+  for (i = 0; i < TIMERS; i++) {
+    gTimers[i].pCallback = gCallbacks[i];
+  }
+}
+
+static void Tick(uint32_t Count) {
+  while (Count--) {
+    SystickHandler();
+  }
+}
+
+// Delays on every level and on the edges between them, and past the top
+// level's span where a timer goes round the wheel more than once.
+static void CheckInsert(void) {
+  static const uint32_t Delays[] = {1,   2,    15,   16,   17,    255,  256,
+                                    257, 1000, 4095, 4096, 4097, 10000};
+  const uint32_t Start = gGlobalSysTickCounter;
+  uint8_t i;
+
+  Reset();
+  for (i = 0; i < ARRAY_SIZE(Delays); i++) {
+    SCHEDULER_Arm(&gTimers[i], Delays[i]);
+    CHECK(SCHEDULER_IsArmed(&gTimers[i]));
+  }
+  Tick(10001);
+  for (i = 0; i < ARRAY_SIZE(Delays); i++) {
+    CHECK_EQ(gFiredCount[i], 1);
+    CHECK_EQ(gFiredAt[i] - Start, Delays[i]);
+    CHECK(!SCHEDULER_IsArmed(&gTimers[i]));
+  }
+}
+
+static void CheckCancel(void) {
+  uint8_t i;
+
+  Reset();
+  for (i = 0; i < 6; i++) {
+    SCHEDULER_Arm(&gTimers[i], 5 + i * 100);
+  }
+  // one on each upper level, and one never armed
+  SCHEDULER_Cancel(&gTimers[1]);
+  SCHEDULER_Cancel(&gTimers[4]);
+  SCHEDULER_Cancel(&gTimers[7]);
+  CHECK(!SCHEDULER_IsArmed(&gTimers[1]));
+  Tick(600);
+  for (i = 0; i < 6; i++) {
+    CHECK_EQ(gFiredCount[i], i == 1 || i == 4 ? 0 : 1);
+  }
+
+  // cancelling after expiry is harmless
+  SCHEDULER_Cancel(&gTimers[0]);
+  CHECK(!SCHEDULER_IsArmed(&gTimers[0]));
+}
+
+static uint8_t gChained;
+
+static void RearmSelf(void) {
+  gFiredAt[15] = gGlobalSysTickCounter;
+  if (++gChained < 3) {
+    SCHEDULER_Arm(&gTimers[15], 20);
+  }
+}
+
+static void CheckRearm(void) {
+  uint32_t Start;
+
+  Reset();
+  Start = gGlobalSysTickCounter;
+
+  // arming again moves the expiry, whether sooner or later
+  SCHEDULER_Arm(&gTimers[0], 300);
+  SCHEDULER_Arm(&gTimers[0], 10);
+  SCHEDULER_Arm(&gTimers[1], 10);
+  SCHEDULER_Arm(&gTimers[1], 300);
+
+  // a periodic timer with a flag, as the timeslices are set up
+  gTimers[2].Period = 4;
+  gTimers[2].pFlag = &gFlag;
+  SCHEDULER_Arm(&gTimers[2], 4);
+
+  gTimers[15].pCallback = RearmSelf;
+  gChained = 0;
+  SCHEDULER_Arm(&gTimers[15], 20);
+
+  Tick(3);
+  CHECK(!gFlag);
+  Tick(1);
+  CHECK(gFlag);
+
+  Tick(400);
+  CHECK_EQ(gFiredCount[0], 1);
+  CHECK_EQ(gFiredAt[0] - Start, 10);
+  CHECK_EQ(gFiredCount[1], 1);
+  CHECK_EQ(gFiredAt[1] - Start, 300);
+  CHECK_EQ(gFiredCount[2], 404 / 4);
+  CHECK(SCHEDULER_IsArmed(&gTimers[2]));
+  CHECK_EQ(gChained, 3);
+  CHECK_EQ(gFiredAt[15] - Start, 60);
+
+  // ticks of 0 still wait for the next one
+  SCHEDULER_Cancel(&gTimers[2]);
+  SCHEDULER_Arm(&gTimers[3], 0);
+  Tick(1);
+  CHECK_EQ(gFiredCount[3], 1);
+}
+
+static void CheckWrap(void) {
+  static const uint32_t Delays[] = {1, 10, 16, 100, 256, 1000, 5000};
+  uint32_t Start;
+  uint8_t i;
+
+  Reset();
+  gTimers[10].Period = 7;
+
+  // placing is relative to the counter, so it may be moved while the wheel
+  // is empty
+  gGlobalSysTickCounter = 0xFFFFFFFFU - 500;
+  Start = gGlobalSysTickCounter;
+  for (i = 0; i < ARRAY_SIZE(Delays); i++) {
+    SCHEDULER_Arm(&gTimers[i], Delays[i]);
+  }
+  SCHEDULER_Arm(&gTimers[10], 7);
+  Tick(5001);
+  for (i = 0; i < ARRAY_SIZE(Delays); i++) {
+    CHECK_EQ(gFiredCount[i], 1);
+    CHECK_EQ(gFiredAt[i] - Start, Delays[i]);
+  }
+  CHECK_EQ(gFiredCount[10], 5001 / 7);
+  CHECK_EQ((uint32_t)(gFiredAt[10] - Start) % 7, 0);
+}
+
+int main(void) {
+  if (HOST_MapPeripherals()) {
+    return 1;
+  }
+
+  CheckInsert();
+  CheckCancel();
+  CheckRearm();
+  CheckWrap();
+  Reset();
+
+  return TEST_Finish("scheduler");
+}
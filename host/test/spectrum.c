@@ -0,0 +1,487 @@
+/* Spectrum sweep processing, on the static functions of app/spectrum.c.
+ *
+ * Wide sweeps are max-held into the 128 column trace: every column must show
+ * the strongest of its bins and the peak must keep that bin's index.
+ *
+ * MoveHistory must give the same means as a copy of the original moving
+ * average, which shifted every history row and re-summed each column per
+ * sweep. Both are timed for reference only: a host CPU copies and sums rows
+ * with SIMD, which the Cortex-M0 does not have, so the times say nothing
+ * about which is faster on the radio.
+ *
+ * Peak finding must see one carrier across a blacklisted column.
+ *
+ * The noise floor is fed flat, single carrier and crowded sweeps: it must
+ * stay within the noise while carriers fill less than half the columns,
+ * follow a change of the band by a quarter step per sweep, and carry the
+ * trigger level with it.
+ *
+ * A PC may only open the app from idle: during TX or RX the launch is
+ * refused and the reply says so.
+ *
+ * The spectrum screen is rendered on the panel model, and the SPI bytes of
+ * its first frame, of the frame after a new sweep and of a repeat of the
+ * same frame are reported.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app/spectrum.c"
+#include "host/host.h"
+#include "host/test/test.h"
+
+#define SWEEPS 20000U
+
+static void FillWide(uint16_t Bins, uint16_t Seed) {
+  uint16_t i;
+
+  srand(Seed);
+  for (i = 0; i < Bins; i++) {
+    scanInfo.i = i;
+    StoreRssi((40 + rand() % 60) << 1);
+  }
+}
+
+static void CheckDecimation(WideSteps Wide) {
+  const uint8_t BPP = 1 << Wide;
+  const uint16_t Bins = 128 << Wide;
+  uint16_t Strongest[128];
+  uint8_t x, j;
+
+  settings.wideSteps = Wide;
+  CHECK_EQ(GetMeasurementsCount(), Bins);
+  FillWide(Bins, Wide);
+
+  // a carrier on a different bin of each column
+  for (x = 0; x < 128; x++) {
+    Strongest[x] = (x << Wide) + x % BPP;
+    scanInfo.i = Strongest[x];
+    StoreRssi((110 + x % 16) << 1);
+  }
+
+  DecimateWideHistory();
+  for (x = 0; x < 128; x++) {
+    uint8_t Max = 0;
+
+    for (j = 0; j < BPP; j++) {
+      if (wideHistory[(x << Wide) + j] > Max) {
+        Max = wideHistory[(x << Wide) + j];
+      }
+    }
+    CHECK_EQ(rssiHistory[x], Max << 1);
+    CHECK_EQ(rssiHistory[x], (110 + x % 16) << 1);
+    CHECK_EQ(ColumnBin(x), Strongest[x]);
+    CHECK_EQ(BinToX(Strongest[x]), x);
+    CHECK_EQ(BlacklistIndex(Strongest[x]), x);
+  }
+}
+
+// The decimated trace is the 128 step sweep of the same band at 1 dB
+static void CheckMatchesNarrow(void) {
+  uint16_t Narrow[128];
+  uint8_t x;
+
+  settings.wideSteps = WIDE_OFF;
+  settings.stepsCount = STEPS_128;
+  srand(7);
+  for (x = 0; x < 128; x++) {
+    scanInfo.i = x;
+    StoreRssi(Narrow[x] = (40 + rand() % 60) << 1);
+  }
+
+  settings.wideSteps = WIDE_512;
+  memset(wideHistory, 0, sizeof(wideHistory));
+  for (x = 0; x < 128; x++) {
+    scanInfo.i = (x << WIDE_512) + 3;
+    StoreRssi(Narrow[x] + 1); // the half dB is dropped
+  }
+  memset(rssiHistory, 0, sizeof(rssiHistory));
+  DecimateWideHistory();
+  for (x = 0; x < 128; x++) {
+    CHECK_EQ(rssiHistory[x], Narrow[x]);
+  }
+}
+
+static uint16_t gLegacyBuf[SPECTRUM_MOV_DEPTH][128];
+static uint16_t gLegacyMean[128];
+
+static void LegacyMoveHistory(void) {
+  const uint8_t XN = GetStepsCount();
+  uint8_t i, x;
+
+  for (i = SPECTRUM_MOV_DEPTH - 1; i > 0; --i) {
+    memcpy(gLegacyBuf[i], gLegacyBuf[i - 1], XN * sizeof(uint16_t));
+  }
+  memcpy(gLegacyBuf[0], rssiHistory, XN * sizeof(uint16_t));
+  for (x = 0; x < XN; ++x) {
+    uint32_t sum = 0;
+
+    for (i = 0; i < SPECTRUM_MOV_DEPTH; ++i) {
+      sum += gLegacyBuf[i][x];
+    }
+    gLegacyMean[x] = sum / SPECTRUM_MOV_DEPTH;
+  }
+}
+
+static void RandomSweep(void) {
+  uint8_t x;
+
+  for (x = 0; x < 128; x++) {
+    rssiHistory[x] = 80 + rand() % 120;
+  }
+}
+
+static uint32_t NsPerSweep(uint64_t Start) {
+  return (HOST_GetTimeUs() - Start) * 1000U / SWEEPS;
+}
+
+// The ring must give the original mean exactly
+static void CheckMoveHistory(void) {
+  uint32_t Legacy, Now;
+  uint64_t Start;
+  uint32_t n;
+  uint8_t x;
+
+  settings.wideSteps = WIDE_OFF;
+  settings.stepsCount = STEPS_128;
+  memset(blacklist, false, sizeof(blacklist));
+  srand(5);
+  RandomSweep();
+  for (n = 0; n < SPECTRUM_MOV_DEPTH; n++) {
+    memcpy(gLegacyBuf[n], rssiHistory, sizeof(rssiHistory));
+  }
+  ResetMoving();
+  lastStepsCount = GetStepsCount();
+
+  for (n = 0; n < 64; n++) {
+    RandomSweep();
+    MoveHistory();
+    LegacyMoveHistory();
+#ifndef SPECTRUM_MOV_EXPONENTIAL
+    for (x = 0; x < 128; x++) {
+      CHECK_EQ(mov.mean[x], gLegacyMean[x]);
+    }
+#endif
+  }
+
+  Start = HOST_GetTimeUs();
+  for (n = 0; n < SWEEPS; n++) {
+    rssiHistory[n & 127] = 80 + (n & 63);
+    LegacyMoveHistory();
+  }
+  Legacy = NsPerSweep(Start);
+
+  Start = HOST_GetTimeUs();
+  for (n = 0; n < SWEEPS; n++) {
+    rssiHistory[n & 127] = 80 + (n & 63);
+    for (x = 0; x < 128; x++) {
+      mov.mean[x] = MovePoint(x);
+    }
+#ifndef SPECTRUM_MOV_EXPONENTIAL
+    mov.head = (mov.head + 1) & (SPECTRUM_MOV_DEPTH - 1);
+#endif
+  }
+  Now = NsPerSweep(Start);
+
+  Start = HOST_GetTimeUs();
+  for (n = 0; n < SWEEPS; n++) {
+    rssiHistory[n & 127] = 80 + (n & 63);
+    MoveHistory();
+  }
+
+  fprintf(stderr,
+          "spectrum: ns/sweep of 128 columns, averaging legacy %u now %u, "
+          "whole MoveHistory %u\n",
+          Legacy, Now, NsPerSweep(Start));
+}
+
+// A blacklisted column inside a carrier is skipped, not taken for the dip
+// between two carriers
+static void CheckPeakOverBlacklist(void) {
+  static const uint16_t Carrier[] = {150, 190, 0, 195, 150};
+  uint8_t x;
+
+  settings.wideSteps = WIDE_OFF;
+  settings.stepsCount = STEPS_128;
+  settings.rssiTriggerLevel = RSSI_MAX_VALUE;
+  noiseFloor = 80;
+  memset(blacklist, false, sizeof(blacklist));
+  for (x = 0; x < 128; x++) {
+    rssiHistory[x] = 80;
+  }
+  for (x = 0; x < ARRAY_SIZE(Carrier); x++) {
+    rssiHistory[60 + x] = Carrier[x];
+  }
+  blacklist[62] = true;
+
+  BeginPeaks();
+  for (x = 0; x < 128; x++) {
+    FindPeak(x, 128);
+  }
+  CHECK_EQ(peaksCount, 1);
+  CHECK_EQ(peaks[0].i, 63);
+  CHECK_EQ(peaks[0].rssi, 195);
+
+  // two carriers with a real dip between them stay apart
+  blacklist[62] = false;
+  rssiHistory[62] = 80;
+  BeginPeaks();
+  for (x = 0; x < 128; x++) {
+    FindPeak(x, 128);
+  }
+  CHECK_EQ(peaksCount, 2);
+
+  memset(blacklist, false, sizeof(blacklist));
+  noiseFloor = 0;
+}
+
+// Exact median of the first count levels, for FloorMedian to land near
+static uint16_t SortedMedian(const uint16_t *pLevels, uint8_t count) {
+  uint16_t Sorted[128];
+  uint8_t i, j;
+
+  memcpy(Sorted, pLevels, count * sizeof(Sorted[0]));
+  for (i = 1; i < count; i++) {
+    const uint16_t v = Sorted[i];
+
+    for (j = i; j && Sorted[j - 1] > v; j--) {
+      Sorted[j] = Sorted[j - 1];
+    }
+    Sorted[j] = v;
+  }
+  return Sorted[count >> 1];
+}
+
+// Noise around 100 (-110 dBm), with Carriers columns from Seed at 180
+static void FillBand(uint16_t *pLevels, uint8_t Carriers, uint16_t Seed) {
+  uint8_t x;
+
+  srand(Seed);
+  for (x = 0; x < 128; x++) {
+    pLevels[x] = 92 + rand() % 17;
+  }
+  for (x = 0; x < Carriers; x++) {
+    pLevels[(Seed + x * 37) & 127] = 170 + rand() % 20;
+  }
+}
+
+// Within the median's 2 dB bucket of the exact median
+static void CheckMedian(const uint16_t *pLevels, uint8_t count) {
+  uint8_t histogram[FLOOR_BUCKETS] = {0};
+  const uint16_t Exact = SortedMedian(pLevels, count);
+  uint16_t Median;
+  uint8_t x;
+
+  for (x = 0; x < count; x++) {
+    FloorAdd(histogram, pLevels[x]);
+  }
+  Median = FloorMedian(histogram, count);
+  CHECK_EQ(Median >> FLOOR_BUCKET_SHIFT, Exact >> FLOOR_BUCKET_SHIFT);
+}
+
+static void CheckFloorMedian(void) {
+  uint8_t histogram[FLOOR_BUCKETS] = {0};
+  uint16_t Levels[128];
+  uint8_t x;
+
+  // flat, every column the same
+  for (x = 0; x < 128; x++) {
+    Levels[x] = 100;
+  }
+  CheckMedian(Levels, 128);
+
+  FillBand(Levels, 0, 1);
+  CheckMedian(Levels, 128);
+  CheckMedian(Levels, 37); // fewer columns, as with blacklisted ones
+
+  // a single carrier over a few columns does not show
+  FillBand(Levels, 6, 2);
+  CheckMedian(Levels, 128);
+  CHECK(SortedMedian(Levels, 128) <= 108);
+
+  // crowded up to just under half the columns still gives the noise
+  FillBand(Levels, 63, 3);
+  CheckMedian(Levels, 128);
+  CHECK(SortedMedian(Levels, 128) <= 108);
+
+  // past half the band, the floor is the carriers'
+  FillBand(Levels, 100, 4);
+  CheckMedian(Levels, 128);
+  CHECK(SortedMedian(Levels, 128) >= 170);
+
+  // a sweep off the top of the histogram lands in its last bucket
+  for (x = 0; x < 128; x++) {
+    FloorAdd(histogram, 400);
+  }
+  CHECK_EQ(FloorMedian(histogram, 128) >> FLOOR_BUCKET_SHIFT,
+           FLOOR_BUCKETS - 1);
+}
+
+// Sweeps go through MoveHistory, which fills the histogram, skips the
+// blacklisted columns and moves the floor and the trigger.
+static void Sweep(const uint16_t *pLevels) {
+  memcpy(rssiHistory, pLevels, sizeof(rssiHistory));
+  MoveHistory();
+}
+
+static void CheckNoiseFloor(void) {
+  uint16_t Levels[128];
+  uint16_t Previous;
+  uint8_t n, x;
+
+  settings.wideSteps = WIDE_OFF;
+  settings.stepsCount = STEPS_128;
+  memset(blacklist, false, sizeof(blacklist));
+  noiseFloor = 0;
+  currentState = SPECTRUM;
+  settings.rssiTriggerLevel = RSSI_MAX_VALUE;
+
+  // the first sweep sets the floor outright
+  FillBand(Levels, 0, 5);
+  Sweep(Levels);
+  CHECK(noiseFloor >= 96 && noiseFloor <= 104);
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+  CHECK_EQ(settings.rssiTriggerLevel, noiseFloor + settings.squelchMargin);
+#endif
+
+  // a carrier appearing, or a crowd of them, leaves it within the noise;
+  // a crowd takes it up to the top of the noise, as the median is then
+  // drawn from fewer noise columns
+  for (n = 0; n < 20; n++) {
+    FillBand(Levels, n < 10 ? 1 : 60, 6 + n);
+    Sweep(Levels);
+    CHECK(noiseFloor >= 92 && noiseFloor <= 108);
+  }
+
+  // strong blacklisted columns are left out of the median
+  noiseFloor = 0;
+  FillBand(Levels, 0, 30);
+  for (x = 0; x < 80; x++) {
+    blacklist[x] = true;
+    Levels[x] = 250;
+  }
+  Sweep(Levels);
+  CHECK(noiseFloor >= 96 && noiseFloor <= 104);
+  memset(blacklist, false, sizeof(blacklist));
+
+  // the band rising 20 dB is followed a quarter step per sweep, without
+  // overshooting
+  for (x = 0; x < 128; x++) {
+    Levels[x] = 140;
+  }
+  Previous = noiseFloor;
+  Sweep(Levels);
+  CHECK(noiseFloor > Previous);
+  CHECK(noiseFloor - Previous <= (142 - Previous + 3) / 4);
+  for (n = 0; n < 30; n++) {
+    Previous = noiseFloor;
+    Sweep(Levels);
+    CHECK(noiseFloor >= Previous && noiseFloor <= 143);
+  }
+  CHECK(noiseFloor >= 139);
+
+#ifdef SPECTRUM_AUTOMATIC_SQUELCH
+  CHECK_EQ(settings.rssiTriggerLevel, noiseFloor + settings.squelchMargin);
+
+  // held closed, the trigger stays put
+  settings.rssiTriggerLevel = RSSI_MAX_VALUE - 1;
+  Sweep(Levels);
+  CHECK_EQ(settings.rssiTriggerLevel, RSSI_MAX_VALUE - 1);
+
+  // and it is only tracked while sweeping
+  settings.rssiTriggerLevel = 200;
+  currentState = FREQ_INPUT;
+  TrackTriggerLevel();
+  CHECK_EQ(settings.rssiTriggerLevel, 200);
+  currentState = SPECTRUM;
+  noiseFloor = 0;
+  TrackTriggerLevel();
+  CHECK_EQ(settings.rssiTriggerLevel, 200);
+#endif
+
+  noiseFloor = 0;
+  settings.rssiTriggerLevel = RSSI_MAX_VALUE;
+}
+
+static void CheckLaunch(FUNCTION_Type_t Function, bool Accepted) {
+  SpectrumStreamConfig Config = {.flags = SPECTRUM_STREAM_ENABLE |
+                                          SPECTRUM_STREAM_LAUNCH};
+
+  gCurrentFunction = Function;
+  gSpectrumLaunchRequest = false;
+  SPECTRUM_ConfigureStream(&Config);
+  CHECK_EQ(gSpectrumLaunchRequest, Accepted);
+  CHECK_EQ(!(Config.flags & SPECTRUM_STREAM_REFUSED), Accepted);
+}
+
+// Bytes Render() sends, the blit included
+static uint32_t RenderBytes(void) {
+  const uint32_t Before = gHostLcdStats.BytesSent;
+
+  Render();
+  ST7565_WaitForFlush();
+
+  return gHostLcdStats.BytesSent - Before;
+}
+
+static void CheckRender(void) {
+  const uint32_t Full = 1 + 7 * (3 + LCD_WIDTH);
+  uint32_t First, Changed, Again;
+
+  settings.wideSteps = WIDE_OFF;
+  settings.stepsCount = STEPS_128;
+  memset(blacklist, false, sizeof(blacklist));
+  currentState = SPECTRUM;
+  srand(9);
+  RandomSweep();
+  MoveHistory();
+
+  memset(gFrameBuffer, 0, sizeof(gFrameBuffer));
+  ST7565_BlitFullScreen();
+  ST7565_WaitForFlush();
+
+  First = RenderBytes();
+  RandomSweep();
+  MoveHistory();
+  Changed = RenderBytes();
+  Again = RenderBytes();
+
+  CHECK(First <= Full);
+  CHECK(Changed <= Full);
+  CHECK(Again <= 1);
+  fprintf(stderr,
+          "spectrum: trace SPI bytes per frame: first %u, after a sweep %u, "
+          "unchanged %u (full frame %u)\n",
+          First, Changed, Again, Full);
+}
+
+int main(void) {
+  if (HOST_MapPeripherals()) {
+    return 1;
+  }
+  // runs the DMA flush when built with ENABLE_LCD_DMA
+  SYSTICK_Init();
+  ST7565_Init();
+
+  CheckDecimation(WIDE_256);
+  CheckDecimation(WIDE_512);
+  CheckDecimation(WIDE_1024);
+  CheckMatchesNarrow();
+  CheckMoveHistory();
+  CheckPeakOverBlacklist();
+  CheckFloorMedian();
+  CheckNoiseFloor();
+  CheckLaunch(FUNCTION_FOREGROUND, true);
+  CheckLaunch(FUNCTION_POWER_SAVE, true);
+  CheckLaunch(FUNCTION_TRANSMIT, false);
+  CheckLaunch(FUNCTION_RECEIVE, false);
+  CheckLaunch(FUNCTION_INCOMING, false);
+  gCurrentFunction = FUNCTION_FOREGROUND;
+  gSpectrumLaunchRequest = false;
+  CheckRender();
+
+  settings.wideSteps = WIDE_OFF;
+
+  return TEST_Finish("spectrum");
+}
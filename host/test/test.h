@@ -0,0 +1,44 @@
+/* Assertions for the host tests (make host-test).
+ *
+ * Each test is a program linked against the host build of the firmware. A
+ * failed check prints its location and makes TEST_Finish() return non-zero,
+ * which fails the make target.
+ */
+
+#ifndef HOST_TEST_TEST_H
+#define HOST_TEST_TEST_H
+
+#include <stdio.h>
+
+static unsigned gTestChecks;
+static unsigned gTestFailures;
+
+#define CHECK(Condition)                                                       \
+  do {                                                                         \
+    gTestChecks++;                                                             \
+    if (!(Condition)) {                                                        \
+      gTestFailures++;                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,         \
+              #Condition);                                                     \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_EQ(Actual, Expected)                                             \
+  do {                                                                         \
+    const long long TestActual = (long long)(Actual);                          \
+    const long long TestExpected = (long long)(Expected);                      \
+    gTestChecks++;                                                             \
+    if (TestActual != TestExpected) {                                          \
+      gTestFailures++;                                                         \
+      fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__,          \
+              __LINE__, #Actual, TestActual, TestExpected);                    \
+    }                                                                          \
+  } while (0)
+
+static inline int TEST_Finish(const char *pName) {
+  fprintf(stderr, "%s: %u checks, %u failed\n", pName, gTestChecks,
+          gTestFailures);
+  return gTestFailures != 0;
+}
+
+#endif
@@ -0,0 +1,309 @@
+/* Bulk CPS transfers over a pty loopback: the test is the PC on the slave
+ * side of the host UART, the firmware command handler answers on the master
+ * side. Covers the link rate switch and its idle fallback, a pipelined write
+ * window, a damaged block inside one, and a streamed read window. The CAT
+ * statistics reply carries the idle percentage.
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "app/uart.h"
+#include "driver/crc.h"
+#include "driver/eeprom.h"
+#include "driver/uart.h"
+#include "host/host.h"
+#include "host/test/test.h"
+#include "misc.h"
+
+#define TIMESTAMP 0x12345678U
+#define WINDOW_ADDRESS 0x1000U
+#define BLOCK 128U
+
+static const uint8_t Obfuscation[16] = {0x16, 0x6C, 0x14, 0xE6, 0x2E, 0x91,
+                                        0x0D, 0x40, 0x21, 0x35, 0xD5, 0x40,
+                                        0x13, 0x03, 0xE9, 0x80};
+
+static int gPc = -1;
+
+static void Put16(uint8_t *pBuffer, uint16_t Value) {
+  pBuffer[0] = Value;
+  pBuffer[1] = Value >> 8;
+}
+
+static void Put32(uint8_t *pBuffer, uint32_t Value) {
+  Put16(pBuffer, Value);
+  Put16(pBuffer + 2, Value >> 16);
+}
+
+static uint16_t Get16(const uint8_t *pBuffer) {
+  return pBuffer[0] | (pBuffer[1] << 8);
+}
+
+static uint32_t Get32(const uint8_t *pBuffer) {
+  return Get16(pBuffer) | ((uint32_t)Get16(pBuffer + 2) << 16);
+}
+
+// Frames a command the way libuvk5.py does, into pFrame. Returns its length.
+static uint16_t BuildFrame(uint8_t *pFrame, uint16_t ID, const uint8_t *pBody,
+                           uint16_t Size) {
+  uint8_t *pPayload = pFrame + 4;
+  uint16_t i;
+
+  pFrame[0] = 0xAB;
+  pFrame[1] = 0xCD;
+  Put16(pFrame + 2, Size + 4);
+  Put16(pPayload, ID);
+  Put16(pPayload + 2, Size);
+  memcpy(pPayload + 4, pBody, Size);
+  Put16(pPayload + 4 + Size, CRC_Calculate(pPayload, Size + 4));
+  for (i = 0; i < Size + 6; i++) {
+    pPayload[i] ^= Obfuscation[i % 16];
+  }
+  pFrame[Size + 10] = 0xDC;
+  pFrame[Size + 11] = 0xBA;
+
+  return Size + 12;
+}
+
+static void Send(const uint8_t *pFrames, uint16_t Size) {
+  CHECK_EQ(write(gPc, pFrames, Size), Size);
+}
+
+// A few main loop passes. A frame that fails its CRC ends a pass, like one
+// still arriving does.
+static void HandleCommands(void) {
+  uint8_t i;
+
+  for (i = 0; i < 8; i++) {
+    HOST_UART_Poll();
+    if (UART_IsCommandAvailable()) {
+      UART_HandleCommand();
+    }
+  }
+}
+
+// Reads one reply and returns its ID, with the payload after the header
+// deobfuscated into pBody.
+static uint16_t Receive(uint8_t *pBody, uint16_t *pSize) {
+  uint8_t Frame[4 + 256 + 4];
+  struct pollfd Poll = {.fd = gPc, .events = POLLIN};
+  uint16_t Size, Have = 0, Want = 4, i;
+
+  while (Have < Want) {
+    const ssize_t Count =
+        poll(&Poll, 1, 1000) == 1 ? read(gPc, Frame + Have, Want - Have) : 0;
+
+    if (Count <= 0) {
+      return 0;
+    }
+    Have += Count;
+    if (Have == 4) {
+      CHECK(Frame[0] == 0xAB && Frame[1] == 0xCD);
+      Want = 4 + Get16(Frame + 2) + 4;
+      if (Want > sizeof(Frame)) {
+        return 0;
+      }
+    }
+  }
+  Size = Get16(Frame + 2);
+  CHECK(Frame[Want - 2] == 0xDC && Frame[Want - 1] == 0xBA);
+  for (i = 0; i < Size; i++) {
+    Frame[4 + i] ^= Obfuscation[i % 16];
+  }
+  *pSize = Get16(Frame + 6);
+  memcpy(pBody, Frame + 8, *pSize);
+
+  return Get16(Frame + 4);
+}
+
+static void CheckStatus(uint16_t Offset, uint16_t Size, uint16_t CRC,
+                        bool bOk) {
+  uint8_t Body[256];
+  uint16_t Length;
+
+  CHECK_EQ(Receive(Body, &Length), 0x0545);
+  CHECK_EQ(Get16(Body), Offset);
+  CHECK_EQ(Get16(Body + 2), Size);
+  CHECK_EQ(Get16(Body + 4), CRC);
+  CHECK_EQ(Body[6], bOk);
+}
+
+static void CheckHello(void) {
+  uint8_t Frame[32], Body[256], Buffer[4];
+  uint16_t Size;
+
+  Put32(Buffer, TIMESTAMP);
+  Send(Frame, BuildFrame(Frame, 0x0514, Buffer, 4));
+  HandleCommands();
+  CHECK_EQ(Receive(Body, &Size), 0x0515);
+}
+
+static void CheckSetup(void) {
+  uint8_t Frame[32], Body[256], Buffer[8];
+  uint16_t Size;
+
+  Put32(Buffer, 115200);
+  Put32(Buffer + 4, TIMESTAMP);
+  Send(Frame, BuildFrame(Frame, 0x0540, Buffer, 8));
+  HandleCommands();
+  CHECK_EQ(Receive(Body, &Size), 0x0541);
+  CHECK_EQ(Get32(Body), 115200);
+  CHECK_EQ(Body[4], 3);
+  CHECK_EQ(Body[5], BLOCK);
+  CHECK_EQ(Get16(Body + 6), 1024);
+  CHECK_EQ(HOST_UART_GetBaudRate(), 115200);
+}
+
+// The window command and all three blocks are written before the radio
+// handles any of them, as the PC pipelines them. Damage flips a byte of the
+// second block on the wire.
+static void WriteWindow(const uint8_t *pData, bool bDamage) {
+  static uint8_t Frames[512];
+  uint8_t Buffer[4 + BLOCK];
+  uint16_t Length = 0;
+  uint8_t i;
+
+  Put16(Buffer, WINDOW_ADDRESS);
+  Put16(Buffer + 2, 3 * BLOCK);
+  Put32(Buffer + 4, TIMESTAMP);
+  Length += BuildFrame(Frames, 0x0546, Buffer, 8);
+  for (i = 0; i < 3; i++) {
+    Put16(Buffer, WINDOW_ADDRESS + i * BLOCK);
+    Buffer[2] = BLOCK;
+    Buffer[3] = 0;
+    memcpy(Buffer + 4, pData + i * BLOCK, BLOCK);
+    Length += BuildFrame(Frames + Length, 0x0547, Buffer, 4 + BLOCK);
+    if (bDamage && i == 1) {
+      Frames[Length - 40] ^= 0x01;
+    }
+  }
+  CHECK(Length <= UART_DMA_BUFFER_SIZE);
+  Send(Frames, Length);
+  HandleCommands();
+}
+
+static void ReadWindow(uint8_t *pBuffer) {
+  uint8_t i;
+
+  for (i = 0; i < 3; i++) {
+    EEPROM_ReadBuffer(WINDOW_ADDRESS + i * BLOCK, pBuffer + i * BLOCK, BLOCK);
+  }
+}
+
+static void CheckWriteWindow(void) {
+  uint8_t Data[3 * BLOCK], Damaged[3 * BLOCK], Read[3 * BLOCK];
+  uint16_t i;
+
+  for (i = 0; i < sizeof(Data); i++) {
+    Data[i] = i * 7 + 3;
+    Damaged[i] = ~Data[i];
+  }
+
+  WriteWindow(Data, false);
+  CheckStatus(WINDOW_ADDRESS, sizeof(Data), CRC_Calculate(Data, sizeof(Data)),
+              true);
+  ReadWindow(Read);
+  CHECK(memcmp(Read, Data, sizeof(Data)) == 0);
+
+  // The damaged block fails its frame CRC and is dropped, so the block after
+  // it is out of order and the window fails after the first block.
+  WriteWindow(Damaged, true);
+  CheckStatus(WINDOW_ADDRESS, BLOCK, CRC_Calculate(Damaged, BLOCK), false);
+  ReadWindow(Read);
+  CHECK(memcmp(Read, Damaged, BLOCK) == 0);
+  CHECK(memcmp(Read + BLOCK, Data + BLOCK, 2 * BLOCK) == 0);
+}
+
+static void CheckReadWindow(void) {
+  uint8_t Frame[32], Body[256], Buffer[8], Expected[BLOCK];
+  uint16_t Offset, Size, CRC = 0;
+
+  Put16(Buffer, WINDOW_ADDRESS);
+  Put16(Buffer + 2, 1024);
+  Put32(Buffer + 4, TIMESTAMP);
+  Send(Frame, BuildFrame(Frame, 0x0542, Buffer, 8));
+  HandleCommands();
+
+  for (Offset = WINDOW_ADDRESS; Offset < WINDOW_ADDRESS + 1024;
+       Offset += BLOCK) {
+    CHECK_EQ(Receive(Body, &Size), 0x0543);
+    CHECK_EQ(Size, 4 + BLOCK);
+    CHECK_EQ(Get16(Body), Offset);
+    CHECK_EQ(Body[2], BLOCK);
+    EEPROM_ReadBuffer(Offset, Expected, BLOCK);
+    CHECK(memcmp(Body + 4, Expected, BLOCK) == 0);
+    CRC = CRC_Update(CRC, Expected, BLOCK);
+  }
+  CheckStatus(WINDOW_ADDRESS, 1024, CRC, true);
+}
+
+// The fallback counts ticks, not polls: the main loop may poll the UART
+// much more often than every 10ms.
+static void CheckIdleFallback(void) {
+  uint16_t i;
+
+  for (i = 0; i < 1000; i++) {
+    HandleCommands();
+  }
+  CHECK_EQ(HOST_UART_GetBaudRate(), 115200);
+
+  gGlobalSysTickCounter += 299;
+  HandleCommands();
+  CHECK_EQ(HOST_UART_GetBaudRate(), 115200);
+  gGlobalSysTickCounter += 1;
+  HandleCommands();
+  CHECK_EQ(HOST_UART_GetBaudRate(), UART_BAUD_DEFAULT);
+}
+
+#ifdef ENABLE_UART_CAT
+static void CheckStats(void) {
+  uint8_t Frame[32], Body[256];
+  uint16_t Size;
+
+  gIdlePercent = 87;
+  Send(Frame, BuildFrame(Frame, 0x0603, Body, 0));
+  HandleCommands();
+  CHECK_EQ(Receive(Body, &Size), 0x0603);
+  CHECK_EQ(Size, 24);
+  CHECK_EQ(Body[20], 87);
+}
+#endif
+
+int main(void) {
+  char Eeprom[] = "/tmp/uvk5-eeprom-XXXXXX";
+  char Link[] = "/tmp/uvk5-uart-XXXXXX";
+  const int File = mkstemp(Eeprom);
+  const int LinkFile = mkstemp(Link);
+
+  if (File < 0 || LinkFile < 0 || close(LinkFile) || HOST_MapPeripherals() ||
+      HOST_EEPROM_Load(Eeprom) || HOST_UART_Open(Link)) {
+    perror("setup");
+    return 1;
+  }
+  UART_Init();
+  gPc = open(Link, O_RDWR | O_NOCTTY);
+  if (gPc < 0) {
+    perror(Link);
+    return 1;
+  }
+
+  CheckHello();
+  CheckSetup();
+  CheckWriteWindow();
+  CheckReadWindow();
+  CheckIdleFallback();
+#ifdef ENABLE_UART_CAT
+  CheckStats();
+#endif
+
+  close(gPc);
+  close(File);
+  unlink(Eeprom);
+
+  return TEST_Finish("uart");
+}
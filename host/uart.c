@@ -0,0 +1,112 @@
+/* UART driver for the host build.
+ *
+ * With -u the link is a pseudo terminal whose slave side is symlinked to the
+ * given path, so the CPS and PC tools can open it like a serial port. Sent
+ * bytes are paced at 10 bits per byte at the current baud rate, as the FIFO
+ * busy-wait does on the radio. Received bytes are copied into the DMA ring
+ * from the tick handler and DMA_CH0->ST advanced like the hardware does.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "bsp/dp32g030/dma.h"
+#include "driver/uart.h"
+#include "host/host.h"
+
+uint8_t UART_DMA_Buffer[UART_DMA_BUFFER_SIZE];
+
+HOST_UART_Stats_t gHostUartStats;
+
+static int gMaster = -1;
+static int gSlave = -1;
+static const char *gLinkPath;
+static uint32_t gBaudRate = UART_BAUD_DEFAULT;
+
+static void RemoveLink(void) { unlink(gLinkPath); }
+
+int HOST_UART_Open(const char *pPath) {
+  struct termios Raw;
+
+  gMaster = posix_openpt(O_RDWR | O_NOCTTY);
+  if (gMaster < 0 || grantpt(gMaster) || unlockpt(gMaster)) {
+    return -1;
+  }
+
+  // Hold the slave open in raw mode so nothing is echoed back before a
+  // client has configured it, and writes do not fail while none is attached.
+  gSlave = open(ptsname(gMaster), O_RDWR | O_NOCTTY);
+  if (gSlave < 0 || tcgetattr(gSlave, &Raw)) {
+    return -1;
+  }
+  cfmakeraw(&Raw);
+  tcsetattr(gSlave, TCSANOW, &Raw);
+
+  unlink(pPath);
+  if (symlink(ptsname(gMaster), pPath)) {
+    return -1;
+  }
+  gLinkPath = pPath;
+  atexit(RemoveLink);
+
+  fcntl(gMaster, F_SETFL, fcntl(gMaster, F_GETFL) | O_NONBLOCK);
+
+  return 0;
+}
+
+void HOST_UART_Poll(void) {
+  uint16_t Index;
+  ssize_t Count;
+
+  if (gMaster < 0) {
+    return;
+  }
+
+  Index = DMA_CH0->ST & 0xFFFU;
+  for (;;) {
+    Count = read(gMaster, UART_DMA_Buffer + Index,
+                 sizeof(UART_DMA_Buffer) - Index);
+    if (Count <= 0) {
+      break;
+    }
+    gHostUartStats.BytesReceived += Count;
+    Index = (Index + Count) % sizeof(UART_DMA_Buffer);
+  }
+  DMA_CH0->ST = Index;
+}
+
+void UART_Init(void) {
+  gBaudRate = UART_BAUD_DEFAULT;
+  DMA_CH0->ST = 0;
+}
+
+void UART_Send(const void *pBuffer, uint32_t Size) {
+  const uint64_t End = HOST_GetTimeUs() + Size * 10000000ULL / gBaudRate;
+
+  ssize_t Written = 0;
+
+  // a full pty buffer is a PC that stopped reading; drop like the wire would
+  if (gMaster >= 0) {
+    Written = write(gMaster, pBuffer, Size);
+    if (Written < 0) {
+      Written = 0;
+    }
+    gHostUartStats.BytesDropped += Size - Written;
+  }
+  gHostUartStats.BytesSent += Size;
+
+  while (HOST_GetTimeUs() < End) {
+  }
+}
+
+void UART_SetBaudRate(uint32_t BaudRate) { gBaudRate = BaudRate; }
+
+uint32_t HOST_UART_GetBaudRate(void) { return gBaudRate; }
+
+void UART_LogSend(const void *pBuffer, uint32_t Size) {
+  (void)pBuffer;
+  (void)Size;
+}
@@ -82,6 +82,17 @@ class uvk5:
         self.CMD_0530         = b'\x30\x05' #0x0530 -> no reply //Only in bootloader
         self.CMD_0527         = b'\x27\x05'
         self.CMD_0529         = b'\x29\x05'
+
+        self.CMD_BULK_SETUP   = b'\x40\x05' #0x0540 -> 0x0541 //ENABLE_UART_BULK
+        self.CMD_BULK_READ    = b'\x42\x05' #0x0542 -> 0x0543 * n + 0x0545
+        self.CMD_BULK_WINDOW  = b'\x46\x05' #0x0546 -> (0x0545 on error)
+        self.CMD_BULK_BLOCK   = b'\x47\x05' #0x0547 -> 0x0545 after the last block
+
+        self.CMD_SPECTRUM_STREAM = b'\x10\x06' #0x0610 -> 0x0611, then 0x0612 per sweep //ENABLE_SPECTRUM
+        self.bulk_window      = 3
+        self.bulk_block       = 128
+        self.bulk_read_window = 1024
+        self.spectrum_bad_frames = 0
         
         self.debug = False if os.getenv('DEBUG') is None else True
 
@@ -252,3 +263,160 @@ class uvk5:
         reply = self.uart_receive_msg(16)
         val,a,b = struct.unpack('<HBB',reply[8:-4])
         return {'val':val, 'v1': a, 'v2': b}
+
+
+    def bulk_setup(self,baudrate=230400):
+        cmd=self.build_uart_command(self.CMD_BULK_SETUP, struct.pack('<I',baudrate) + self.sessTimestamp)
+        self.uart_send_msg(cmd)
+        reply = self.uart_receive_msg(20)
+        baudrate,window,block,read_window = struct.unpack('<IBBH',reply[8:-4])
+        self.bulk_window = window
+        self.bulk_block = block
+        self.bulk_read_window = read_window
+        self.serial.baudrate = baudrate
+        return baudrate
+
+    def bulk_status(self):
+        reply = self.uart_receive_msg(20)
+        if len(reply) != 20:
+            return 0,0,0,False
+        offset,length,crc,ok = struct.unpack('<HHHBx',reply[8:-4])
+        return offset,length,crc,bool(ok)
+
+    def bulk_retry(self,retries):
+        if retries >= 3:
+            raise Exception('Bulk transfer failed')
+        self.serial.reset_input_buffer()
+        return retries + 1
+
+    def bulk_read(self,address,length):
+        data = b''
+        retries = 0
+        while length > 0:
+            size = min(length, self.bulk_read_window)
+            cmd=self.build_uart_command(self.CMD_BULK_READ, struct.pack('<HH',address,size) + self.sessTimestamp)
+            self.uart_send_msg(cmd)
+            window = b''
+            while len(window) < size:
+                block = min(size - len(window), self.bulk_block)
+                reply = self.uart_receive_msg(block+16)
+                if len(reply) != block+16:
+                    break
+                window += reply[12:-4]
+            _,_,crc,ok = self.bulk_status()
+            if not ok or len(window) != size or crc != crc16_ccitt(window):
+                retries = self.bulk_retry(retries)
+                continue
+            retries = 0
+            data += window
+            address += size
+            length -= size
+        return data
+
+    def bulk_write(self,address,payload):
+        if len(payload)%8!=0:
+            raise Exception('Payload have to be multiples of 8 bytes')
+        window_size = self.bulk_window * self.bulk_block
+        retries = 0
+        while payload:
+            window = payload[:window_size]
+            cmd=self.build_uart_command(self.CMD_BULK_WINDOW, struct.pack('<HH',address,len(window)) + self.sessTimestamp)
+            self.uart_send_msg(cmd)
+            for i in range(0, len(window), self.bulk_block):
+                block = window[i:i+self.bulk_block]
+                cmd=self.build_uart_command(self.CMD_BULK_BLOCK, struct.pack('<HBB',address+i,len(block),0) + block)
+                self.uart_send_msg(cmd)
+            _,length,crc,ok = self.bulk_status()
+            if not ok or length != len(window) or crc != crc16_ccitt(window):
+                retries = self.bulk_retry(retries)
+                continue
+            retries = 0
+            address += len(window)
+            payload = payload[window_size:]
+        return True
+
+    def dump_eeprom(self,baudrate=230400):
+        self.bulk_setup(baudrate)
+        try:
+            return self.bulk_read(0, 0x2000)
+        finally:
+            self.bulk_setup(38400)
+
+    def restore_eeprom(self,payload,baudrate=230400):
+        self.bulk_setup(baudrate)
+        try:
+            return self.bulk_write(0, payload)
+        finally:
+            self.bulk_setup(38400)
+
+    def spectrum_stream(self,fstart=0,step=0,bins=0,dwell_us=0,delta=True,launch=True,enable=True):
+        # frequencies and step in 10 Hz, 0 keeps the radio's current setting
+        flags = (1 if enable else 0) | (2 if delta else 0) | (4 if launch else 0)
+        cmd=self.build_uart_command(self.CMD_SPECTRUM_STREAM, struct.pack('<IHHHBB',fstart,step,bins,dwell_us,flags,0))
+        self.uart_send_msg(cmd)
+        # sweep frames may already be in flight ahead of the reply
+        while True:
+            frame = self.uart_receive_frame()
+            if frame is None:
+                return None
+            if frame[0] == 0x0611:
+                fstart,step,bins,dwell_us,flags,_ = struct.unpack('<IHHHBB',frame[1][:12])
+                return {'fstart':fstart, 'step':step, 'bins':bins, 'dwell_us':dwell_us, 'flags':flags}
+
+    def uart_receive_frame(self):
+        # returns (id, body) of the next well formed frame, None on timeout
+        while True:
+            sync = self.serial.read_until(b'\xAB\xCD')
+            if not sync.endswith(b'\xAB\xCD'):
+                return None
+            size = self.serial.read(2)
+            if len(size) != 2:
+                return None
+            size, = struct.unpack('<H',size)
+            raw = self.serial.read(size + 4)
+            if len(raw) != size + 4 or raw[-2:] != b'\xDC\xBA':
+                self.spectrum_bad_frames += 1
+                continue
+            msg = payload_xor(raw[:size])
+            msg_id,msg_size = struct.unpack('<HH',msg[:4])
+            if msg_size != size - 4:
+                self.spectrum_bad_frames += 1
+                continue
+            return msg_id, msg[4:]
+
+    def spectrum_decode(self,body):
+        fstart,step,bins,sequence,ticks,crc,flags,_ = struct.unpack('<IHHHHHBB',body[:16])
+        data = body[16:]
+        if crc16_ccitt(data) != crc:
+            return None
+        if not flags & 2:
+            rssi = list(data[:bins])
+        else:
+            nibbles = []
+            for b in data:
+                nibbles += [b >> 4, b & 0xF]
+            rssi = [nibbles[0] << 4 | nibbles[1]]
+            i = 2
+            while len(rssi) < bins:
+                n = nibbles[i]
+                if n == 8:
+                    rssi.append(nibbles[i+1] << 4 | nibbles[i+2])
+                    i += 3
+                else:
+                    rssi.append((rssi[-1] + (n - 16 if n > 8 else n)) & 0xFF)
+                    i += 1
+        return {'fstart':fstart, 'step':step, 'sequence':sequence, 'ticks':ticks, 'rssi':rssi}
+
+    def spectrum_read(self):
+        # next decoded sweep, None on timeout; corrupt frames are counted
+        while True:
+            frame = self.uart_receive_frame()
+            if frame is None:
+                return None
+            if frame[0] != 0x0612:
+                continue
+            sweep = self.spectrum_decode(frame[1])
+            if sweep is None:
+                self.spectrum_bad_frames += 1
+                continue
+            return sweep
@@ -14,6 +14,7 @@
  *     limitations under the License.
  */
 
+#include "ARMCM0.h"
 #include "app/app.h"
 #include "app/dtmf.h"
 #include "audio.h"
@@ -28,6 +29,7 @@
 #include "driver/gpio.h"
 #include "driver/system.h"
 #include "driver/systick.h"
+#include "functions.h"
 #include <string.h>
 #if defined(ENABLE_UART)
 #include "driver/uart.h"
@@ -36,6 +38,7 @@
 #include "helper/boot.h"
 #include "misc.h"
 #include "radio.h"
+#include "scheduler.h"
 #include "settings.h"
 #include "ui/lock.h"
 #include "ui/menu.h"
@@ -61,6 +64,7 @@ void Main(void) {
                         SYSCON_DEV_CLK_GATE_CRC_BITS_ENABLE |
                         SYSCON_DEV_CLK_GATE_AES_BITS_ENABLE;
 
+  SCHEDULER_Init();
   SYSTICK_Init();
   BOARD_Init();
 
@@ -118,7 +122,8 @@ void Main(void) {
   }
 
   while (1) {
-    APP_Update();
+    FUNCTION_Type_t Function;
+
     if (gNextTimeslice) {
       APP_TimeSlice10ms();
       gNextTimeslice = false;
@@ -127,5 +132,17 @@ void Main(void) {
       APP_TimeSlice500ms();
       gNextTimeslice500ms = false;
     }
+
+    Function = gCurrentFunction;
+    APP_Update();
+
+    // Everything is driven by the 10ms tick and the flags set from it: sleep
+    // until then, unless this pass moved to another function, whose handler
+    // should run right away.
+    __disable_irq();
+    if (!gNextTimeslice && Function == gCurrentFunction) {
+      SYSTICK_Sleep();
+    }
+    __enable_irq();
   }
 }
@@ -40,6 +40,7 @@ uint32_t gChallenge[4];
 uint8_t gTryCount;
 
 uint16_t gEEPROM_RSSI_CALIB[7][4];
+EEPROM_Calibration_t gEEPROM_Calibration;
 
 uint16_t gEEPROM_1F8A;
 uint16_t gEEPROM_1F8C;
@@ -49,8 +50,6 @@ uint8_t gMR_ChannelAttributes[FREQ_CHANNEL_LAST + 1];
 volatile bool gNextTimeslice500ms;
 volatile uint16_t gBatterySaveCountdown = 1000;
 volatile uint16_t gDualWatchCountdown;
-volatile uint16_t gTxTimerCountdown;
-volatile uint16_t gTailNoteEliminationCountdown;
 bool gEnableSpeaker;
 uint8_t gKeyLockCountdown;
 uint8_t gRTTECountdown;
@@ -123,20 +122,22 @@ uint8_t gFSKWriteIndex;
 uint8_t gNeverUsed;
 
 volatile bool gNextTimeslice;
+uint8_t gIdlePercent;
 bool gUpdateDisplay;
 bool gF_LOCK;
 uint8_t gShowChPrefix;
-volatile uint16_t gSystickCountdown2;
-volatile uint8_t gFoundCDCSSCountdown;
-volatile uint8_t gFoundCTCSSCountdown;
-volatile uint16_t gVoxStopCountdown;
+SCHEDULER_Timer_t gFoundCDCSSTimer;
+SCHEDULER_Timer_t gFoundCTCSSTimer;
+SCHEDULER_Timer_t gVoxStopTimer;
 volatile bool gTxTimeoutReached;
+SCHEDULER_Timer_t gTxTimer = {.pFlag = &gTxTimeoutReached};
 volatile bool gNextTimeslice40ms;
 volatile bool gSchedulePowerSave;
 volatile bool gBatterySaveCountdownExpired;
 volatile bool gScheduleDualWatch = true;
 uint8_t gAbrTxRx;
 volatile bool gFlagTteComplete;
+SCHEDULER_Timer_t gTailNoteEliminationTimer = {.pFlag = &gFlagTteComplete};
 #if defined(ENABLE_FMRADIO)
 volatile bool gScheduleFM;
 #endif
@@ -17,6 +17,7 @@
 #ifndef MISC_H
 #define MISC_H
 
+#include "scheduler.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -86,7 +87,18 @@ extern bool bHasCustomAesKey;
 extern uint32_t gChallenge[4];
 extern uint8_t gTryCount;
 
+// Squelch and TX power calibration (0x1E00-0x1F3F) in EEPROM layout
+typedef struct {
+  // [0] bands from 174 MHz up (0x1E00), [1] below (0x1E60); open RSSI,
+  // close RSSI, open noise, close noise, close glitch, open glitch; level 1-9
+  uint8_t Squelch[2][6][9];
+  // low/mid/high power triples of each band (0x1ED0), plus the row's unused
+  // fourth triple an out-of-range OUTPUT_POWER used to read
+  uint8_t TxPower[7][4][3];
+} EEPROM_Calibration_t;
+
 extern uint16_t gEEPROM_RSSI_CALIB[7][4];
+extern EEPROM_Calibration_t gEEPROM_Calibration;
 
 extern uint16_t gEEPROM_1F8A;
 extern uint16_t gEEPROM_1F8C;
@@ -96,8 +108,6 @@ extern uint8_t gMR_ChannelAttributes[207];
 extern volatile bool gNextTimeslice500ms;
 extern volatile uint16_t gBatterySaveCountdown;
 extern volatile uint16_t gDualWatchCountdown;
-extern volatile uint16_t gTxTimerCountdown;
-extern volatile uint16_t gTailNoteEliminationCountdown;
 extern volatile uint16_t gFmPlayCountdown;
 extern bool gEnableSpeaker;
 extern uint8_t gKeyLockCountdown;
@@ -169,19 +179,23 @@ extern uint8_t gFSKWriteIndex;
 extern uint8_t gNeverUsed;
 
 extern volatile bool gNextTimeslice;
+extern volatile uint32_t gGlobalSysTickCounter;
+// share of the last 500ms the main loop spent asleep
+extern uint8_t gIdlePercent;
 extern bool gUpdateDisplay;
 extern bool gF_LOCK;
 extern uint8_t gShowChPrefix;
-extern volatile uint16_t gSystickCountdown2;
-extern volatile uint8_t gFoundCDCSSCountdown;
-extern volatile uint8_t gFoundCTCSSCountdown;
-extern volatile uint16_t gVoxStopCountdown;
+extern SCHEDULER_Timer_t gFoundCDCSSTimer;
+extern SCHEDULER_Timer_t gFoundCTCSSTimer;
+extern SCHEDULER_Timer_t gVoxStopTimer;
 extern volatile bool gTxTimeoutReached;
+extern SCHEDULER_Timer_t gTxTimer;
 extern volatile bool gNextTimeslice40ms;
 extern volatile bool gSchedulePowerSave;
 extern volatile bool gBatterySaveCountdownExpired;
 extern volatile bool gScheduleDualWatch;
 extern volatile bool gFlagTteComplete;
+extern SCHEDULER_Timer_t gTailNoteEliminationTimer;
 #if defined(ENABLE_FMRADIO)
 extern volatile bool gScheduleFM;
 #endif
@@ -55,6 +55,34 @@ const char *powerNames[] = {"LOW", "MID", "HIGH"};
 const char *bwNames[3] = {"  25k", "12.5k", "6.25k"};
 const char *deviationNames[] = {"", "+", "-"};
 
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+// What a memory scan hop needs from one channel, packed so that a full
+// 200-channel list stays in RAM. Filled through RADIO_ConfigureChannel, so
+// the EEPROM parsing and calibration rules are the usual ones.
+typedef struct {
+  uint32_t Frequency : 28;
+  uint32_t OffsetDir : 2;
+  uint32_t OutputPower : 2;
+  uint8_t Code;
+  uint8_t CodeType : 2;
+  uint8_t Bandwidth : 2;
+  uint8_t Scrambler : 4;
+  uint8_t Modulation : 3;
+  uint8_t DtmfDecode : 1;
+  uint8_t HighBand : 1;
+  uint8_t Valid : 1;
+} ScanImage_t;
+
+static ScanImage_t gScanImages[MR_CHANNEL_LAST + 1];
+// Squelch thresholds only depend on which calibration half the band uses
+static uint8_t gScanSquelch[2][6];
+static uint8_t gScanImageList = 0xFF;
+// Image whose registers are on the chip, NULL after a full register setup
+static const ScanImage_t *gScanApplied;
+// VFO loaded from an image and still lacking its name, offset and TX side
+static uint8_t gScanPartialVfo = 0xFF;
+#endif
+
 bool RADIO_CheckValidChannel(uint16_t Channel, bool bCheckScanList,
                              uint8_t VFO) {
   uint8_t Attributes;
@@ -152,6 +180,11 @@ void RADIO_ConfigureChannel(uint8_t VFO, uint32_t Arg) {
   uint32_t Frequency;
 
   pRadio = &gEeprom.VfoInfo[VFO];
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+  if (VFO == gScanPartialVfo) {
+    gScanPartialVfo = 0xFF;
+  }
+#endif
 
   Channel = gEeprom.ScreenChannel[VFO];
   if (IS_VALID_CHANNEL(Channel)) {
@@ -208,7 +241,7 @@ void RADIO_ConfigureChannel(uint8_t VFO, uint32_t Arg) {
   }
 
   if (Arg == 2 || Channel >= FREQ_CHANNEL_FIRST) {
-    EEPROM_ReadBuffer(Base + 8, Data, 8);
+    SETTINGS_ReadChannel(Channel, Base + 8, Data, 8);
 
     Tmp = Data[3] & 0x0F;
     if (Tmp > 2) {
@@ -296,7 +329,7 @@ void RADIO_ConfigureChannel(uint8_t VFO, uint32_t Arg) {
       uint32_t Offset;
     } Info;
 
-    EEPROM_ReadBuffer(Base, &Info, 8);
+    SETTINGS_ReadChannel(Channel, Base, &Info, 8);
 
     pRadio->ConfigRX.Frequency = Info.Frequency;
     if (Info.Offset >= 100000000) {
@@ -355,16 +388,12 @@ void RADIO_ConfigureChannel(uint8_t VFO, uint32_t Arg) {
 }
 
 void RADIO_ConfigureSquelchAndOutputPower(VFO_Info_t *pInfo) {
-  uint8_t Txp[3];
-  uint16_t Base;
+  const uint8_t (*pSquelch)[9];
+  const uint8_t *Txp;
   FREQUENCY_Band_t Band;
 
   Band = FREQUENCY_GetBand(pInfo->pRX->Frequency);
-  if (Band < BAND4_174MHz) {
-    Base = 0x1E60;
-  } else {
-    Base = 0x1E00;
-  }
+  pSquelch = gEEPROM_Calibration.Squelch[Band < BAND4_174MHz];
 
   if (gEeprom.SQUELCH_LEVEL == 0) {
     pInfo->SquelchOpenRSSIThresh = 0x00;
@@ -374,13 +403,14 @@ void RADIO_ConfigureSquelchAndOutputPower(VFO_Info_t *pInfo) {
     pInfo->SquelchCloseNoiseThresh = 0x7F;
     pInfo->SquelchOpenGlitchThresh = 0xFF;
   } else {
-    Base += gEeprom.SQUELCH_LEVEL;
-    EEPROM_ReadBuffer(Base + 0x00, &pInfo->SquelchOpenRSSIThresh, 1);
-    EEPROM_ReadBuffer(Base + 0x10, &pInfo->SquelchCloseRSSIThresh, 1);
-    EEPROM_ReadBuffer(Base + 0x20, &pInfo->SquelchOpenNoiseThresh, 1);
-    EEPROM_ReadBuffer(Base + 0x30, &pInfo->SquelchCloseNoiseThresh, 1);
-    EEPROM_ReadBuffer(Base + 0x40, &pInfo->SquelchCloseGlitchThresh, 1);
-    EEPROM_ReadBuffer(Base + 0x50, &pInfo->SquelchOpenGlitchThresh, 1);
+    const uint8_t Level = gEeprom.SQUELCH_LEVEL - 1;
+
+    pInfo->SquelchOpenRSSIThresh = pSquelch[0][Level];
+    pInfo->SquelchCloseRSSIThresh = pSquelch[1][Level];
+    pInfo->SquelchOpenNoiseThresh = pSquelch[2][Level];
+    pInfo->SquelchCloseNoiseThresh = pSquelch[3][Level];
+    pInfo->SquelchCloseGlitchThresh = pSquelch[4][Level];
+    pInfo->SquelchOpenGlitchThresh = pSquelch[5][Level];
 
     if (pInfo->SquelchOpenNoiseThresh >= 0x80) {
       pInfo->SquelchOpenNoiseThresh = 0x7F;
@@ -391,7 +421,7 @@ void RADIO_ConfigureSquelchAndOutputPower(VFO_Info_t *pInfo) {
   }
 
   Band = FREQUENCY_GetBand(pInfo->pTX->Frequency);
-  EEPROM_ReadBuffer(0x1ED0 + (Band * 0x10) + (pInfo->OUTPUT_POWER * 3), Txp, 3);
+  Txp = gEEPROM_Calibration.TxPower[Band][pInfo->OUTPUT_POWER];
   pInfo->TXP_CalculatedSetting = FREQUENCY_CalculateOutputPower(
       Txp[0], Txp[1], Txp[2], FrequencyBandTable[Band].lower,
       (FrequencyBandTable[Band].upper - FrequencyBandTable[Band].lower) / 2,
@@ -453,46 +483,33 @@ void RADIO_SelectVfos(void) {
 }
 
 void RADIO_SetupRegisters(bool bSwitchToFunction0) {
-  BK4819_FilterBandwidth_t Bandwidth;
-  uint16_t Status;
-  uint16_t InterruptMask;
-  uint32_t Frequency;
+  BK4819_RxSetup_t Setup;
 
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+  gScanApplied = NULL;
+#endif
   GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
   gEnableSpeaker = false;
-  BK4819_ToggleGpioOut(BK4819_GPIO0_PIN28_GREEN, false);
 
-  Bandwidth = gRxVfo->CHANNEL_BANDWIDTH;
-  if (Bandwidth != BK4819_FILTER_BW_WIDE) {
-    Bandwidth = BK4819_FILTER_BW_NARROW;
-  }
-  BK4819_SetFilterBandwidth(Bandwidth);
-
-  BK4819_ToggleGpioOut(BK4819_GPIO5_PIN1_RED, false);
-  BK4819_SetupPowerAmplifier(0, 0);
-  BK4819_ToggleGpioOut(BK4819_GPIO1_PIN29_PA_ENABLE, false);
-
-  while (1) {
-    Status = BK4819_ReadRegister(BK4819_REG_0C);
-    if ((Status & 1U) == 0) { // INTERRUPT REQUEST
-      break;
-    }
-    BK4819_WriteRegister(BK4819_REG_02, 0);
-    SYSTEM_DelayMs(1);
-  }
-  BK4819_WriteRegister(BK4819_REG_3F, 0);
-  BK4819_WriteRegister(BK4819_REG_7D, gEeprom.MIC_SENSITIVITY_TUNING | 0xE94F);
-  Frequency = gRxVfo->pRX->Frequency;
-  BK4819_SetFrequency(Frequency);
-  BK4819_SetupSquelch(
-      gRxVfo->SquelchOpenRSSIThresh, gRxVfo->SquelchCloseRSSIThresh,
-      gRxVfo->SquelchOpenNoiseThresh, gRxVfo->SquelchCloseNoiseThresh,
-      gRxVfo->SquelchCloseGlitchThresh, gRxVfo->SquelchOpenGlitchThresh);
-  BK4819_SelectFilter(Frequency);
-  BK4819_ToggleGpioOut(BK4819_GPIO0_PIN28_RX_ENABLE, true);
-  BK4819_WriteRegister(BK4819_REG_48, 0xB3A8);
-
-  InterruptMask = 0 | BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
+  Setup.Frequency = gRxVfo->pRX->Frequency;
+  Setup.Bandwidth = gRxVfo->CHANNEL_BANDWIDTH;
+  if (Setup.Bandwidth != BK4819_FILTER_BW_WIDE) {
+    Setup.Bandwidth = BK4819_FILTER_BW_NARROW;
+  }
+  Setup.SquelchOpenRSSIThresh = gRxVfo->SquelchOpenRSSIThresh;
+  Setup.SquelchCloseRSSIThresh = gRxVfo->SquelchCloseRSSIThresh;
+  Setup.SquelchOpenNoiseThresh = gRxVfo->SquelchOpenNoiseThresh;
+  Setup.SquelchCloseNoiseThresh = gRxVfo->SquelchCloseNoiseThresh;
+  Setup.SquelchCloseGlitchThresh = gRxVfo->SquelchCloseGlitchThresh;
+  Setup.SquelchOpenGlitchThresh = gRxVfo->SquelchOpenGlitchThresh;
+  Setup.MicSensitivityTuning = gEeprom.MIC_SENSITIVITY_TUNING;
+  Setup.SubAudio = BK4819_SUBAUDIO_KEEP;
+  Setup.CtcssFrequency = 0;
+  Setup.bTail55Hz = false;
+  Setup.CdcssCodeWord = 0;
+  Setup.Scrambler = BK4819_SCRAMBLE_KEEP;
+  Setup.InterruptMask =
+      0 | BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
 
   if (IS_NOT_NOAA_CHANNEL(gRxVfo->CHANNEL_SAVE)) {
     if (!gRxVfo->ModulationType) {
@@ -508,60 +525,62 @@ void RADIO_SetupRegisters(bool bSwitchToFunction0) {
       switch (CodeType) {
       case CODE_TYPE_DIGITAL:
       case CODE_TYPE_REVERSE_DIGITAL:
-        BK4819_SetCDCSSCodeWord(DCS_GetGolayCodeWord(CodeType, Code));
-        InterruptMask = 0 | BK4819_REG_3F_CxCSS_TAIL |
-                        BK4819_REG_3F_CDCSS_FOUND | BK4819_REG_3F_CDCSS_LOST |
-                        BK4819_REG_3F_SQUELCH_FOUND |
-                        BK4819_REG_3F_SQUELCH_LOST;
+        Setup.SubAudio = BK4819_SUBAUDIO_CDCSS;
+        Setup.CdcssCodeWord = DCS_GetGolayCodeWord(CodeType, Code);
+        Setup.InterruptMask = 0 | BK4819_REG_3F_CxCSS_TAIL |
+                              BK4819_REG_3F_CDCSS_FOUND |
+                              BK4819_REG_3F_CDCSS_LOST |
+                              BK4819_REG_3F_SQUELCH_FOUND |
+                              BK4819_REG_3F_SQUELCH_LOST;
         break;
       case CODE_TYPE_CONTINUOUS_TONE:
-        BK4819_SetCTCSSFrequency(CTCSS_Options[Code]);
-        BK4819_Set55HzTailDetection();
-        InterruptMask = 0 | BK4819_REG_3F_CxCSS_TAIL |
-                        BK4819_REG_3F_CTCSS_FOUND | BK4819_REG_3F_CTCSS_LOST |
-                        BK4819_REG_3F_SQUELCH_FOUND |
-                        BK4819_REG_3F_SQUELCH_LOST;
+        Setup.SubAudio = BK4819_SUBAUDIO_CTCSS;
+        Setup.CtcssFrequency = CTCSS_Options[Code];
+        Setup.bTail55Hz = true;
+        Setup.InterruptMask = 0 | BK4819_REG_3F_CxCSS_TAIL |
+                              BK4819_REG_3F_CTCSS_FOUND |
+                              BK4819_REG_3F_CTCSS_LOST |
+                              BK4819_REG_3F_SQUELCH_FOUND |
+                              BK4819_REG_3F_SQUELCH_LOST;
         break;
       default:
-        BK4819_SetCTCSSFrequency(670);
-        BK4819_Set55HzTailDetection();
-        InterruptMask = 0 | BK4819_REG_3F_CxCSS_TAIL |
-                        BK4819_REG_3F_SQUELCH_FOUND |
-                        BK4819_REG_3F_SQUELCH_LOST;
+        Setup.SubAudio = BK4819_SUBAUDIO_CTCSS;
+        Setup.CtcssFrequency = 670;
+        Setup.bTail55Hz = true;
+        Setup.InterruptMask = 0 | BK4819_REG_3F_CxCSS_TAIL |
+                              BK4819_REG_3F_SQUELCH_FOUND |
+                              BK4819_REG_3F_SQUELCH_LOST;
         break;
       }
-      if (gRxVfo->SCRAMBLING_TYPE == 0 || !gSetting_ScrambleEnable) {
-        BK4819_DisableScramble();
-      } else {
-        BK4819_EnableScramble(gRxVfo->SCRAMBLING_TYPE - 1);
-      }
+      Setup.Scrambler = gSetting_ScrambleEnable ? gRxVfo->SCRAMBLING_TYPE : 0;
     }
   } else {
-    BK4819_SetCTCSSFrequency(2625);
-    InterruptMask = 0 | BK4819_REG_3F_CTCSS_FOUND | BK4819_REG_3F_CTCSS_LOST |
-                    BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
+    Setup.SubAudio = BK4819_SUBAUDIO_CTCSS;
+    Setup.CtcssFrequency = 2625;
+    Setup.InterruptMask =
+        0 | BK4819_REG_3F_CTCSS_FOUND | BK4819_REG_3F_CTCSS_LOST |
+        BK4819_REG_3F_SQUELCH_FOUND | BK4819_REG_3F_SQUELCH_LOST;
   }
 
-  if (gEeprom.VOX_SWITCH
+  Setup.bVox = gEeprom.VOX_SWITCH
 #if defined(ENABLE_FMRADIO)
-      && !gFmRadioMode
+               && !gFmRadioMode
 #endif
-      && IS_NOT_NOAA_CHANNEL(gCurrentVfo->CHANNEL_SAVE) &&
-      !gCurrentVfo->ModulationType) {
-    BK4819_EnableVox(gEeprom.VOX1_THRESHOLD, gEeprom.VOX0_THRESHOLD);
-    InterruptMask |= 0 | BK4819_REG_3F_VOX_FOUND | BK4819_REG_3F_VOX_LOST;
-  } else {
-    BK4819_DisableVox();
+               && IS_NOT_NOAA_CHANNEL(gCurrentVfo->CHANNEL_SAVE) &&
+               !gCurrentVfo->ModulationType;
+  Setup.Vox1Threshold = gEeprom.VOX1_THRESHOLD;
+  Setup.Vox0Threshold = gEeprom.VOX0_THRESHOLD;
+  if (Setup.bVox) {
+    Setup.InterruptMask |=
+        0 | BK4819_REG_3F_VOX_FOUND | BK4819_REG_3F_VOX_LOST;
   }
-  if (gRxVfo->ModulationType || !gRxVfo->DTMF_DECODING_ENABLE) {
-    BK4819_DisableDTMF();
-  } else {
-    BK4819_EnableDTMF();
-    InterruptMask |= BK4819_REG_3F_DTMF_5TONE_FOUND;
+  Setup.bDtmf = !gRxVfo->ModulationType && gRxVfo->DTMF_DECODING_ENABLE;
+  if (Setup.bDtmf) {
+    Setup.InterruptMask |= BK4819_REG_3F_DTMF_5TONE_FOUND;
   }
-  BK4819_WriteRegister(BK4819_REG_3F, InterruptMask);
-  BK4819_WriteRegister(0x40, (BK4819_ReadRegister(0x40) & ~(0b11111111111)) |
-                                 0b10110101010);
+
+  BK4819_ClearInterrupts();
+  BK4819_SetupRx(&Setup);
 
   FUNCTION_Init();
 
@@ -570,6 +589,152 @@ void RADIO_SetupRegisters(bool bSwitchToFunction0) {
   }
 }
 
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+static BK4819_FilterBandwidth_t ScanFilterBandwidth(const ScanImage_t *pImage) {
+  return pImage->Bandwidth == BK4819_FILTER_BW_WIDE ? BK4819_FILTER_BW_WIDE
+                                                    : BK4819_FILTER_BW_NARROW;
+}
+
+void RADIO_PrepareScanImages(uint8_t ScanList) {
+  if (gScanImageList == ScanList) {
+    return;
+  }
+  memset(gScanImages, 0, sizeof(gScanImages));
+  gScanImageList = ScanList;
+  gScanApplied = NULL;
+}
+
+// Keeps what the next hop to the channel just configured on pInfo needs
+static void FillScanImage(ScanImage_t *pImage, const VFO_Info_t *pInfo) {
+  uint8_t *pSquelch;
+
+  pImage->Frequency = pInfo->pRX->Frequency;
+  pImage->OffsetDir = pInfo->OFFSET_DIR;
+  pImage->OutputPower = pInfo->OUTPUT_POWER;
+  pImage->Code = pInfo->pRX->Code;
+  pImage->CodeType = pInfo->pRX->CodeType;
+  pImage->Bandwidth = pInfo->CHANNEL_BANDWIDTH;
+  pImage->Scrambler = pInfo->SCRAMBLING_TYPE;
+  pImage->Modulation = pInfo->ModulationType;
+  pImage->DtmfDecode = pInfo->DTMF_DECODING_ENABLE;
+  pImage->HighBand = FREQUENCY_GetBand(pImage->Frequency) >= BAND4_174MHz;
+  pImage->Valid = true;
+
+  pSquelch = gScanSquelch[pImage->HighBand];
+  pSquelch[0] = pInfo->SquelchOpenRSSIThresh;
+  pSquelch[1] = pInfo->SquelchCloseRSSIThresh;
+  pSquelch[2] = pInfo->SquelchOpenNoiseThresh;
+  pSquelch[3] = pInfo->SquelchCloseNoiseThresh;
+  pSquelch[4] = pInfo->SquelchCloseGlitchThresh;
+  pSquelch[5] = pInfo->SquelchOpenGlitchThresh;
+}
+
+static void LoadScanImage(VFO_Info_t *pInfo, uint8_t Channel,
+                          const ScanImage_t *pImage) {
+  const uint8_t *pSquelch = gScanSquelch[pImage->HighBand];
+
+  pInfo->CHANNEL_SAVE = Channel;
+  pInfo->Band = FREQUENCY_GetBand(pImage->Frequency);
+  pInfo->FrequencyReverse = false;
+  pInfo->pRX = &pInfo->ConfigRX;
+  pInfo->pTX = &pInfo->ConfigTX;
+  pInfo->ConfigRX.Frequency = pImage->Frequency;
+  pInfo->ConfigRX.CodeType = pImage->CodeType;
+  pInfo->ConfigRX.Code = pImage->Code;
+  pInfo->OFFSET_DIR = pImage->OffsetDir;
+  pInfo->OUTPUT_POWER = pImage->OutputPower;
+  pInfo->CHANNEL_BANDWIDTH = pImage->Bandwidth;
+  pInfo->SCRAMBLING_TYPE = pImage->Scrambler;
+  pInfo->AM_CHANNEL_MODE = pImage->Modulation;
+  pInfo->ModulationType = pImage->Modulation;
+  pInfo->DTMF_DECODING_ENABLE = pImage->DtmfDecode;
+  pInfo->SquelchOpenRSSIThresh = pSquelch[0];
+  pInfo->SquelchCloseRSSIThresh = pSquelch[1];
+  pInfo->SquelchOpenNoiseThresh = pSquelch[2];
+  pInfo->SquelchCloseNoiseThresh = pSquelch[3];
+  pInfo->SquelchCloseGlitchThresh = pSquelch[4];
+  pInfo->SquelchOpenGlitchThresh = pSquelch[5];
+  memset(pInfo->Name, 0, sizeof(pInfo->Name));
+}
+
+void RADIO_TuneScanChannel(uint8_t Channel) {
+  const uint8_t VFO = gEeprom.RX_VFO;
+  ScanImage_t *pImage = &gScanImages[Channel];
+  const ScanImage_t *pPrevious = gScanApplied;
+
+  if (gScanImageList == 0xFF) {
+    RADIO_ConfigureChannel(VFO, 2);
+    RADIO_SetupRegisters(true);
+    return;
+  }
+
+  // The first visit of each channel reads it from the EEPROM as usual and
+  // keeps its image, so the scan starts without reading the whole list.
+  if (!pImage->Valid) {
+    RADIO_ConfigureChannel(VFO, 2);
+    FillScanImage(pImage, &gEeprom.VfoInfo[VFO]);
+    RADIO_SetupRegisters(true);
+    gScanApplied = pImage;
+    return;
+  }
+
+  LoadScanImage(&gEeprom.VfoInfo[VFO], Channel, pImage);
+  gScanPartialVfo = VFO;
+
+  // Anything that changes the interrupt mask or the audio path setup goes
+  // through the full register setup.
+  if (pPrevious == NULL || gCurrentFunction != FUNCTION_FOREGROUND ||
+      pPrevious->Modulation != pImage->Modulation ||
+      pPrevious->CodeType != pImage->CodeType ||
+      pPrevious->Scrambler != pImage->Scrambler ||
+      pPrevious->DtmfDecode != pImage->DtmfDecode) {
+    RADIO_SetupRegisters(true);
+    gScanApplied = pImage;
+    return;
+  }
+
+  if (ScanFilterBandwidth(pPrevious) != ScanFilterBandwidth(pImage)) {
+    BK4819_SetFilterBandwidth(ScanFilterBandwidth(pImage));
+  }
+  BK4819_TuneTo(pImage->Frequency, false);
+  if (pPrevious->HighBand != pImage->HighBand) {
+    const uint8_t *pSquelch = gScanSquelch[pImage->HighBand];
+
+    BK4819_SetupSquelch(pSquelch[0], pSquelch[1], pSquelch[2], pSquelch[3],
+                        pSquelch[4], pSquelch[5]);
+  }
+  if (pPrevious->Code != pImage->Code && !pImage->Modulation) {
+    switch (pImage->CodeType) {
+    case CODE_TYPE_DIGITAL:
+    case CODE_TYPE_REVERSE_DIGITAL:
+      BK4819_SetCDCSSCodeWord(
+          DCS_GetGolayCodeWord(pImage->CodeType, pImage->Code));
+      break;
+    case CODE_TYPE_CONTINUOUS_TONE:
+      BK4819_SetCTCSSFrequency(CTCSS_Options[pImage->Code]);
+      break;
+    default:
+      break;
+    }
+  }
+  BK4819_ClearInterrupts();
+  FUNCTION_Init();
+  gScanApplied = pImage;
+}
+
+void RADIO_CompleteScanChannel(void) {
+  if (gScanPartialVfo != 0xFF) {
+    RADIO_ConfigureChannel(gScanPartialVfo, 2);
+  }
+}
+
+void RADIO_DropScanImages(void) {
+  RADIO_CompleteScanChannel();
+  gScanImageList = 0xFF;
+  gScanApplied = NULL;
+}
+#endif
+
 void RADIO_enableTX(void) {
   BK4819_FilterBandwidth_t Bandwidth;
 
@@ -698,15 +863,14 @@ Skip:
     }
   }
   FUNCTION_Select(FUNCTION_TRANSMIT);
+  SCHEDULER_Cancel(&gTxTimer);
 #if defined(ENABLE_TX1750)
-  if (gAlarmState == ALARM_STATE_OFF) {
-    gTxTimerCountdown = gEeprom.TX_TIMEOUT_TIMER * 120;
-  } else {
-    gTxTimerCountdown = 0;
-  }
+  if (gAlarmState == ALARM_STATE_OFF && gEeprom.TX_TIMEOUT_TIMER) {
 #else
-  gTxTimerCountdown = gEeprom.TX_TIMEOUT_TIMER * 120;
+  if (gEeprom.TX_TIMEOUT_TIMER) {
 #endif
+    SCHEDULER_Arm(&gTxTimer, gEeprom.TX_TIMEOUT_TIMER * 60 * 100);
+  }
   gTxTimeoutReached = false;
   gFlagEndTransmission = false;
   gRTTECountdown = 0;
@@ -736,27 +900,30 @@ void RADIO_PrepareCssTX(void) {
   RADIO_SetupRegisters(true);
 }
 
-void RADIO_SendEndOfTransmission(void) {
-  if (gEeprom.ROGER == ROGER_MODE_ROGER) {
-    BK4819_PlayRoger();
-  } else if (gEeprom.ROGER == ROGER_MODE_MDC) {
-    BK4819_PlayRogerMDC();
-  }
+static void (*gEndOfTransmissionDone)(void);
+
+static void RADIO_SendEndOfTransmissionTail(void) {
+  void (*pDone)(void) = gEndOfTransmissionDone;
+
+  gEndOfTransmissionDone = NULL;
   if (gDTMF_CallState == DTMF_CALL_STATE_NONE &&
       (gCurrentVfo->DTMF_PTT_ID_TX_MODE == PTT_ID_EOT ||
        gCurrentVfo->DTMF_PTT_ID_TX_MODE == PTT_ID_BOTH)) {
-    if (gEeprom.DTMF_SIDE_TONE) {
-      GPIO_SetBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-      gEnableSpeaker = true;
-      SYSTEM_DelayMs(60);
-    }
-    BK4819_EnterDTMF_TX(gEeprom.DTMF_SIDE_TONE);
-    BK4819_PlayDTMFString(
-        gEeprom.DTMF_DOWN_CODE, 0, gEeprom.DTMF_FIRST_CODE_PERSIST_TIME,
-        gEeprom.DTMF_HASH_CODE_PERSIST_TIME, gEeprom.DTMF_CODE_PERSIST_TIME,
-        gEeprom.DTMF_CODE_INTERVAL_TIME);
-    GPIO_ClearBit(&GPIOC->DATA, GPIOC_PIN_AUDIO_PATH);
-    gEnableSpeaker = false;
+    AUDIO_PlayDTMF(gEeprom.DTMF_DOWN_CODE, gEeprom.DTMF_SIDE_TONE ? 60 : 0,
+                   false, true, pDone);
+    return;
   }
   BK4819_ExitDTMF_TX(true);
+  if (pDone) {
+    pDone();
+  }
+}
+
+void RADIO_SendEndOfTransmission(void (*pDone)(void)) {
+  gEndOfTransmissionDone = pDone;
+  if (gEeprom.ROGER == ROGER_MODE_OFF) {
+    RADIO_SendEndOfTransmissionTail();
+  } else {
+    AUDIO_PlayRoger(gEeprom.ROGER, RADIO_SendEndOfTransmissionTail);
+  }
 }
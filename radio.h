@@ -160,6 +160,17 @@ uint32_t GetOffsetedF(VFO_Info_t *pInfo, uint32_t f);
 void RADIO_ApplyOffset(VFO_Info_t *pInfo);
 void RADIO_SelectVfos(void);
 void RADIO_SetupRegisters(bool bSwitchToFunction0);
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+// Starts a memory scan of ScanList with no register images; each channel's
+// image is kept on its first hop.
+void RADIO_PrepareScanImages(uint8_t ScanList);
+// Hops the RX VFO to Channel, writing only what differs from the channel
+// tuned before. Channels without an image take the full configure path.
+void RADIO_TuneScanChannel(uint8_t Channel);
+// Loads the rest of a channel tuned from its image (name, offset, TX side).
+void RADIO_CompleteScanChannel(void);
+void RADIO_DropScanImages(void);
+#endif
 void RADIO_enableTX(void);
 void RADIO_disableTX(void);
 
@@ -167,6 +178,8 @@ void RADIO_SetVfoState(VfoState_t State);
 void RADIO_PrepareTX(void);
 void RADIO_EnableCxCSS(void);
 void RADIO_PrepareCssTX(void);
-void RADIO_SendEndOfTransmission(void);
+// Keeps transmitting until the roger tone and EOT ID have been sent, then
+// calls pDone.
+void RADIO_SendEndOfTransmission(void (*pDone)(void));
 
 #endif
@@ -14,15 +14,19 @@
  *     limitations under the License.
  */
 
+#include "ARMCM0.h"
 #if defined(ENABLE_FMRADIO)
 #include "app/fm.h"
 #endif
 #include "app/scanner.h"
 #include "audio.h"
+#include "driver/systick.h"
 #include "functions.h"
 #include "helper/battery.h"
 #include "misc.h"
+#include "scheduler.h"
 #include "settings.h"
+#include <stddef.h>
 
 #define DECREMENT_AND_TRIGGER(cnt, flag)                                       \
   do {                                                                         \
@@ -33,29 +37,179 @@
     }                                                                          \
   } while (0)
 
-static volatile uint32_t gGlobalSysTickCounter;
+// Three levels of 16 slots covering 16, 256 and 4096 ticks. A timer sits in
+// the slot of its expiry on the lowest level whose span covers the delay and
+// is moved down when the tick enters that slot; longer delays wait in the top
+// level and are placed again on every lap.
+#define WHEEL_BITS 4
+#define WHEEL_SLOTS (1U << WHEEL_BITS)
+#define WHEEL_LEVELS 3
+#define WHEEL_SPAN(level) (1UL << (WHEEL_BITS * ((level) + 1)))
+
+volatile uint32_t gGlobalSysTickCounter;
+
+uint32_t gSystickIsrCycles;
+uint32_t gSystickIsrCyclesMax;
+
+static void (*gSubtickHandler)(void);
+static uint16_t gSubtickPeriodUs;
+static uint16_t gSubtickUs;
+
+static SCHEDULER_Timer_t *gWheel[WHEEL_LEVELS][WHEEL_SLOTS];
+
+static SCHEDULER_Timer_t gTimeslice40msTimer = {
+    .Period = 4,
+    .pFlag = &gNextTimeslice40ms,
+};
+static SCHEDULER_Timer_t gTimeslice500msTimer = {
+    .Period = 50,
+    .pFlag = &gNextTimeslice500ms,
+};
+
+static void Link(SCHEDULER_Timer_t *pTimer) {
+  uint32_t Delta = pTimer->Expiry - gGlobalSysTickCounter;
+  SCHEDULER_Timer_t **ppSlot;
+  uint8_t Level;
+
+  for (Level = 0; Level < WHEEL_LEVELS - 1; Level++) {
+    if (Delta < WHEEL_SPAN(Level)) {
+      break;
+    }
+  }
+  if (Delta >= WHEEL_SPAN(Level)) {
+    Delta = WHEEL_SPAN(Level) - 1;
+  }
+
+  ppSlot = &gWheel[Level][((gGlobalSysTickCounter + Delta) >>
+                           (WHEEL_BITS * Level)) &
+                          (WHEEL_SLOTS - 1)];
+  pTimer->pNext = *ppSlot;
+  if (pTimer->pNext) {
+    pTimer->pNext->ppPrev = &pTimer->pNext;
+  }
+  pTimer->ppPrev = ppSlot;
+  *ppSlot = pTimer;
+}
+
+static void Unlink(SCHEDULER_Timer_t *pTimer) {
+  *pTimer->ppPrev = pTimer->pNext;
+  if (pTimer->pNext) {
+    pTimer->pNext->ppPrev = pTimer->ppPrev;
+  }
+  pTimer->ppPrev = NULL;
+}
+
+static void Cascade(uint8_t Level) {
+  SCHEDULER_Timer_t **ppSlot =
+      &gWheel[Level][(gGlobalSysTickCounter >> (WHEEL_BITS * Level)) &
+                     (WHEEL_SLOTS - 1)];
+  SCHEDULER_Timer_t *pTimer;
+
+  while ((pTimer = *ppSlot) != NULL) {
+    Unlink(pTimer);
+    Link(pTimer);
+  }
+}
+
+static void Expire(void) {
+  SCHEDULER_Timer_t **ppSlot =
+      &gWheel[0][gGlobalSysTickCounter & (WHEEL_SLOTS - 1)];
+  SCHEDULER_Timer_t *pTimer;
+
+  while ((pTimer = *ppSlot) != NULL) {
+    Unlink(pTimer);
+    if (pTimer->Expiry != gGlobalSysTickCounter) {
+      Link(pTimer);
+      continue;
+    }
+    if (pTimer->Period) {
+      pTimer->Expiry += pTimer->Period;
+      Link(pTimer);
+    }
+    if (pTimer->pFlag) {
+      *pTimer->pFlag = true;
+    }
+    if (pTimer->pCallback) {
+      pTimer->pCallback();
+    }
+  }
+}
+
+void SCHEDULER_Init(void) {
+  SCHEDULER_Arm(&gTimeslice40msTimer, gTimeslice40msTimer.Period);
+  SCHEDULER_Arm(&gTimeslice500msTimer, gTimeslice500msTimer.Period);
+}
+
+void SCHEDULER_Arm(SCHEDULER_Timer_t *pTimer, uint32_t Ticks) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  if (pTimer->ppPrev) {
+    Unlink(pTimer);
+  }
+  pTimer->Expiry = gGlobalSysTickCounter + (Ticks ? Ticks : 1);
+  Link(pTimer);
+  __set_PRIMASK(Mask);
+}
+
+void SCHEDULER_Cancel(SCHEDULER_Timer_t *pTimer) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  __disable_irq();
+  if (pTimer->ppPrev) {
+    Unlink(pTimer);
+  }
+  __set_PRIMASK(Mask);
+}
+
+bool SCHEDULER_IsArmed(const SCHEDULER_Timer_t *pTimer) {
+  return pTimer->ppPrev != NULL;
+}
+
+void SCHEDULER_SetSubtick(void (*pHandler)(void), uint16_t PeriodUs) {
+  const uint32_t Mask = __get_PRIMASK();
+
+  if (PeriodUs < SCHEDULER_SUBTICK_MIN_US) {
+    PeriodUs = SCHEDULER_SUBTICK_MIN_US;
+  } else if (PeriodUs > 10000) {
+    PeriodUs = 10000;
+  }
+
+  __disable_irq();
+  gSubtickHandler = pHandler;
+  gSubtickPeriodUs = PeriodUs;
+  gSubtickUs = 0;
+  SYSTICK_SetPeriodUs(pHandler ? PeriodUs : 10000);
+  __set_PRIMASK(Mask);
+}
 
 void SystickHandler(void);
 
 void SystickHandler(void) {
+  const uint32_t Start = SysTick->VAL;
+  uint32_t Cycles;
+
+  if (gSubtickHandler) {
+    gSubtickHandler();
+    gSubtickUs += gSubtickPeriodUs;
+    if (gSubtickUs < 10000) {
+      return;
+    }
+    gSubtickUs -= 10000;
+  }
+
   gGlobalSysTickCounter++;
   gNextTimeslice = true;
-  if ((gGlobalSysTickCounter % 50) == 0) {
-    gNextTimeslice500ms = true;
-    DECREMENT_AND_TRIGGER(gTxTimerCountdown, gTxTimeoutReached);
-  }
-  if ((gGlobalSysTickCounter & 3) == 0) {
-    gNextTimeslice40ms = true;
-  }
-  if (gSystickCountdown2) {
-    gSystickCountdown2--;
-  }
-  if (gFoundCDCSSCountdown) {
-    gFoundCDCSSCountdown--;
+
+  if ((gGlobalSysTickCounter & (WHEEL_SPAN(1) - 1)) == 0) {
+    Cascade(2);
   }
-  if (gFoundCTCSSCountdown) {
-    gFoundCTCSSCountdown--;
+  if ((gGlobalSysTickCounter & (WHEEL_SPAN(0) - 1)) == 0) {
+    Cascade(1);
   }
+  Expire();
+
+  // Countdowns that only run in some states stay here.
   if (gCurrentFunction == FUNCTION_FOREGROUND) {
     DECREMENT_AND_TRIGGER(gBatterySaveCountdown, gSchedulePowerSave);
   }
@@ -80,8 +234,6 @@ void SystickHandler(void) {
     }
   }
 
-  DECREMENT_AND_TRIGGER(gTailNoteEliminationCountdown, gFlagTteComplete);
-
 #if defined(ENABLE_FMRADIO)
   if (gFM_ScanState != FM_SCAN_OFF && gCurrentFunction != FUNCTION_MONITOR) {
     if (gCurrentFunction != FUNCTION_TRANSMIT &&
@@ -90,7 +242,11 @@ void SystickHandler(void) {
     }
   }
 #endif
-  if (gVoxStopCountdown) {
-    gVoxStopCountdown--;
+
+  // VAL counts down from LOAD, which it was reloaded with on entry.
+  Cycles = Start - SysTick->VAL;
+  gSystickIsrCycles = Cycles;
+  if (Cycles > gSystickIsrCyclesMax) {
+    gSystickIsrCyclesMax = Cycles;
   }
 }
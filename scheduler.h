@@ -0,0 +1,53 @@
+/* Copyright 2023 Dual Tachyon
+ * https://github.com/DualTachyon
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Software timer driven by the 10ms SysTick. On expiry the scheduler sets
+// *pFlag and/or calls pCallback from the interrupt, then re-arms the timer
+// if it has a Period. Arming and cancelling are O(1), and the tick only
+// touches the wheel slot that is due.
+typedef struct SCHEDULER_Timer_t {
+  struct SCHEDULER_Timer_t *pNext;
+  struct SCHEDULER_Timer_t **ppPrev; // NULL while not armed
+  uint32_t Expiry;                   // gGlobalSysTickCounter value
+  uint16_t Period;                   // ticks, 0 for one-shot
+  volatile bool *pFlag;
+  void (*pCallback)(void);
+} SCHEDULER_Timer_t;
+
+// SysTick handler time, in core cycles
+extern uint32_t gSystickIsrCycles;
+extern uint32_t gSystickIsrCyclesMax;
+
+void SCHEDULER_Init(void);
+void SCHEDULER_Arm(SCHEDULER_Timer_t *pTimer, uint32_t Ticks);
+void SCHEDULER_Cancel(SCHEDULER_Timer_t *pTimer);
+bool SCHEDULER_IsArmed(const SCHEDULER_Timer_t *pTimer);
+// Shortest subtick period, so that the interrupt leaves the main loop time
+#define SCHEDULER_SUBTICK_MIN_US 100U
+
+// Speeds SysTick up to call pHandler every PeriodUs from the interrupt. The
+// 10ms tick work still runs once 10ms worth of subticks have passed. NULL
+// goes back to the plain 10ms tick. PeriodUs is kept within
+// SCHEDULER_SUBTICK_MIN_US..10000.
+void SCHEDULER_SetSubtick(void (*pHandler)(void), uint16_t PeriodUs);
+
+#endif
@@ -27,6 +27,133 @@
 
 EEPROM_Config_t gEeprom;
 
+// Every MR channel record packed to 6 bytes: frequency, step, mode, offset
+// direction and the flag bytes. A record that has tones, an offset or a
+// scrambler does not fit and is read from the EEPROM each time. Entries are
+// filled on the first read of each channel.
+typedef struct {
+  uint32_t Frequency : 27;
+  uint32_t Step : 4;
+  uint32_t Plain : 1; // the record is rebuilt from this entry
+  uint8_t Flags : 5;
+  uint8_t Mode : 3;
+  uint8_t OffsetDir : 2;
+  uint8_t Dtmf : 3;
+  uint8_t Loaded : 1;
+  uint8_t NoFlags : 1; // flag byte is 0xFF
+  uint8_t NoDtmf : 1;  // DTMF byte is 0xFF
+} __attribute__((packed)) ChannelIndex_t;
+
+static ChannelIndex_t gChannelIndex[MR_CHANNEL_LAST + 1];
+
+// Most recently used MR channel names, front first, for the scanlist view
+// and the channel name shown on each memory scan step.
+#define CHANNEL_CACHE_SIZE 12
+
+typedef struct {
+  uint8_t Channel;
+  char Name[10];
+} ChannelCacheEntry_t;
+
+static ChannelCacheEntry_t gChannelCache[CHANNEL_CACHE_SIZE];
+static uint8_t gChannelCacheCount;
+
+uint16_t gChannelCacheHits;
+uint16_t gChannelCacheMisses;
+
+static void BuildRecord(const ChannelIndex_t *pIndex, uint8_t *pRecord) {
+  const uint32_t Frequency = pIndex->Frequency;
+
+  memset(pRecord, 0, 16);
+  memcpy(pRecord, &Frequency, sizeof(Frequency));
+  pRecord[11] = (pIndex->Mode << 4) | pIndex->OffsetDir;
+  pRecord[12] = pIndex->NoFlags ? 0xFF : pIndex->Flags;
+  pRecord[13] = pIndex->NoDtmf ? 0xFF : pIndex->Dtmf;
+  pRecord[14] = pIndex->Step;
+}
+
+static void IndexRecord(ChannelIndex_t *pIndex, const uint8_t *pRecord) {
+  uint8_t Rebuilt[16];
+  uint32_t Frequency;
+
+  memcpy(&Frequency, pRecord, sizeof(Frequency));
+  pIndex->Frequency = Frequency;
+  pIndex->Step = pRecord[14];
+  pIndex->Flags = pRecord[12];
+  pIndex->NoFlags = pRecord[12] == 0xFF;
+  pIndex->Mode = pRecord[11] >> 4;
+  pIndex->OffsetDir = pRecord[11];
+  pIndex->Dtmf = pRecord[13];
+  pIndex->NoDtmf = pRecord[13] == 0xFF;
+  pIndex->Loaded = true;
+
+  // whatever the fields above cannot hold makes the rebuilt record differ
+  BuildRecord(pIndex, Rebuilt);
+  pIndex->Plain = memcmp(Rebuilt, pRecord, sizeof(Rebuilt)) == 0;
+}
+
+static ChannelCacheEntry_t *GetCacheEntry(uint8_t Channel) {
+  ChannelCacheEntry_t Entry;
+  uint8_t i;
+
+  for (i = 0; i < gChannelCacheCount; i++) {
+    if (gChannelCache[i].Channel == Channel) {
+      break;
+    }
+  }
+
+  if (i == gChannelCacheCount) {
+    if (gChannelCacheCount < CHANNEL_CACHE_SIZE) {
+      gChannelCacheCount++;
+    } else {
+      i--;
+    }
+    gChannelCacheMisses++;
+    Entry.Channel = Channel;
+    EEPROM_ReadBuffer(0x0F50 + (Channel * 0x10), Entry.Name,
+                      sizeof(Entry.Name));
+  } else {
+    gChannelCacheHits++;
+    Entry = gChannelCache[i];
+  }
+
+  memmove(&gChannelCache[1], &gChannelCache[0], i * sizeof(Entry));
+  gChannelCache[0] = Entry;
+
+  return &gChannelCache[0];
+}
+
+void SETTINGS_InvalidateChannelCache(void) {
+  memset(gChannelIndex, 0, sizeof(gChannelIndex));
+  gChannelCacheCount = 0;
+}
+
+void SETTINGS_ReadChannel(uint8_t Channel, uint16_t Address, void *pBuffer,
+                          uint8_t Size) {
+  ChannelIndex_t *pIndex;
+  uint8_t Record[16];
+
+  if (!IS_MR_CHANNEL(Channel)) {
+    EEPROM_ReadBuffer(Address, pBuffer, Size);
+    return;
+  }
+
+  pIndex = &gChannelIndex[Channel];
+  if (pIndex->Plain) {
+    gChannelCacheHits++;
+    BuildRecord(pIndex, Record);
+  } else if (pIndex->Loaded) {
+    gChannelCacheMisses++;
+    EEPROM_ReadBuffer(Address, pBuffer, Size);
+    return;
+  } else {
+    gChannelCacheMisses++;
+    EEPROM_ReadBuffer(Channel * 16, Record, sizeof(Record));
+    IndexRecord(pIndex, Record);
+  }
+  memcpy(pBuffer, Record + (Address - Channel * 16), Size);
+}
+
 #if defined(ENABLE_FMRADIO)
 void SETTINGS_SaveFM(void) {
   uint8_t i;
@@ -46,10 +173,12 @@ void SETTINGS_SaveFM(void) {
   State.Frequency = gEeprom.FM_SelectedFrequency;
   State.IsChannelSelected = gEeprom.FM_IsMrMode;
 
+  EEPROM_BeginBatch();
   EEPROM_WriteBuffer(0x0E88, &State);
   for (i = 0; i < 5; i++) {
     EEPROM_WriteBuffer(0x0E40 + (i * 8), &gFM_Channels[i * 4]);
   }
+  EEPROM_EndBatch();
 }
 #endif
 
@@ -80,6 +209,8 @@ void SETTINGS_SaveSettings(void) {
   UART_LogSend("spub\r\n", 6);
 #endif
 
+  EEPROM_BeginBatch();
+
   State[0] = gEeprom.CHAN_1_CALL;
   State[1] = gEeprom.SQUELCH_LEVEL;
   State[2] = gEeprom.TX_TIMEOUT_TIMER;
@@ -173,6 +304,7 @@ void SETTINGS_SaveSettings(void) {
   State[6] = gSetting_ScrambleEnable;
 
   EEPROM_WriteBuffer(0x0F40, State);
+  EEPROM_EndBatch();
 }
 
 void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
@@ -181,6 +313,8 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
   UART_LogSend("schn\r\n", 6);
 #endif
 
+  SETTINGS_InvalidateChannelCache();
+
   if (IS_NOT_NOAA_CHANNEL(Channel)) {
     uint16_t OffsetMR;
     uint16_t OffsetVFO;
@@ -199,6 +333,8 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
       uint32_t State32[2];
       uint8_t State8[8];
 
+      EEPROM_BeginBatch();
+
       State32[0] = pVFO->ConfigRX.Frequency;
       State32[1] = pVFO->FREQUENCY_OF_DEVIATION;
 
@@ -234,6 +370,7 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
         }
 #endif
       }
+      EEPROM_EndBatch();
     }
   }
 }
@@ -270,6 +407,8 @@ void SETTINGS_UpdateChannel(uint8_t Channel, const VFO_Info_t *pVFO,
  * Get channel name to name[16]
  */
 void GetChannelName(uint8_t num, char *name) {
+  const ChannelCacheEntry_t *pEntry = GetCacheEntry(num);
+
   memset(name, 0, 16);
-  EEPROM_ReadBuffer(0x0F50 + (num * 0x10), name, 10);
+  memcpy(name, pEntry->Name, sizeof(pEntry->Name));
 }
@@ -194,4 +194,13 @@ void SETTINGS_UpdateChannel(uint8_t Channel, const VFO_Info_t *pVFO,
 
 void GetChannelName(uint8_t num, char *name);
 
+extern uint16_t gChannelCacheHits;
+extern uint16_t gChannelCacheMisses;
+
+// Reads Size bytes of a channel record at Address. MR channels are served
+// from a packed RAM index of all of them, VFO channels go straight to EEPROM.
+void SETTINGS_ReadChannel(uint8_t Channel, uint16_t Address, void *pBuffer,
+                          uint8_t Size);
+void SETTINGS_InvalidateChannelCache(void);
+
 #endif
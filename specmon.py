@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+
+import sys
+from time import time
+from libuvk5 import uvk5
+
+
+PORT = sys.argv[1] if len(sys.argv) > 1 else '/dev/ttyUSB0'
+
+BARS = ' .:-=+*#%@'
+
+with uvk5(PORT) as s:
+    s.connect()
+    print(s.spectrum_stream())
+    start = time()
+    frames = 0
+    lost = 0
+    last = None
+    while True:
+        sweep = s.spectrum_read()
+        if sweep is None:
+            continue
+        if last is not None:
+            lost += (sweep['sequence'] - last - 1) & 0xFFFF
+        last = sweep['sequence']
+        frames += 1
+        rssi = sweep['rssi']
+        lo = min(v for v in rssi if v) if any(rssi) else 0
+        hi = max(rssi)
+        cols = [max(rssi[i:i + len(rssi) // 64 or 1]) for i in range(0, len(rssi), len(rssi) // 64 or 1)]
+        line = ''.join(BARS[(v - lo) * (len(BARS) - 1) // max(hi - lo, 1)] if v else ' ' for v in cols)
+        rate = frames / (time() - start)
+        print('%9.5f MHz |%s| %5.1f sweeps/s, %d lost, %d bad' % (
+            sweep['fstart'] / 100000, line, rate, lost, s.spectrum_bad_frames))
@@ -22,6 +22,7 @@
 #include "../audio.h"
 #include "../driver/keyboard.h"
 #include "../driver/st7565.h"
+#include "../driver/systick.h"
 #include "../misc.h"
 #include "../settings.h"
 #include "helper.h"
@@ -58,10 +59,16 @@ void UI_DisplayLock(void) {
 
   while (1) {
     while (!gNextTimeslice) {
+      __disable_irq();
+      if (!gNextTimeslice) {
+        SYSTICK_Sleep();
+      }
+      __enable_irq();
     }
     // TODO: Original code doesn't do the below, but is needed for proper key
     // debounce.
     gNextTimeslice = false;
+    AUDIO_Update();
     Key = KEYBOARD_Poll();
     if (gKeyReading0 == Key) {
       gDebounceCounter++;
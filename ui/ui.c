@@ -22,6 +22,7 @@
 #endif
 #include "../app/scanner.h"
 #include "../misc.h"
+#include "../radio.h"
 #if defined(ENABLE_AIRCOPY)
 #include "aircopy.h"
 #endif
@@ -99,6 +100,11 @@ void GUI_SelectNextDisplay(GUI_DisplayType_t Display) {
       gInputBoxIndex = 0;
       gIsInSubMenu = false;
       gCssScanMode = CSS_SCAN_MODE_OFF;
+#ifdef ENABLE_FASTER_CHANNEL_SCAN
+      if (gScanState != SCAN_OFF) {
+        RADIO_DropScanImages();
+      }
+#endif
       gScanState = SCAN_OFF;
 #if defined(ENABLE_FMRADIO)
       gFM_ScanState = FM_SCAN_OFF;